@@ -2,6 +2,13 @@
 #include <iomanip>
 #include <fstream>
 #include <random>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+
+#include <cryptopp/gcm.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/osrng.h>
 
 #include "aceEncrypt.h"
 #include "tool.h"
@@ -11,6 +18,23 @@ using namespace std;
 #define CBC 1
 #define AES256 1
 
+// 多密码格式
+static const char CONTAINER_MAGIC[4] = {'R', 'E', 'N', 'C'};
+static const unsigned char MODE_WRAPPED_KEYS = 0x02;
+static const unsigned char MODE_KEY_CHECK = 0x03;  // 单密码 + 密钥校验值
+static const size_t CONTAINER_HEADER_SIZE = 9;  // 魔数 + 模式 + 迭代次数
+static const size_t WRAP_SALT_SIZE = 16;
+static const size_t WRAP_NONCE_SIZE = 12;
+static const size_t WRAP_TAG_SIZE = 16;
+static const size_t CONTENT_KEY_SIZE = 32;
+static const size_t WRAP_SIZE = WRAP_SALT_SIZE + WRAP_NONCE_SIZE + CONTENT_KEY_SIZE + WRAP_TAG_SIZE;
+
+// 单密码格式的密钥校验值：HMAC-SHA256(派生密钥, 固定字符串) 的前8字节
+static const size_t KCV_SIZE = 8;
+static const size_t KEY_CHECK_HEADER_SIZE = CONTAINER_HEADER_SIZE + 16 + KCV_SIZE;  // 头部 + 盐值 + 校验值
+static const char KCV_LABEL[] = "reimu-kcv";
+static const unsigned char MODE_ASSET = 0x04;  // 分块加密的资源文件
+
 // 辅助函数：打印十六进制数据
 void printHex(const string& title, const uint8_t* data, size_t len) {
     cout << title << ": ";
@@ -34,14 +58,14 @@ std::string generateRandomIV() {
 }
 
 // 修正 deriveKeyFromPassword 函数
-std::string deriveKeyFromPassword(const std::string& password, std::string& salt_inout, unsigned int keyLength = 32) {
+std::string deriveKeyFromPassword(const std::string& password, std::string& salt_inout, unsigned int iterations) {
     if (salt_inout.empty()) {
         salt_inout = generateRandomIV();
         logToFile("生成随机盐值", LogLevel::DEBUG);
     }
     CryptoPP::PKCS5_PBKDF2_HMAC<CryptoPP::SHA256> pbkdf;
-    const unsigned int iterations = 10000;
-    CryptoPP::byte keyBuffer[64];
+    const unsigned int keyLength = 32;
+    CryptoPP::byte keyBuffer[keyLength];
     pbkdf.DeriveKey(
         keyBuffer, keyLength, 0, 
         (const CryptoPP::byte*)password.data(), password.size(),
@@ -52,42 +76,362 @@ std::string deriveKeyFromPassword(const std::string& password, std::string& salt
     return std::string(reinterpret_cast<char*>(keyBuffer), keyLength);
 }
 
-// 加密函数 - 使用密码派生密钥
-std::string AesEncrypt(const std::string& plaintext, const std::string& password) {
-    std::string ciphertext;
-    std::string salt = "";
-    std::string key = deriveKeyFromPassword(password, salt);
-    const std::string iv = generateRandomIV();
-    logToFile("开始加密数据", LogLevel::INFO);
+static std::string keyCacheId(const std::string& password, const std::string& salt, unsigned int iterations) {
+    std::string id;
+    id.reserve(password.size() + salt.size() + 5);
+    id.append((const char*)&iterations, sizeof(iterations));  // 迭代次数与盐值都是定长的，放在前面即可无歧义地拼接
+    id += salt;
+    id += '\0';
+    id += password;
+    return id;
+}
+
+bool KeyCache::find(const std::string& password, const std::string& salt, unsigned int iterations, std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++lookups_;
+    auto it = keys_.find(keyCacheId(password, salt, iterations));
+    if (it == keys_.end()) return false;
+    ++hits_;
+    key = it->second;
+    return true;
+}
+
+void KeyCache::insert(const std::string& password, const std::string& salt, unsigned int iterations,
+                      const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_.emplace(keyCacheId(password, salt, iterations), key);
+}
+
+// 每个线程一个密码学安全的随机数池
+static CryptoPP::AutoSeededRandomPool& threadRng() {
+    thread_local CryptoPP::AutoSeededRandomPool rng;
+    return rng;
+}
+
+// 密码学安全的随机字节
+// 加密器标识从1开始递增，不会因加密器析构后地址复用而与线程内缓存的密钥扩展混淆
+static uint64_t nextEncryptorId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+static std::string randomBytes(size_t size) {
+    std::string bytes(size, '\0');
+    threadRng().GenerateBlock((CryptoPP::byte*)&bytes[0], size);
+    return bytes;
+}
+
+// 按长度前缀依次写入各部分（避免拼接歧义）
+static void hmacUpdate(CryptoPP::HMAC<CryptoPP::SHA256>& hmac, std::string_view part) {
+    CryptoPP::byte length[4];
+    for (int i = 0; i < 4; ++i) length[i] = (CryptoPP::byte)((part.size() >> (24 - 8 * i)) & 0xFF);
+    hmac.Update(length, 4);
+    hmac.Update((const CryptoPP::byte*)part.data(), part.size());
+}
+
+// 派生密钥的校验值，解密时派生密钥后即可判断密码是否正确，无需解密正文
+static std::string keyCheckValue(const std::string& key) {
+    CryptoPP::HMAC<CryptoPP::SHA256> hmac((const CryptoPP::byte*)key.data(), key.size());
+    hmac.Update((const CryptoPP::byte*)KCV_LABEL, sizeof(KCV_LABEL) - 1);
+    CryptoPP::byte digest[CryptoPP::SHA256::DIGESTSIZE];
+    hmac.Final(digest);
+    return std::string((const char*)digest, KCV_SIZE);
+}
+
+// 容器头部：魔数 + 模式 + PBKDF2迭代次数（大端）
+static std::string containerHeader(unsigned char mode, unsigned int iterations) {
+    std::string header(CONTAINER_MAGIC, 4);
+    header.push_back((char)mode);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        header.push_back((char)((iterations >> shift) & 0xFF));
+    }
+    return header;
+}
+
+// 确定性模式的派生函数：HMAC-SHA256(密钥, 各部分)，截取前 size 字节
+static std::string keyedHash(const std::string& key, const std::vector<std::string_view>& parts, size_t size) {
+    CryptoPP::HMAC<CryptoPP::SHA256> hmac((const CryptoPP::byte*)key.data(), key.size());
+    for (const auto& part : parts) hmacUpdate(hmac, part);
+    CryptoPP::byte digest[CryptoPP::SHA256::DIGESTSIZE];
+    hmac.Final(digest);
+    return std::string((const char*)digest, std::min<size_t>(size, sizeof(digest)));
+}
+
+AesEncryptor::AesEncryptor(const std::vector<std::string>& passwords, const DeterministicKey& deterministic,
+                           unsigned int iterations, const std::string& siteSalt)
+    : id_(nextEncryptorId()) {
+    if (passwords.empty() || passwords.size() > 255) {
+        logToFile("密码数量必须为1~255个", LogLevel::ERROR);
+        return;
+    }
+    if (!validKdfIterations(iterations)) {
+        logToFile("PBKDF2迭代次数不合法: " + std::to_string(iterations), LogLevel::ERROR);
+        return;
+    }
+    const bool fixed = deterministic.enabled();
+    if (!siteSalt.empty() && siteSalt.size() != 16) {
+        logToFile("站点级盐值必须为16字节", LogLevel::ERROR);
+        return;
+    }
+    // 盐值：站点级盐值优先（全站同一密码派生出同一密钥）；确定性模式下由 (页面标识, 密码) 派生，
+    // 密码不变时派生出的密钥也不变
+    auto saltFor = [&](const std::string& password, size_t size) {
+        if (!siteSalt.empty()) return siteSalt;
+        return fixed ? keyedHash(deterministic.secret, {"salt", deterministic.scope, password}, size) : randomBytes(size);
+    };
     try {
-        CryptoPP::AES::Encryption aesEncryption((CryptoPP::byte*)key.c_str(), key.size());
-        CryptoPP::CBC_Mode_ExternalCipher::Encryption cbcEncryption(aesEncryption, (CryptoPP::byte*)iv.c_str());
-        CryptoPP::StringSource ss(plaintext, true, 
-            new CryptoPP::StreamTransformationFilter(cbcEncryption,
-                new CryptoPP::StringSink(ciphertext)
-            )
-        );
-        logToFile("加密成功", LogLevel::INFO);
+        if (passwords.size() == 1) {
+            // 单个密码：头部 + 盐值 + 密钥校验值，内容密钥由密码派生
+            std::string salt = saltFor(passwords[0], 16);
+            std::string key = deriveKeyFromPassword(passwords[0], salt, iterations);
+            header_ = containerHeader(MODE_KEY_CHECK, iterations);
+            header_ += salt;
+            header_ += keyCheckValue(key);
+            key_ = key;
+            if (fixed) ivKey_ = keyedHash(deterministic.secret, {"iv", deterministic.scope, header_}, 32);
+            valid_ = true;
+            return;
+        }
+
+        // 多个密码：随机内容密钥，为每个密码包装一份
+        header_ = containerHeader(MODE_WRAPPED_KEYS, iterations);
+        header_.push_back((char)passwords.size());
+
+        // 确定性模式下内容密钥由全部密码派生：增删任一密码都会更换内容密钥
+        std::string contentKey;
+        if (fixed) {
+            std::vector<std::string_view> parts{"content-key", deterministic.scope};
+            parts.insert(parts.end(), passwords.begin(), passwords.end());
+            contentKey = keyedHash(deterministic.secret, parts, CONTENT_KEY_SIZE);
+        } else {
+            contentKey = randomBytes(CONTENT_KEY_SIZE);
+        }
+        for (const auto& password : passwords) {
+            std::string salt = saltFor(password, WRAP_SALT_SIZE);
+            std::string kek = deriveKeyFromPassword(password, salt, iterations);
+            // nonce 依赖被包装的内容密钥，同一 KEK 与 nonce 只会用于同一个明文
+            std::string nonce = fixed ? keyedHash(deterministic.secret, {"wrap-nonce", contentKey, salt}, WRAP_NONCE_SIZE)
+                                      : randomBytes(WRAP_NONCE_SIZE);
+            CryptoPP::byte wrapped[CONTENT_KEY_SIZE];
+            CryptoPP::byte tag[WRAP_TAG_SIZE];
+            CryptoPP::GCM<CryptoPP::AES>::Encryption gcm;
+            gcm.SetKeyWithIV((const CryptoPP::byte*)kek.data(), kek.size(),
+                             (const CryptoPP::byte*)nonce.data(), nonce.size());
+            gcm.EncryptAndAuthenticate(wrapped, tag, WRAP_TAG_SIZE,
+                                       (const CryptoPP::byte*)nonce.data(), nonce.size(),
+                                       (const CryptoPP::byte*)header_.data(), CONTAINER_HEADER_SIZE,
+                                       (const CryptoPP::byte*)contentKey.data(), contentKey.size());
+            header_ += salt;
+            header_ += nonce;
+            header_.append((const char*)wrapped, CONTENT_KEY_SIZE);
+            header_.append((const char*)tag, WRAP_TAG_SIZE);
+        }
+        key_ = contentKey;
+        if (fixed) ivKey_ = keyedHash(deterministic.secret, {"iv", deterministic.scope, header_}, 32);
+        valid_ = true;
+        logToFile("多密码加密器已创建，包装数量: " + std::to_string(passwords.size()), LogLevel::DEBUG);
     }
     catch(const CryptoPP::Exception& e) {
         cerr << "加密错误" << endl;
         logToFile(std::string("加密错误: ") + e.what(), LogLevel::ERROR);
+        valid_ = false;
     }
-    return salt + iv + ciphertext;
+}
+
+CryptoPP::CBC_Mode_ExternalCipher::Encryption& AesEncryptor::startCbc(const void* plaintext, size_t size,
+                                                                      std::string_view label,
+                                                                      CryptoPP::byte* iv) const {
+    // CBC 模式对象与扩展后的密钥在线程内复用：同一加密器在同一线程中只扩展一次密钥，
+    // 切换到其他加密器时才重新扩展。AES 对象在非 AES-NI 路径上会写内部缓冲区，不能跨线程共享
+    thread_local CryptoPP::CBC_Mode_ExternalCipher::Encryption cbc;
+    thread_local CryptoPP::AES::Encryption aes;
+    thread_local uint64_t aesOwner = 0;
+    if (aesOwner != id_) {
+        aes.SetKey((const CryptoPP::byte*)key_.data(), key_.size());
+        aesOwner = id_;
+    }
+    if (ivKey_.empty()) {
+        threadRng().GenerateBlock(iv, 16);
+    } else {
+        // 确定性 IV：HMAC(由站点密钥、页面与密钥头部派生的 IV 密钥, 规则名 | 明文)
+        thread_local CryptoPP::HMAC<CryptoPP::SHA256> hmac;
+        hmac.SetKey((const CryptoPP::byte*)ivKey_.data(), ivKey_.size());
+        hmacUpdate(hmac, label);
+        hmacUpdate(hmac, std::string_view((const char*)plaintext, size));
+        hmac.TruncatedFinal(iv, 16);
+    }
+    cbc.SetCipherWithIV(aes, iv);
+    return cbc;
+}
+
+// PKCS#7 填充后的最后一块
+static void paddedLastBlock(const CryptoPP::byte* rest, size_t size, CryptoPP::byte* block) {
+    if (size > 0) std::memcpy(block, rest, size);
+    std::memset(block + size, (int)(16 - size), 16 - size);
+}
+
+size_t AesEncryptor::encryptTo(const void* plaintext, size_t size, char* out, std::string_view label) const {
+    std::memcpy(out, header_.data(), header_.size());
+    CryptoPP::byte* iv = (CryptoPP::byte*)out + header_.size();
+    auto& cbc = startCbc(plaintext, size, label, iv);
+
+    // 完整的块直接加密，最后不足一块的部分补齐 PKCS#7 填充
+    const CryptoPP::byte* src = (const CryptoPP::byte*)plaintext;
+    CryptoPP::byte* dst = iv + 16;
+    size_t full = size / 16 * 16;
+    if (full > 0) {
+        cbc.ProcessData(dst, src, full);
+    }
+    CryptoPP::byte last[16];
+    paddedLastBlock(src + full, size - full, last);
+    cbc.ProcessData(dst + full, last, 16);
+    return header_.size() + 16 + full + 16;
+}
+
+std::string AesEncryptor::encrypt(const std::string& plaintext) const {
+    if (!valid_) return "";
+    std::string out(encryptedSize(plaintext.size()), '\0');
+    encryptTo(plaintext.data(), plaintext.size(), &out[0]);
+    return out;
+}
+
+std::string AesEncryptor::encryptBase64(const void* plaintext, size_t size, std::string_view label) const {
+    if (!valid_) return "";
+    thread_local std::vector<CryptoPP::byte> tile(BASE64_TILE_SIZE + 48);
+
+    std::string out(base64EncodedSize(encryptedSize(size)), '\0');
+    char* cursor = &out[0];
+
+    // 头部与 IV：按3字节对齐的部分直接编码，剩下的 0~2 字节移到第一块密文之前
+    std::string prefix = header_;
+    prefix.resize(header_.size() + 16);
+    auto& cbc = startCbc(plaintext, size, label, (CryptoPP::byte*)&prefix[header_.size()]);
+    size_t aligned = prefix.size() / 3 * 3;
+    cursor = base64EncodeTo(prefix.data(), aligned, cursor);
+    size_t carry = prefix.size() - aligned;
+    std::memcpy(tile.data(), prefix.data() + aligned, carry);
+
+    const CryptoPP::byte* src = (const CryptoPP::byte*)plaintext;
+    size_t full = size / 16 * 16;
+    for (size_t offset = 0; offset < full;) {
+        size_t count = std::min(BASE64_TILE_SIZE, full - offset);
+        cbc.ProcessData(tile.data() + carry, src + offset, count);
+        offset += count;
+        // 不足3字节的剩余部分（进位）移到下一块开头
+        size_t available = carry + count;
+        size_t encode = available / 3 * 3;
+        cursor = base64EncodeTo(tile.data(), encode, cursor);
+        carry = available - encode;
+        std::memmove(tile.data(), tile.data() + encode, carry);
+    }
+    CryptoPP::byte last[16];
+    paddedLastBlock(src + full, size - full, last);
+    cbc.ProcessData(tile.data() + carry, last, 16);
+    base64EncodeTo(tile.data(), carry + 16, cursor);
+    return out;
+}
+
+AssetEncryptor::AssetEncryptor(uint32_t chunkSize, const std::string& secret, const std::string& digest)
+    : chunkSize_(chunkSize) {
+    std::string noncePrefix;
+    if (secret.empty()) {
+        key_ = randomBytes(KEY_SIZE);
+        noncePrefix = randomBytes(8);
+    } else {
+        // 相同内容与块大小得到相同的密钥与 nonce；二者之一不同时派生结果不同，不会重复使用 (密钥, nonce)
+        const std::string size = std::to_string(chunkSize);
+        key_ = keyedHash(secret, {"asset-key", size, digest}, KEY_SIZE);
+        noncePrefix = keyedHash(secret, {"asset-nonce", size, digest}, 8);
+    }
+    header_ = containerHeader(MODE_ASSET, chunkSize);
+    header_ += noncePrefix;
+}
+
+// 资源块的 nonce（nonce前缀 | 块序号）与附加数据（头部 | 是否最后一块）
+static void assetChunkParams(const std::string& header, uint32_t index, bool last, CryptoPP::byte* nonce,
+                             CryptoPP::byte* aad) {
+    const size_t headerSize = AssetEncryptor::HEADER_SIZE;
+    std::memcpy(nonce, header.data() + headerSize - 8, 8);
+    for (int i = 0; i < 4; ++i) nonce[8 + i] = (CryptoPP::byte)((index >> (24 - 8 * i)) & 0xFF);
+    std::memcpy(aad, header.data(), headerSize);
+    aad[headerSize] = last ? 1 : 0;
+}
+
+size_t AssetEncryptor::encryptChunk(const char* plaintext, size_t size, uint32_t index, bool last, char* out) const {
+    CryptoPP::byte nonce[12];
+    CryptoPP::byte aad[HEADER_SIZE + 1];
+    assetChunkParams(header_, index, last, nonce, aad);
+
+    CryptoPP::GCM<CryptoPP::AES>::Encryption gcm;
+    gcm.SetKeyWithIV((const CryptoPP::byte*)key_.data(), key_.size(), nonce, sizeof(nonce));
+    gcm.EncryptAndAuthenticate((CryptoPP::byte*)out, (CryptoPP::byte*)out + size, TAG_SIZE,
+                               nonce, sizeof(nonce), aad, sizeof(aad),
+                               (const CryptoPP::byte*)plaintext, size);
+    return size + TAG_SIZE;
+}
+
+AssetDecryptor::AssetDecryptor(const std::string& key, const std::string& header) : key_(key), header_(header) {
+    if (key_.size() != AssetEncryptor::KEY_SIZE || header_.size() != AssetEncryptor::HEADER_SIZE ||
+        std::memcmp(header_.data(), CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 ||
+        (unsigned char)header_[4] != MODE_ASSET) {
+        return;
+    }
+    for (int i = 0; i < 4; ++i) chunkSize_ = (chunkSize_ << 8) | (unsigned char)header_[5 + i];
+    valid_ = chunkSize_ > 0;
+}
+
+bool AssetDecryptor::decryptChunk(const char* ciphertext, size_t size, uint32_t index, bool last, char* out) const {
+    if (!valid_ || size < AssetEncryptor::TAG_SIZE) return false;
+    CryptoPP::byte nonce[12];
+    CryptoPP::byte aad[AssetEncryptor::HEADER_SIZE + 1];
+    assetChunkParams(header_, index, last, nonce, aad);
+
+    const size_t plainSize = size - AssetEncryptor::TAG_SIZE;
+    CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+    gcm.SetKeyWithIV((const CryptoPP::byte*)key_.data(), key_.size(), nonce, sizeof(nonce));
+    return gcm.DecryptAndVerify((CryptoPP::byte*)out, (const CryptoPP::byte*)ciphertext + plainSize,
+                                AssetEncryptor::TAG_SIZE, nonce, sizeof(nonce), aad, sizeof(aad),
+                                (const CryptoPP::byte*)ciphertext, plainSize);
+}
+
+std::string deriveSiteSalt(const std::string& secret) {
+    return keyedHash(secret, {"site-salt"}, 16);
+}
+
+size_t encryptedPayloadSize(size_t plaintextSize, size_t passwordCount) {
+    size_t header = passwordCount <= 1 ? KEY_CHECK_HEADER_SIZE : CONTAINER_HEADER_SIZE + 1 + passwordCount * WRAP_SIZE;
+    return header + 16 + (plaintextSize / 16 + 1) * 16;
+}
+
+// 加密函数 - 使用密码派生密钥
+std::string AesEncrypt(const std::string& plaintext, const std::string& password) {
+    return AesEncryptor({password}).encrypt(plaintext);
+}
+
+// 多密码加密：一次内容加密 + 每个密码一个内容密钥包装
+std::string AesEncryptMulti(const std::string& plaintext, const std::vector<std::string>& passwords) {
+    return AesEncryptor(passwords).encrypt(plaintext);
 }
 
 // 解密函数 - 使用密码和盐值派生密钥
 std::string AesDecrypt(const std::string& encrypted, const std::string& password) {
-    std::string decryptedtext;
-    if (encrypted.length() < 32) {
-        cerr << "错误: 加密数据长度不足" << endl;
-        logToFile("加密数据长度不足", LogLevel::ERROR);
-        return "";
+    return AesDecrypt(encrypted, password, nullptr);
+}
+
+// 按 (密码, 盐值, 迭代次数) 派生密钥，优先使用缓存
+static std::string cachedDeriveKey(const std::string& password, std::string salt, unsigned int iterations,
+                                   KeyCache* cache) {
+    std::string key;
+    if (!cache || !cache->find(password, salt, iterations, key)) {
+        key = deriveKeyFromPassword(password, salt, iterations);
+        if (cache) cache->insert(password, salt, iterations, key);
     }
-    std::string salt = encrypted.substr(0, 16);
-    const std::string iv = encrypted.substr(16, 16);
-    std::string ciphertext = encrypted.substr(32);
-    std::string key = deriveKeyFromPassword(password, salt);
+    return key;
+}
+
+// AES-256-CBC 解密（PKCS#7 填充），失败返回空字符串
+static std::string cbcDecrypt(const std::string& key, const std::string& iv, const std::string& ciphertext) {
+    std::string decryptedtext;
     logToFile("开始解密数据", LogLevel::INFO);
     try {
         CryptoPP::AES::Decryption aesDecryption((CryptoPP::byte*)key.c_str(), key.size());
@@ -104,4 +448,148 @@ std::string AesDecrypt(const std::string& encrypted, const std::string& password
         logToFile(std::string("解密错误: ") + e.what(), LogLevel::ERROR);
     }
     return decryptedtext;
-}
\ No newline at end of file
+}
+
+// 容器格式的模式字节，旧格式（盐值 + IV + 密文）返回 0
+static unsigned char containerMode(const std::string& encrypted) {
+    if (encrypted.size() < CONTAINER_HEADER_SIZE + 1 || encrypted.compare(0, 4, CONTAINER_MAGIC, 4) != 0) {
+        return 0;
+    }
+    unsigned char mode = (unsigned char)encrypted[4];
+    return mode == MODE_WRAPPED_KEYS || mode == MODE_KEY_CHECK ? mode : 0;
+}
+
+// 容器头部中的 PBKDF2 迭代次数，旧格式固定为默认值
+static unsigned int headerIterations(const std::string& encrypted) {
+    if (containerMode(encrypted) == 0) return DEFAULT_KDF_ITERATIONS;
+    unsigned int iterations = 0;
+    for (size_t i = 5; i < CONTAINER_HEADER_SIZE; ++i) {
+        iterations = (iterations << 8) | (unsigned char)encrypted[i];
+    }
+    return iterations;
+}
+
+// 密文（IV 之前）的起始位置，长度或迭代次数不合法时返回 0
+static size_t payloadDataOffset(const std::string& encrypted) {
+    // 迭代次数来自不可信的输入，超出范围时拒绝，避免构造的数据耗尽CPU
+    if (!validKdfIterations(headerIterations(encrypted))) return 0;
+    size_t offset;
+    switch (containerMode(encrypted)) {
+        case MODE_WRAPPED_KEYS:
+            offset = CONTAINER_HEADER_SIZE + 1 + (unsigned char)encrypted[CONTAINER_HEADER_SIZE] * WRAP_SIZE;
+            break;
+        case MODE_KEY_CHECK:
+            offset = KEY_CHECK_HEADER_SIZE;
+            break;
+        default:
+            offset = 16;
+            break;
+    }
+    // IV 与至少一个 PKCS#7 填充块
+    if (encrypted.size() < offset + 32 || (encrypted.size() - offset - 16) % 16 != 0) return 0;
+    return offset;
+}
+
+// 多密码格式解密：依次尝试每个包装，GCM 标签校验通过即为正确的密码
+static std::string decryptWrapped(const std::string& encrypted, const std::string& password, KeyCache* cache) {
+    size_t count = (unsigned char)encrypted[CONTAINER_HEADER_SIZE];
+    size_t dataOffset = CONTAINER_HEADER_SIZE + 1 + count * WRAP_SIZE;
+    if (encrypted.size() < dataOffset + 16) {
+        cerr << "错误: 加密数据长度不足" << endl;
+        logToFile("加密数据长度不足", LogLevel::ERROR);
+        return "";
+    }
+    const CryptoPP::byte* header = (const CryptoPP::byte*)encrypted.data();
+    for (size_t i = 0; i < count; ++i) {
+        const char* wrap = encrypted.data() + CONTAINER_HEADER_SIZE + 1 + i * WRAP_SIZE;
+        std::string salt(wrap, WRAP_SALT_SIZE);
+        std::string kek = cachedDeriveKey(password, salt, headerIterations(encrypted), cache);
+        const CryptoPP::byte* nonce = (const CryptoPP::byte*)wrap + WRAP_SALT_SIZE;
+        const CryptoPP::byte* wrapped = nonce + WRAP_NONCE_SIZE;
+        const CryptoPP::byte* tag = wrapped + CONTENT_KEY_SIZE;
+
+        CryptoPP::byte contentKey[CONTENT_KEY_SIZE];
+        CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+        gcm.SetKeyWithIV((const CryptoPP::byte*)kek.data(), kek.size(), nonce, WRAP_NONCE_SIZE);
+        if (gcm.DecryptAndVerify(contentKey, tag, WRAP_TAG_SIZE, nonce, WRAP_NONCE_SIZE,
+                                 header, CONTAINER_HEADER_SIZE, wrapped, CONTENT_KEY_SIZE)) {
+            std::string key((const char*)contentKey, CONTENT_KEY_SIZE);
+            std::string iv = encrypted.substr(dataOffset, 16);
+            return cbcDecrypt(key, iv, encrypted.substr(dataOffset + 16));
+        }
+    }
+    logToFile("密码与所有包装均不匹配", LogLevel::ERROR);
+    return "";
+}
+
+// 单密码 + 校验值格式：派生密钥后先比较校验值，密码错误时不解密正文
+static std::string decryptKeyChecked(const std::string& encrypted, const std::string& password, KeyCache* cache) {
+    if (encrypted.size() < KEY_CHECK_HEADER_SIZE + 16) {
+        cerr << "错误: 加密数据长度不足" << endl;
+        logToFile("加密数据长度不足", LogLevel::ERROR);
+        return "";
+    }
+    std::string key = cachedDeriveKey(password, encrypted.substr(CONTAINER_HEADER_SIZE, 16), headerIterations(encrypted),
+                                      cache);
+    if (keyCheckValue(key) != encrypted.substr(CONTAINER_HEADER_SIZE + 16, KCV_SIZE)) {
+        logToFile("密钥校验值不匹配，密码错误", LogLevel::ERROR);
+        return "";
+    }
+    return cbcDecrypt(key, encrypted.substr(KEY_CHECK_HEADER_SIZE, 16), encrypted.substr(KEY_CHECK_HEADER_SIZE + 16));
+}
+
+KeyCheck AesCheckKey(const std::string& encrypted, const std::string& password, KeyCache* cache) {
+    if (payloadDataOffset(encrypted) == 0) return KeyCheck::MALFORMED;
+    switch (containerMode(encrypted)) {
+        case MODE_KEY_CHECK: {
+            std::string key = cachedDeriveKey(password, encrypted.substr(CONTAINER_HEADER_SIZE, 16),
+                                              headerIterations(encrypted), cache);
+            return keyCheckValue(key) == encrypted.substr(CONTAINER_HEADER_SIZE + 16, KCV_SIZE) ? KeyCheck::OK
+                                                                                                : KeyCheck::WRONG_PASSWORD;
+        }
+        case MODE_WRAPPED_KEYS: {
+            size_t count = (unsigned char)encrypted[CONTAINER_HEADER_SIZE];
+            const CryptoPP::byte* header = (const CryptoPP::byte*)encrypted.data();
+            for (size_t i = 0; i < count; ++i) {
+                const char* wrap = encrypted.data() + CONTAINER_HEADER_SIZE + 1 + i * WRAP_SIZE;
+                std::string kek = cachedDeriveKey(password, std::string(wrap, WRAP_SALT_SIZE),
+                                                  headerIterations(encrypted), cache);
+                const CryptoPP::byte* nonce = (const CryptoPP::byte*)wrap + WRAP_SALT_SIZE;
+                CryptoPP::byte contentKey[CONTENT_KEY_SIZE];
+                CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+                gcm.SetKeyWithIV((const CryptoPP::byte*)kek.data(), kek.size(), nonce, WRAP_NONCE_SIZE);
+                if (gcm.DecryptAndVerify(contentKey, nonce + WRAP_NONCE_SIZE + CONTENT_KEY_SIZE, WRAP_TAG_SIZE,
+                                         nonce, WRAP_NONCE_SIZE, header, CONTAINER_HEADER_SIZE,
+                                         nonce + WRAP_NONCE_SIZE, CONTENT_KEY_SIZE)) {
+                    return KeyCheck::OK;
+                }
+            }
+            return KeyCheck::WRONG_PASSWORD;
+        }
+        default:
+            return KeyCheck::UNCHECKED;
+    }
+}
+
+std::string AesDecrypt(const std::string& encrypted, const std::string& password, KeyCache* cache) {
+    if (containerMode(encrypted) != 0 && payloadDataOffset(encrypted) == 0) {
+        cerr << "错误: 加密数据格式不合法" << endl;
+        logToFile("加密数据长度或PBKDF2迭代次数不合法", LogLevel::ERROR);
+        return "";
+    }
+    switch (containerMode(encrypted)) {
+        case MODE_WRAPPED_KEYS: return decryptWrapped(encrypted, password, cache);
+        case MODE_KEY_CHECK: return decryptKeyChecked(encrypted, password, cache);
+        default: break;
+    }
+    if (encrypted.length() < 32) {
+        cerr << "错误: 加密数据长度不足" << endl;
+        logToFile("加密数据长度不足", LogLevel::ERROR);
+        return "";
+    }
+    std::string salt = encrypted.substr(0, 16);
+    const std::string iv = encrypted.substr(16, 16);
+    std::string ciphertext = encrypted.substr(32);
+    std::string key = cachedDeriveKey(password, salt, DEFAULT_KDF_ITERATIONS, cache);
+    return cbcDecrypt(key, iv, ciphertext);
+}
@@ -1,7 +1,12 @@
 ﻿#pragma once
 
 #include <string>
+#include <string_view>
 #include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
@@ -12,7 +17,328 @@
 // 辅助函数：打印十六进制数据
 void printHex(const std::string& title, const uint8_t* data, size_t len);
 
+// PBKDF2 迭代次数：默认值（旧格式固定使用），以及配置与密文头部允许的范围
+constexpr unsigned int DEFAULT_KDF_ITERATIONS = 10000;
+constexpr unsigned int MIN_KDF_ITERATIONS = 1000;
+constexpr unsigned int MAX_KDF_ITERATIONS = 10000000;
+
+inline bool validKdfIterations(unsigned int iterations) {
+    return iterations >= MIN_KDF_ITERATIONS && iterations <= MAX_KDF_ITERATIONS;
+}
+
+/**
+ * PBKDF2-HMAC-SHA256 派生32字节密钥
+ * @param password 密码
+ * @param salt_inout 盐值，为空时生成随机盐值并写回
+ * @param iterations 迭代次数
+ * @return 派生的密钥
+ */
+std::string deriveKeyFromPassword(const std::string& password, std::string& salt_inout,
+                                  unsigned int iterations = DEFAULT_KDF_ITERATIONS);
+
+/**
+ * 单密码加密
+ *
+ * 输出格式："RENC" | 模式 0x03 | PBKDF2迭代次数(u32大端) | 盐值16
+ *   | 密钥校验值8（HMAC-SHA256(派生密钥, "reimu-kcv") 的前8字节） | IV16 | AES-256-CBC 密文
+ * 解密时派生密钥后比较校验值即可拒绝错误的密码，无需解密正文。
+ *
+ * @param plaintext 明文
+ * @param key 密码
+ * @return 二进制密文，失败返回空字符串
+ */
 std::string AesEncrypt(const std::string& plaintext, const std::string& key);
 
+/**
+ * 多密码加密：内容只用随机内容密钥加密一次，内容密钥再分别用每个密码包装
+ *
+ * 输出格式（多于一个密码时）：
+ *   "RENC" | 模式 0x02 | PBKDF2迭代次数(u32大端) | 包装数量(u8)
+ *   | 每个密码一个包装 [盐值16 | nonce12 | AES-256-GCM加密的内容密钥32 | 标签16]
+ *   | IV16 | AES-256-CBC 密文
+ * 包装的附加认证数据为前9字节头部。只有一个密码时输出与 AesEncrypt 相同的格式。
+ * GCM 标签同时起到密码校验的作用。
+ *
+ * @param plaintext 明文
+ * @param passwords 密码列表（1~255个，调用方负责去重）
+ * @return 二进制密文，失败返回空字符串
+ */
+std::string AesEncryptMulti(const std::string& plaintext, const std::vector<std::string>& passwords);
+
+/**
+ * 确定性加密的密钥材料（SIV 风格）
+ *
+ * 启用后盐值、内容密钥、密钥包装的 nonce 与每个块的 IV 都由站点密钥的
+ * HMAC-SHA256 派生，输入相同（站点密钥、页面标识、密码、规则名与明文）时输出的密文逐字节相同，
+ * 内容或密码变化时才会改变。相同明文的块会得到相同密文（与 SIV 一样会暴露"内容相同"）。
+ */
+struct DeterministicKey {
+    std::string secret;  ///< 站点密钥，为空时使用随机盐值与 IV
+    std::string scope;   ///< 页面标识（uniqueID），不同页面使用不同的盐值
+
+    bool enabled() const { return !secret.empty(); }
+};
+
+/**
+ * AesEncryptor：可复用的加密器
+ *
+ * 构造时完成密钥派生（PBKDF2）、密钥包装与 AES 密钥扩展，之后每次加密只生成新的 IV，
+ * 并把"头部 | IV | PKCS#7 填充的 CBC 密文"直接写入调用方提供的缓冲区，不产生堆分配。
+ * 密码相同的多个块可以共用一个加密器（相同盐值/内容密钥，各自随机 IV）。
+ *
+ * 头部：单个密码时为 AesEncrypt 格式的头部、盐值与密钥校验值；多个密码时为
+ * AesEncryptMulti 格式的头部与全部密钥包装。encryptTo 可以在多个线程中同时调用。
+ * 传入启用的 DeterministicKey 时输出格式不变，只是随机数改为确定性派生。
+ */
+class AesEncryptor {
+public:
+    /// encryptBase64 的分块大小：AES 块（16）与 base64 分组（3）的公倍数，约 32KB，加密后趁仍在缓存中立即编码
+    static constexpr size_t BASE64_TILE_SIZE = 48 * 683;
+
+    /**
+     * 构造函数
+     * @param passwords 密码列表（1~255个，调用方负责去重）
+     * @param deterministic 确定性加密的密钥材料，未启用时使用随机数
+     * @param iterations PBKDF2 迭代次数，写入头部供解密时读取
+     * @param siteSalt 站点级盐值（16字节），非空时所有 PBKDF2 都使用它而不是随机/按页面派生的盐值，
+     *                 同一密码在全站派生出同一密钥（见 deriveSiteSalt）
+     */
+    explicit AesEncryptor(const std::vector<std::string>& passwords,
+                          const DeterministicKey& deterministic = DeterministicKey(),
+                          unsigned int iterations = DEFAULT_KDF_ITERATIONS,
+                          const std::string& siteSalt = "");
+
+    /**
+     * 密钥派生是否成功，失败时不能用于加密
+     */
+    bool valid() const { return valid_; }
+
+    /**
+     * 加密结果的精确字节数
+     * @param plaintextSize 明文字节数
+     */
+    size_t encryptedSize(size_t plaintextSize) const {
+        return header_.size() + 16 + (plaintextSize / 16 + 1) * 16;
+    }
+
+    /**
+     * 加密到调用方提供的缓冲区
+     * @param plaintext 明文
+     * @param size 明文字节数
+     * @param out 输出缓冲区，至少 encryptedSize(size) 字节
+     * @param label 确定性模式下参与 IV 派生的标签（规则名），随机模式下忽略
+     * @return 写入的字节数
+     */
+    size_t encryptTo(const void* plaintext, size_t size, char* out, std::string_view label = {}) const;
+
+    /**
+     * 加密并返回新字符串（一次分配）
+     */
+    std::string encrypt(const std::string& plaintext) const;
+
+    /**
+     * 加密并直接输出 base64，结果与 base64Encode(encryptTo 的输出) 相同
+     *
+     * 明文按缓存大小的分块加密，每块加密后立即编码写入按精确大小一次分配的结果中，
+     * 不产生完整的二进制密文：每块明文只读取一次（确定性模式派生 IV 时再多读一次），
+     * 除明文外的峰值内存约为明文的 1.34 倍。
+     *
+     * @param plaintext 明文
+     * @param size 明文字节数
+     * @param label 确定性模式下参与 IV 派生的标签（规则名），随机模式下忽略
+     * @return base64 编码的密文
+     */
+    std::string encryptBase64(const void* plaintext, size_t size, std::string_view label = {}) const;
+
+private:
+    // 生成 IV（随机或确定性派生）并以之初始化当前线程的 CBC 加密对象
+    CryptoPP::CBC_Mode_ExternalCipher::Encryption& startCbc(const void* plaintext, size_t size,
+                                                            std::string_view label, CryptoPP::byte* iv) const;
+
+    std::string header_;              ///< 盐值，或多密码格式的头部与密钥包装
+    std::string ivKey_;               ///< 确定性模式下派生 IV 的 HMAC 密钥，为空时使用随机 IV
+    std::string key_;                 ///< 内容密钥原文，每个线程据此扩展自己的密钥（Crypto++ 的分组密码对象不能跨线程共享）
+    uint64_t id_ = 0;                 ///< 加密器标识，线程内缓存的密钥扩展据此判断是否仍然可用
+    bool valid_ = false;
+};
+
+/**
+ * AssetEncryptor：资源文件（图片、PDF、视频等）的分块加密
+ *
+ * 格式："RENC" | 0x04 | 块大小(u32) | nonce前缀(8) | 块...
+ * 每块为 AES-256-GCM 密文 | 16字节标签，nonce 为"nonce前缀 | 块序号(u32)"，附加数据为头部与
+ * "是否最后一块"标记（1字节），块不能被重排、截断或拼接。除最后一块外每块的明文都是块大小，
+ * 空文件为一个空的最后一块。每块独立加解密，文件大小不影响内存占用。
+ *
+ * 每个资源使用独立的密钥，不由密码派生：密钥只写在引用它的加密HTML块中，
+ * 知道页面密码的读者解密页面后才能得到资源的密钥。encryptChunk 可以在多个线程中同时调用。
+ */
+class AssetEncryptor {
+public:
+    static constexpr size_t HEADER_SIZE = 17;  ///< 魔数 + 模式 + 块大小 + nonce前缀
+    static constexpr size_t TAG_SIZE = 16;
+    static constexpr size_t KEY_SIZE = 32;     ///< AES-256 密钥
+
+    /**
+     * 构造函数
+     * @param chunkSize 每块的明文字节数
+     * @param secret 站点密钥，非空时密钥与 nonce 前缀由站点密钥、块大小与 digest 派生（内容相同的文件输出逐字节相同），
+     *               为空时使用随机数
+     * @param digest 文件内容的摘要（secret 非空时使用，内容不同的文件必须不同）
+     */
+    explicit AssetEncryptor(uint32_t chunkSize, const std::string& secret = "", const std::string& digest = "");
+
+    /**
+     * 资源密钥（KEY_SIZE 字节）
+     */
+    const std::string& key() const { return key_; }
+
+    /**
+     * 文件头部
+     */
+    const std::string& header() const { return header_; }
+
+    uint32_t chunkSize() const { return chunkSize_; }
+
+    /**
+     * 加密一块
+     * @param plaintext 明文
+     * @param size 明文字节数（最后一块以外必须等于块大小）
+     * @param index 块序号
+     * @param last 是否最后一块
+     * @param out 输出缓冲区，至少 size + TAG_SIZE 字节
+     * @return 写入的字节数
+     */
+    size_t encryptChunk(const char* plaintext, size_t size, uint32_t index, bool last, char* out) const;
+
+    /**
+     * 块数（空文件也有一块）
+     */
+    static uint64_t chunkCount(uint64_t plainSize, uint32_t chunkSize) {
+        return plainSize == 0 ? 1 : (plainSize + chunkSize - 1) / chunkSize;
+    }
+
+private:
+    std::string key_;
+    std::string header_;
+    uint32_t chunkSize_ = 0;
+};
+
+/**
+ * AssetDecryptor：AssetEncryptor 输出的逐块解密（--restore 还原资源文件）
+ */
+class AssetDecryptor {
+public:
+    /**
+     * 构造函数
+     * @param key 资源密钥（AssetEncryptor::KEY_SIZE 字节）
+     * @param header 加密文件开头的 AssetEncryptor::HEADER_SIZE 字节
+     */
+    AssetDecryptor(const std::string& key, const std::string& header);
+
+    /**
+     * 密钥长度与头部格式是否正确，不正确时不能用于解密
+     */
+    bool valid() const { return valid_; }
+
+    uint32_t chunkSize() const { return chunkSize_; }
+
+    /**
+     * 解密并校验一块
+     * @param ciphertext 密文块（含末尾的标签）
+     * @param size 密文块字节数，至少 TAG_SIZE
+     * @param index 块序号
+     * @param last 是否最后一块
+     * @param out 输出缓冲区，至少 size - TAG_SIZE 字节
+     * @return 标签校验通过时返回 true（密钥错误、数据被篡改、重排或截断时返回 false）
+     */
+    bool decryptChunk(const char* ciphertext, size_t size, uint32_t index, bool last, char* out) const;
+
+private:
+    std::string key_;
+    std::string header_;
+    uint32_t chunkSize_ = 0;
+    bool valid_ = false;
+};
+
+/**
+ * 由站点密钥派生站点级 PBKDF2 盐值
+ * @param secret 站点密钥
+ * @return 16字节盐值
+ */
+std::string deriveSiteSalt(const std::string& secret);
+
+/**
+ * 不派生密钥，按密码数计算 AesEncryptor 加密结果的字节数（用于 --plan 估算）
+ * @param plaintextSize 明文字节数
+ * @param passwordCount 密码数（1~255）
+ * @return 与 AesEncryptor::encryptedSize 相同的字节数
+ */
+size_t encryptedPayloadSize(size_t plaintextSize, size_t passwordCount);
+
+/**
+ * KeyCache：PBKDF2 派生密钥缓存，按 (密码, 盐值, 迭代次数) 缓存派生结果
+ *
+ * 线程安全，可在多个解密任务间共享；派生计算在锁外进行。
+ */
+class KeyCache {
+public:
+    /**
+     * 查找缓存的密钥
+     * @return 是否命中
+     */
+    bool find(const std::string& password, const std::string& salt, unsigned int iterations, std::string& key);
+
+    /**
+     * 写入派生结果
+     */
+    void insert(const std::string& password, const std::string& salt, unsigned int iterations, const std::string& key);
+
+    /**
+     * 命中次数与查询次数，用于统计输出
+     */
+    size_t hits() const { std::lock_guard<std::mutex> lock(mutex_); return hits_; }
+    size_t lookups() const { std::lock_guard<std::mutex> lock(mutex_); return lookups_; }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::string> keys_;
+    size_t hits_ = 0;
+    size_t lookups_ = 0;
+};
+
 // AES解密函数 - 使用Crypto++
-std::string AesDecrypt(const std::string& ciphertext, const std::string& key);
\ No newline at end of file
+std::string AesDecrypt(const std::string& ciphertext, const std::string& key);
+
+/**
+ * 快速密码检查的结果
+ */
+enum class KeyCheck {
+    OK,              ///< 密码正确
+    WRONG_PASSWORD,  ///< 密钥校验值或所有包装都不匹配
+    MALFORMED,       ///< 长度或格式不合法
+    UNCHECKED,       ///< 旧格式（盐值 + IV + 密文）没有校验值，只能解密后判断
+};
+
+/**
+ * 只派生密钥并比较密钥校验值（多密码格式为校验 GCM 包装），不解密正文
+ *
+ * @param ciphertext 加密数据（任一支持的格式）
+ * @param key 密码
+ * @param cache 派生密钥缓存，为 nullptr 时不缓存
+ * @return 检查结果
+ */
+KeyCheck AesCheckKey(const std::string& ciphertext, const std::string& key, KeyCache* cache);
+
+/**
+ * AES解密函数，使用共享的派生密钥缓存
+ *
+ * 同时支持 AesEncrypt 的格式（先比较密钥校验值）、AesEncryptMulti 的多密码格式
+ * （依次尝试每个包装）以及旧的 salt + iv + 密文格式。
+ *
+ * @param ciphertext 加密数据
+ * @param key 密码
+ * @param cache 派生密钥缓存，为 nullptr 时不缓存
+ * @return 明文，失败返回空字符串
+ */
+std::string AesDecrypt(const std::string& ciphertext, const std::string& key, KeyCache* cache);
\ No newline at end of file
@@ -0,0 +1,149 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "articleShard.h"
+#include "tool.h"
+
+using namespace std;
+
+bool parseShardSpec(const std::string& value, ShardSpec& spec) {
+    size_t slash = value.find('/');
+    if (slash == std::string::npos) return false;
+    try {
+        size_t used = 0;
+        std::string indexStr = value.substr(0, slash);
+        std::string countStr = value.substr(slash + 1);
+        spec.index = std::stoul(indexStr, &used);
+        if (used != indexStr.size()) return false;
+        spec.count = std::stoul(countStr, &used);
+        if (used != countStr.size()) return false;
+    } catch (...) {
+        return false;
+    }
+    return spec.count > 0 && spec.index < spec.count;
+}
+
+uint64_t stableHash(const std::string& str) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : str) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    // FNV-1a 的低位混合较差，取模前再做一次 64 位终混合（MurmurHash3 fmix64）
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// 文章的分片键：优先使用 uniqueID
+static const std::string& shardKey(const ArticleItem& article) {
+    return article.uniqueID.empty() ? article.filePath : article.uniqueID;
+}
+
+std::vector<ArticleItem> selectShard(const std::vector<ArticleItem>& articles,
+                                     const ShardSpec& spec,
+                                     const fs::path& rootDir) {
+    if (!spec.enabled()) return articles;
+
+    std::vector<size_t> owner(articles.size());
+    if (!spec.balanceBySize) {
+        for (size_t i = 0; i < articles.size(); ++i) {
+            owner[i] = stableHash(shardKey(articles[i])) % spec.count;
+        }
+    } else {
+        // 读取文件大小（缺失的文件按0处理），按大小降序、键哈希与键升序排列，保证各节点顺序一致
+        std::vector<uintmax_t> sizes(articles.size(), 0);
+        for (size_t i = 0; i < articles.size(); ++i) {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(rootDir / fs::path(articles[i].filePath), ec);
+            sizes[i] = ec ? 0 : size;
+        }
+        std::vector<size_t> order(articles.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if (sizes[a] != sizes[b]) return sizes[a] > sizes[b];
+            uint64_t ha = stableHash(shardKey(articles[a]));
+            uint64_t hb = stableHash(shardKey(articles[b]));
+            if (ha != hb) return ha < hb;
+            if (shardKey(articles[a]) != shardKey(articles[b])) return shardKey(articles[a]) < shardKey(articles[b]);
+            return a < b;
+        });
+        // 贪心：每篇文章分给当前总大小最小的分片（相同时取编号小的）
+        std::vector<uintmax_t> load(spec.count, 0);
+        for (size_t i : order) {
+            size_t best = 0;
+            for (size_t s = 1; s < spec.count; ++s) {
+                if (load[s] < load[best]) best = s;
+            }
+            owner[i] = best;
+            load[best] += sizes[i] + 1;  // +1 使空文件也参与均衡
+        }
+        logToFile("分片按文件大小均衡，当前分片总大小: " + std::to_string(load[spec.index]) + " 字节", LogLevel::INFO);
+    }
+
+    std::vector<ArticleItem> selected;
+    for (size_t i = 0; i < articles.size(); ++i) {
+        if (owner[i] == spec.index) selected.push_back(articles[i]);
+    }
+    return selected;
+}
+
+// 本次运行的标识：配置文件内容与修改时间的哈希。重新生成配置后标识随之改变，
+// 之前运行中断留下的标记不会被当作本次已完成的分片
+static std::string shardRunId(const fs::path& jsonFilePath) {
+    std::ifstream in(jsonFilePath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::error_code ec;
+    auto mtime = fs::last_write_time(jsonFilePath, ec);
+    content += '|';
+    content += std::to_string(ec ? 0 : (long long)mtime.time_since_epoch().count());
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)stableHash(content));
+    return hex;
+}
+
+static fs::path shardMarkerPath(const fs::path& jsonFilePath, const std::string& runId, size_t index, size_t count) {
+    return fs::path(jsonFilePath.string() + ".shard-" + runId + "-" + std::to_string(index) + "-of-" +
+                    std::to_string(count) + ".done");
+}
+
+bool markShardDone(const fs::path& jsonFilePath, const ShardSpec& spec) {
+    const std::string runId = shardRunId(jsonFilePath);
+    fs::path marker = shardMarkerPath(jsonFilePath, runId, spec.index, spec.count);
+    // 独占创建（O_CREAT|O_EXCL）：标记已存在说明同一分片在本次运行中重复执行，不重复写入
+    if (FILE* file = std::fopen(marker.string().c_str(), "wx")) {
+        std::fclose(file);
+        logToFile("已写入分片完成标记: " + marker.string(), LogLevel::INFO);
+    } else if (fs::exists(marker)) {
+        logToFile("分片完成标记已存在: " + marker.string(), LogLevel::WARN);
+    } else {
+        cerr << "无法写入分片完成标记: " << marker.string() << endl;
+        logToFile("无法写入分片完成标记: " + marker.string(), LogLevel::ERROR);
+        return false;
+    }
+
+    for (size_t i = 0; i < spec.count; ++i) {
+        if (!fs::exists(shardMarkerPath(jsonFilePath, runId, i, spec.count))) return false;
+    }
+
+    // 多个分片可能同时看到全部标记：把第 0 个分片的标记改名为认领文件，改名是原子的，
+    // 只有一个分片能成功，其余分片因源文件已不存在而失败
+    fs::path claim = fs::path(jsonFilePath.string() + ".shard-" + runId + ".claim");
+    std::error_code ec;
+    fs::rename(shardMarkerPath(jsonFilePath, runId, 0, spec.count), claim, ec);
+    if (ec) {
+        logToFile("其他分片已认领配置文件的删除: " + jsonFilePath.string(), LogLevel::INFO);
+        return false;
+    }
+    for (size_t i = 1; i < spec.count; ++i) {
+        fs::remove(shardMarkerPath(jsonFilePath, runId, i, spec.count), ec);
+    }
+    fs::remove(claim, ec);
+    return true;
+}
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#include "encryptConfig.h"
+
+/**
+ * 分片参数：将 articles 划分为 count 份，只处理第 index 份（从0开始）
+ */
+struct ShardSpec {
+    size_t index = 0;
+    size_t count = 1;
+    bool balanceBySize = false;  ///< 按文件大小均衡分配，而不是按 uniqueID 哈希
+
+    bool enabled() const { return count > 1; }
+};
+
+/**
+ * 解析 "i/n" 形式的分片参数
+ * @return 格式正确且 0 <= i < n 时返回 true
+ */
+bool parseShardSpec(const std::string& value, ShardSpec& spec);
+
+/**
+ * 稳定的64位字符串哈希（FNV-1a + fmix64），不随平台、编译器或运行次数变化
+ */
+uint64_t stableHash(const std::string& str);
+
+/**
+ * 选出属于当前分片的文章
+ *
+ * 默认按 uniqueID（为空时用 filePath）的稳定哈希取模分配；
+ * balanceBySize 为 true 时先读取所有文件大小，按大小从大到小贪心分配到当前最轻的分片。
+ * 只要各节点看到的是同一份配置与同一棵文件树，分配结果就完全一致且互不相交。
+ *
+ * @param articles 全部文章
+ * @param spec 分片参数
+ * @param rootDir 网站根目录（用于读取文件大小）
+ * @return 当前分片的文章，保持原有顺序
+ */
+std::vector<ArticleItem> selectShard(const std::vector<ArticleItem>& articles,
+                                     const ShardSpec& spec,
+                                     const std::filesystem::path& rootDir);
+
+/**
+ * 记录当前分片已完成，并判断是否所有分片都已完成
+ *
+ * 在配置文件旁独占创建 <配置文件名>.shard-<运行标识>-<i>-of-<n>.done 标记，运行标识是
+ * 配置文件内容与修改时间的哈希，之前运行留下的标记不会被计入。所有标记都存在时，
+ * 通过把第 0 个标记原子地改名为认领文件保证只有一个分片返回 true，
+ * 由它删除这些标记并负责删除配置文件。
+ *
+ * @param jsonFilePath 配置文件路径
+ * @param spec 分片参数
+ * @return 当前分片是否为最后一个完成的分片
+ */
+bool markShardDone(const std::filesystem::path& jsonFilePath, const ShardSpec& spec);
@@ -0,0 +1,358 @@
+﻿#include "assetEncrypt.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <vector>
+#include "tool.h"
+
+using namespace std;
+
+// 扩展名 -> MIME类型，解密后生成的 Blob 需要正确的类型才能被 <img>/<video> 等使用
+static const std::map<std::string, std::string> MIME_TYPES = {
+    {"png", "image/png"},        {"jpg", "image/jpeg"},       {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},        {"webp", "image/webp"},      {"avif", "image/avif"},
+    {"svg", "image/svg+xml"},    {"ico", "image/x-icon"},     {"bmp", "image/bmp"},
+    {"mp4", "video/mp4"},        {"m4v", "video/mp4"},        {"webm", "video/webm"},
+    {"ogv", "video/ogg"},        {"mov", "video/quicktime"},  {"mp3", "audio/mpeg"},
+    {"m4a", "audio/mp4"},        {"aac", "audio/aac"},        {"wav", "audio/wav"},
+    {"flac", "audio/flac"},      {"ogg", "audio/ogg"},        {"oga", "audio/ogg"},
+    {"opus", "audio/ogg"},       {"vtt", "text/vtt"},         {"pdf", "application/pdf"},
+    {"zip", "application/zip"},  {"json", "application/json"}, {"txt", "text/plain"},
+};
+
+// 路径中的百分号解码（'+' 在路径中不表示空格，保持原样）
+static std::string decodePath(const std::string &path) {
+    std::string result;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '%' && i + 2 < path.size() && std::isxdigit((unsigned char)path[i + 1]) &&
+            std::isxdigit((unsigned char)path[i + 2])) {
+            result += (char)std::stoi(path.substr(i + 1, 2), nullptr, 16);
+            i += 2;
+        } else {
+            result += path[i];
+        }
+    }
+    return result;
+}
+
+// 小写的扩展名（不含点）
+static std::string lowerExtension(const fs::path &path) {
+    std::string extension = path.extension().string();
+    if (!extension.empty()) extension.erase(0, 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return (char)std::tolower(c); });
+    return extension;
+}
+
+// 文件内容的 SHA-256（流式读取）
+static std::optional<std::string> fileDigest(const fs::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return std::nullopt;
+    CryptoPP::SHA256 sha;
+    std::vector<char> buffer(64 * 1024);
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        sha.Update((const CryptoPP::byte *)buffer.data(), (size_t)in.gcount());
+    }
+    if (in.bad()) return std::nullopt;
+    std::string digest(CryptoPP::SHA256::DIGESTSIZE, '\0');
+    sha.Final((CryptoPP::byte *)digest.data());
+    return digest;
+}
+
+AssetRegistry::AssetRegistry(fs::path rootDir, AssetConfig config, std::string siteSecret)
+    : rootDir_(std::move(rootDir)), config_(std::move(config)), siteSecret_(std::move(siteSecret)) {
+    for (auto &extension : config_.extensions) {
+        if (!extension.empty() && extension[0] == '.') extension.erase(0, 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return (char)std::tolower(c); });
+    }
+}
+
+std::optional<fs::path> AssetRegistry::locate(const fs::path &pagePath, const std::string &url, std::string &path,
+                                              std::string &extension) const {
+    // 去掉查询串与片段
+    path = url.substr(0, url.find_first_of("?#"));
+    if (path.empty() || path.back() == '/') return std::nullopt;
+
+    // 相对于根目录的规范路径，不能离开根目录
+    fs::path relative = path[0] == '/' ? fs::path(decodePath(path.substr(1)))
+                                       : pagePath.parent_path() / fs::path(decodePath(path));
+    relative = relative.lexically_normal();
+    if (relative.empty() || relative.is_absolute() || relative.has_root_name() || *relative.begin() == "..") {
+        return std::nullopt;
+    }
+
+    extension = lowerExtension(relative);
+    if (extension.empty()) return std::nullopt;
+    if (config_.extensions.empty() ? (extension == "html" || extension == "htm")
+                                   : std::find(config_.extensions.begin(), config_.extensions.end(), extension) ==
+                                         config_.extensions.end()) {
+        return std::nullopt;
+    }
+    return relative;
+}
+
+std::string AssetRegistry::mimeType(const std::string &extension) {
+    auto mime = MIME_TYPES.find(extension);
+    return mime != MIME_TYPES.end() ? mime->second : "application/octet-stream";
+}
+
+std::optional<AssetRef> AssetRegistry::resolve(const fs::path &pagePath, const std::string &url, std::string *assetId) {
+    std::string path, extension;
+    std::optional<fs::path> located = locate(pagePath, url, path, extension);
+    if (!located) return std::nullopt;
+    const fs::path &relative = *located;
+
+    const std::string id = relative.generic_string();
+    if (assetId) *assetId = id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = assets_.find(id);
+        if (it != assets_.end()) return it->second.ref;
+    }
+
+    Asset asset;
+    asset.source = rootDir_ / relative;
+    std::error_code ec;
+    if (!fs::is_regular_file(asset.source, ec)) {
+        logToFile("资源不存在，保留原引用: " + asset.source.string(), LogLevel::WARN);
+        return std::nullopt;
+    }
+    // 确定性模式需要先读一遍文件求摘要（在锁外进行，同一文件被同时登记时结果相同）
+    if (siteSecret_.empty()) {
+        asset.encryptor = std::make_shared<const AssetEncryptor>(config_.chunkSize);
+    } else {
+        std::optional<std::string> digest = fileDigest(asset.source);
+        if (!digest) {
+            logToFile("读取资源失败，保留原引用: " + asset.source.string(), LogLevel::ERROR);
+            return std::nullopt;
+        }
+        asset.encryptor = std::make_shared<const AssetEncryptor>(config_.chunkSize, siteSecret_, *digest);
+    }
+    asset.ref.url = path + config_.suffix;
+    asset.ref.key = base64Encode(asset.encryptor->key());
+    asset.ref.type = mimeType(extension);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return assets_.emplace(id, std::move(asset)).first->second.ref;
+}
+
+std::optional<AssetRef> AssetRegistry::preview(const fs::path &pagePath, const std::string &url) const {
+    std::string path, extension;
+    std::optional<fs::path> relative = locate(pagePath, url, path, extension);
+    std::error_code ec;
+    if (!relative || !fs::is_regular_file(rootDir_ / *relative, ec)) return std::nullopt;
+    AssetRef ref;
+    ref.url = path + config_.suffix;
+    ref.key = base64Encode(std::string(AssetEncryptor::KEY_SIZE, '\0'));  // 与真实密钥等长的占位
+    ref.type = mimeType(extension);
+    return ref;
+}
+
+void AssetRegistry::commit(const std::vector<std::string> &ids) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &id : ids) {
+        auto it = assets_.find(id);
+        if (it != assets_.end()) it->second.committed = true;
+    }
+}
+
+size_t AssetRegistry::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::count_if(assets_.begin(), assets_.end(), [](const auto &entry) { return entry.second.committed; });
+}
+
+bool AssetRegistry::addRestore(const fs::path &pagePath, const AssetRef &ref) {
+    std::string url = ref.url;
+    const std::string &suffix = config_.suffix;
+    if (url.size() <= suffix.size() || url.compare(url.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return false;
+    }
+    url.resize(url.size() - suffix.size());
+    std::string path, extension;
+    std::optional<fs::path> relative = locate(pagePath, url, path, extension);
+    if (!relative) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    restores_.emplace(relative->generic_string(), std::make_pair(rootDir_ / *relative, ref.key));
+    return true;
+}
+
+size_t AssetRegistry::restoreCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return restores_.size();
+}
+
+size_t AssetRegistry::decryptAll(ThreadPool &pool) {
+    const std::string suffix = config_.suffix;
+    std::vector<std::future<std::string>> tasks;
+    std::vector<const std::pair<fs::path, std::string> *> order;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &entry : restores_) order.push_back(&entry.second);
+    }
+    size_t kept = 0;
+    for (const auto *restore : order) {
+        const fs::path &source = restore->first;
+        std::error_code ec;
+        if (fs::exists(source, ec)) {
+            // 加密时保留了原文件（keepOriginal）或已经恢复过
+            ++kept;
+            tasks.emplace_back();
+            continue;
+        }
+        tasks.push_back(pool.submit([restore, &suffix]() -> std::string {
+            const fs::path &source = restore->first;
+            const fs::path encrypted = source.string() + suffix;
+            const fs::path tempPath = source.string() + ".restore.tmp";
+            std::error_code ec;
+            uint64_t fileSize = fs::file_size(encrypted, ec);
+            if (ec) return "加密文件不存在";
+
+            std::ifstream in(encrypted, std::ios::binary);
+            if (!in.is_open()) return "无法打开加密文件";
+            std::string header(AssetEncryptor::HEADER_SIZE, '\0');
+            in.read(&header[0], header.size());
+            if ((size_t)in.gcount() != header.size()) return "加密文件格式不正确";
+            AssetDecryptor decryptor(base64Decode(restore->second), header);
+            if (!decryptor.valid()) return "加密文件格式或密钥不正确";
+
+            // 每块为 明文 + 标签，只有最后一块可以短于块大小（空文件为一个只有标签的块）
+            const uint64_t body = fileSize - AssetEncryptor::HEADER_SIZE;
+            const uint64_t fullChunk = (uint64_t)decryptor.chunkSize() + AssetEncryptor::TAG_SIZE;
+            const uint64_t rest = body % fullChunk;
+            if (body == 0 || (rest > 0 && rest < AssetEncryptor::TAG_SIZE)) return "加密文件长度不正确";
+            const uint64_t chunks = body / fullChunk + (rest > 0 ? 1 : 0);
+            if (chunks > UINT32_MAX) return "文件过大";
+
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return "无法创建临时文件";
+            std::vector<char> cipher(fullChunk);
+            std::vector<char> plain(decryptor.chunkSize());
+            std::string error;
+            for (uint64_t index = 0; index < chunks && error.empty(); ++index) {
+                bool last = index + 1 == chunks;
+                size_t size = (size_t)(last && rest > 0 ? rest : fullChunk);
+                in.read(cipher.data(), size);
+                if ((size_t)in.gcount() != size) {
+                    error = "读取加密文件失败";
+                } else if (!decryptor.decryptChunk(cipher.data(), size, (uint32_t)index, last, plain.data())) {
+                    error = "解密失败（密钥错误或文件已损坏）";
+                } else {
+                    out.write(plain.data(), size - AssetEncryptor::TAG_SIZE);
+                    if (out.fail()) error = "写出失败";
+                }
+            }
+            out.close();
+            if (error.empty() && out.fail()) error = "写出失败";
+            if (error.empty()) fs::rename(tempPath, source, ec);
+            if (!error.empty() || ec) {
+                fs::remove(tempPath, ec);
+                return error.empty() ? "替换原文件失败" : error;
+            }
+            logToFile("已恢复资源: " + encrypted.string() + " -> " + source.string(), LogLevel::INFO);
+            return "";
+        }));
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (!tasks[i].valid()) continue;
+        std::string error = pool.wait(tasks[i]);
+        if (error.empty()) continue;
+        ++failed;
+        cerr << "资源恢复失败: " << order[i]->first.string() << ": " << error << endl;
+        logToFile("资源恢复失败: " + order[i]->first.string() + ": " + error, LogLevel::ERROR);
+    }
+    cout << "资源恢复完成: 解密 " << tasks.size() - kept - failed << ", 原文件已存在 " << kept << ", 失败 " << failed
+         << endl;
+    logToFile("资源恢复完成: 解密 " + std::to_string(tasks.size() - kept - failed) + ", 原文件已存在 " +
+              std::to_string(kept) + ", 失败 " + std::to_string(failed), LogLevel::INFO);
+    return failed;
+}
+
+size_t AssetRegistry::encryptAll(ThreadPool &pool) {
+    const bool keepOriginal = config_.keepOriginal;
+    const std::string suffix = config_.suffix;
+
+    // 每个资源一个任务；每个任务只持有一块明文与一块密文。只加密已写出的页面引用的资源
+    std::vector<std::future<std::string>> tasks;
+    std::vector<const Asset *> order;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &entry : assets_) {
+            if (entry.second.committed) order.push_back(&entry.second);
+        }
+    }
+    for (const Asset *asset : order) {
+        tasks.push_back(pool.submit([asset, keepOriginal, &suffix]() -> std::string {
+            const AssetEncryptor &encryptor = *asset->encryptor;
+            const fs::path target = asset->source.string() + suffix;
+            const fs::path tempPath = target.string() + ".tmp";
+            std::error_code ec;
+            uint64_t plainSize = fs::file_size(asset->source, ec);
+            if (ec) return "无法读取文件大小";
+
+            std::ifstream in(asset->source, std::ios::binary);
+            if (!in.is_open()) return "无法打开文件";
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return "无法创建临时文件";
+
+            const uint32_t chunkSize = encryptor.chunkSize();
+            const uint64_t chunks = AssetEncryptor::chunkCount(plainSize, chunkSize);
+            if (chunks > UINT32_MAX) return "文件过大";
+            std::vector<char> plain(chunkSize);
+            std::vector<char> cipher(chunkSize + AssetEncryptor::TAG_SIZE);
+            out.write(encryptor.header().data(), encryptor.header().size());
+            bool ok = true;
+            for (uint64_t index = 0; index < chunks && ok; ++index) {
+                size_t size = (size_t)std::min<uint64_t>(chunkSize, plainSize - index * chunkSize);
+                in.read(plain.data(), size);
+                if ((size_t)in.gcount() != size) {
+                    ok = false;
+                    break;
+                }
+                size_t written = encryptor.encryptChunk(plain.data(), size, (uint32_t)index, index + 1 == chunks,
+                                                        cipher.data());
+                out.write(cipher.data(), written);
+                ok = !out.fail();
+            }
+            in.close();
+            out.close();
+            if (ok && out.fail()) ok = false;
+            if (ok) fs::rename(tempPath, target, ec);
+            if (!ok || ec) {
+                fs::remove(tempPath, ec);
+                return ok ? "替换加密文件失败" : "读写失败（文件在加密过程中被修改？）";
+            }
+
+            if (!keepOriginal) {
+                fs::remove(asset->source, ec);
+                if (ec) return "删除原文件失败: " + ec.message();
+                // 原文件的预压缩兄弟文件同样是明文
+                for (const char *compressed : {".gz", ".br"}) {
+                    fs::remove(asset->source.string() + compressed, ec);
+                }
+            }
+            logToFile("已加密资源: " + asset->source.string() + " -> " + target.string() + " (" +
+                      std::to_string(plainSize) + " 字节, " + std::to_string(chunks) + " 块)", LogLevel::INFO);
+            return "";
+        }));
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        std::string error = pool.wait(tasks[i]);
+        if (error.empty()) continue;
+        ++failed;
+        cerr << "资源加密失败: " << order[i]->source.string() << ": " << error << endl;
+        logToFile("资源加密失败: " + order[i]->source.string() + ": " + error, LogLevel::ERROR);
+    }
+    cout << "资源加密完成: " << tasks.size() - failed << "/" << tasks.size() << endl;
+    logToFile("资源加密完成: " + std::to_string(tasks.size() - failed) + "/" + std::to_string(tasks.size()),
+              LogLevel::INFO);
+    return failed;
+}
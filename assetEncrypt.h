@@ -0,0 +1,114 @@
+﻿#pragma once
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "aceEncrypt.h"
+#include "encryptConfig.h"
+#include "encryptCore.h"
+#include "threadPool.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * AssetRegistry：加密块中引用的本地资源（图片、PDF、视频等）
+ *
+ * 页面加密时通过 resolve 登记资源并取得加密后的URL与密钥（写入加密块，见 AssetResolver），
+ * 页面写出成功后通过 commit 提交它引用的资源，全部页面处理完后由 encryptAll 并行加密已提交的资源。
+ * 页面加密或写出失败时页面保持原样，它引用的资源不提交，因此不会被加密或删除。
+ * 同一文件被多个页面引用时只加密一次。
+ *
+ * 每个资源使用独立的随机密钥；配置了 siteSecret 时密钥由站点密钥与文件内容的 SHA-256 派生，
+ * 内容不变时输出逐字节相同。
+ */
+class AssetRegistry {
+public:
+    /**
+     * @param rootDir 站点根目录（页面与资源路径相对于它）
+     * @param config 资源加密配置
+     * @param siteSecret 站点密钥，为空时使用随机密钥
+     */
+    AssetRegistry(fs::path rootDir, AssetConfig config, std::string siteSecret);
+
+    /**
+     * 登记页面中引用的资源（线程安全）
+     *
+     * 以 '/' 开头的URL相对于站点根目录，否则相对于页面所在目录；查询串与片段被忽略，路径按百分号解码。
+     * 根目录以外的路径、不存在的文件与不在 extensions 中的扩展名返回 std::nullopt。
+     *
+     * @param pagePath 页面相对于根目录的路径
+     * @param url 属性中的原始URL
+     * @param assetId 非空时写入资源的标识，页面写出后传给 commit
+     * @return 加密后的资源
+     */
+    std::optional<AssetRef> resolve(const fs::path& pagePath, const std::string& url, std::string* assetId = nullptr);
+
+    /**
+     * 提交已写出的页面引用的资源（线程安全），只有提交过的资源会被 encryptAll 加密
+     * @param ids resolve 写入的资源标识
+     */
+    void commit(const std::vector<std::string>& ids);
+
+    /**
+     * 与 resolve 相同地判断URL是否会被改写，但不登记、不读取文件内容（--plan 使用）
+     * @return 与 resolve 的结果等长的引用，密钥为占位值
+     */
+    std::optional<AssetRef> preview(const fs::path& pagePath, const std::string& url) const;
+
+    /**
+     * 并行加密全部已提交的资源：每个资源一个任务，按块流式读写，写入临时文件后替换为 <文件名><suffix>，
+     * 之后删除原文件（keepOriginal 为 false 时）
+     *
+     * @return 失败的资源数
+     */
+    size_t encryptAll(ThreadPool& pool);
+
+    /**
+     * 已提交的资源数
+     */
+    size_t size();
+
+    /**
+     * 登记恢复后页面重新引用的加密资源（--restore，线程安全）
+     * @param pagePath 页面相对于根目录的路径
+     * @param ref restoreAssetReferences 返回的引用（加密文件的URL与密钥）
+     * @return URL 不指向根目录内的资源时返回 false
+     */
+    bool addRestore(const fs::path& pagePath, const AssetRef& ref);
+
+    /**
+     * 已登记的待恢复资源数
+     */
+    size_t restoreCount();
+
+    /**
+     * 并行把登记的加密资源解密回原文件名：原文件仍存在（keepOriginal）时跳过，
+     * 否则逐块解密并校验后写入临时文件再替换。加密文件保留，其他未恢复的页面可能仍引用它。
+     *
+     * @return 失败的资源数
+     */
+    size_t decryptAll(ThreadPool& pool);
+
+private:
+    // 检查URL并取得相对于根目录的规范路径；path 为去掉查询串与片段后的URL，extension 为小写扩展名
+    std::optional<fs::path> locate(const fs::path& pagePath, const std::string& url, std::string& path,
+                                   std::string& extension) const;
+    static std::string mimeType(const std::string& extension);
+
+    struct Asset {
+        fs::path source;  ///< 原文件
+        std::shared_ptr<const AssetEncryptor> encryptor;
+        AssetRef ref;
+        bool committed = false;  ///< 至少一个引用它的页面已写出
+    };
+
+    fs::path rootDir_;
+    AssetConfig config_;
+    std::string siteSecret_;
+    std::mutex mutex_;
+    std::map<std::string, Asset> assets_;  ///< 相对于根目录的规范路径 -> 资源
+    std::map<std::string, std::pair<fs::path, std::string>> restores_;  ///< 规范路径 -> (原文件, base64 密钥)
+};
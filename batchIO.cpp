@@ -0,0 +1,548 @@
+﻿#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <memory>
+
+#include "batchIO.h"
+#include "tool.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// 用到的 OPENAT/STATX（5.6）与 RENAMEAT（5.11）是枚举值，无法用 #ifdef 检查；
+// IORING_FEAT_EXT_ARG 与 RENAMEAT 同在 5.11 加入头文件，更旧的头文件只使用标准流
+#ifdef IORING_FEAT_EXT_ARG
+#define REIMU_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef REIMU_HAVE_IO_URING
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+using namespace std;
+
+bool parseIoBackend(const std::string& name, IoBackend& backend) {
+    if (name == "auto") {
+        backend = IoBackend::AUTO;
+    } else if (name == "stream") {
+        backend = IoBackend::STREAM;
+    } else if (name == "uring" || name == "io_uring") {
+        backend = IoBackend::IO_URING;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ioBackendName(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::AUTO:     return "auto";
+        case IoBackend::STREAM:   return "stream";
+        case IoBackend::IO_URING: return "io_uring";
+        default:                  return "auto";
+    }
+}
+
+// 标准流后端：逐个调用 readFileToString / writeStringToFile
+static std::vector<std::string> readFilesStream(const std::vector<std::string>& filePaths) {
+    std::vector<std::string> contents(filePaths.size());
+    for (size_t i = 0; i < filePaths.size(); ++i) {
+        contents[i] = readFileToString(filePaths[i]);
+    }
+    return contents;
+}
+
+static std::vector<bool> writeFilesStream(const std::vector<std::pair<std::string, std::string>>& files,
+                                          bool withBom) {
+    std::vector<bool> ok(files.size(), false);
+    for (size_t i = 0; i < files.size(); ++i) {
+        ok[i] = writeStringToFile(files[i].first, files[i].second, withBom);
+    }
+    return ok;
+}
+
+#ifdef REIMU_HAVE_IO_URING
+
+namespace {
+
+// 单次提交的最大请求数，也是环形队列的深度
+const unsigned RING_ENTRIES = 256;
+
+/**
+ * 直接基于内核接口的最小 io_uring 封装（不依赖 liburing）
+ *
+ * 只支持本文件需要的用法：填充一批 SQE，一次提交并等待全部完成。
+ */
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring() {
+        if (sqes_) munmap(sqes_, sqesSize_);
+        if (cqPtr_ && cqPtr_ != sqPtr_) munmap(cqPtr_, cqSize_);
+        if (sqPtr_) munmap(sqPtr_, sqSize_);
+        if (ringFd_ >= 0) close(ringFd_);
+    }
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool init(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd_ = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ringFd_ < 0) return false;
+
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+        }
+
+        sqPtr_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd_, IORING_OFF_SQ_RING);
+        if (sqPtr_ == MAP_FAILED) { sqPtr_ = nullptr; return false; }
+        if (singleMmap) {
+            cqPtr_ = sqPtr_;
+        } else {
+            cqPtr_ = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ringFd_, IORING_OFF_CQ_RING);
+            if (cqPtr_ == MAP_FAILED) { cqPtr_ = nullptr; return false; }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ringFd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sqPtr_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries_ = params.sq_entries;
+
+        char* cq = static_cast<char*>(cqPtr_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        localTail_ = *sqTail_;
+        return true;
+    }
+
+    unsigned capacity() const { return sqEntries_; }
+
+    /**
+     * 通过 IORING_REGISTER_PROBE 检查内核是否支持全部操作码
+     * 只能创建环形队列的旧内核（5.1 ~ 5.10）对不支持的操作逐个返回 -EINVAL，需要事先排除
+     */
+    bool supports(std::initializer_list<unsigned> opcodes) const {
+        const unsigned probeOps = 256;
+        std::vector<char> buffer(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PROBE, probe, probeOps) < 0) return false;
+        for (unsigned opcode : opcodes) {
+            if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    // 获取一个空闲 SQE，user_data 用于在完成时定位请求
+    io_uring_sqe* getSqe(uint64_t userData) {
+        unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (localTail_ - head >= sqEntries_) return nullptr;
+        unsigned index = localTail_ & sqMask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = userData;
+        sqArray_[index] = index;
+        ++localTail_;
+        ++pending_;
+        return sqe;
+    }
+
+    /**
+     * 提交已填充的全部 SQE 并等待它们全部完成
+     * @param onComplete 每个 CQE 的回调 (user_data, res)
+     * @return 是否成功（io_uring_enter 失败时返回 false）
+     */
+    template <typename F>
+    bool submitAndWaitAll(F&& onComplete) {
+        __atomic_store_n(sqTail_, localTail_, __ATOMIC_RELEASE);
+        unsigned toSubmit = pending_;
+        unsigned remaining = pending_;
+        pending_ = 0;
+        while (remaining > 0) {
+            int ret = (int)syscall(__NR_io_uring_enter, ringFd_, toSubmit, 1u,
+                                   IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            toSubmit -= std::min<unsigned>(toSubmit, (unsigned)ret);
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            while (head != tail && remaining > 0) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                onComplete(cqe.user_data, cqe.res);
+                ++head;
+                --remaining;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    int ringFd_ = -1;
+    void* sqPtr_ = nullptr;
+    void* cqPtr_ = nullptr;
+    size_t sqSize_ = 0, cqSize_ = 0, sqesSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0, sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned localTail_ = 0;
+    unsigned pending_ = 0;
+};
+
+/**
+ * 对 [begin, end) 范围内的每个下标提交一个请求并等待全部完成
+ * @param prepare 填充 SQE，返回 false 表示该下标无需提交
+ * @param complete 完成回调 (下标, res)
+ */
+template <typename P, typename C>
+bool runPhase(IoUring& ring, size_t begin, size_t end, P&& prepare, C&& complete) {
+    size_t i = begin;
+    while (i < end) {
+        while (i < end) {
+            io_uring_sqe* sqe = ring.getSqe(i);
+            if (!sqe) break;
+            if (!prepare(i, sqe)) {
+                // 不需要提交的请求改为 NOP，保持下标与 SQE 一一对应
+                sqe->opcode = IORING_OP_NOP;
+                sqe->user_data = UINT64_MAX;
+            }
+            ++i;
+        }
+        bool ok = ring.submitAndWaitAll([&](uint64_t index, int res) {
+            if (index != UINT64_MAX) complete((size_t)index, res);
+        });
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/**
+ * 当前线程复用的环形队列：每次批量读写不再重新 setup 与 mmap。
+ * 初始化失败时返回 nullptr；提交失败后环形队列的状态不再可信，由 discardThreadRing 丢弃，下次重新创建
+ */
+thread_local std::unique_ptr<IoUring> threadRingInstance;
+
+IoUring* threadRing() {
+    if (!threadRingInstance) {
+        auto ring = std::make_unique<IoUring>();
+        if (!ring->init(RING_ENTRIES)) return nullptr;
+        threadRingInstance = std::move(ring);
+    }
+    return threadRingInstance.get();
+}
+
+void discardThreadRing() {
+    threadRingInstance.reset();
+}
+
+} // namespace
+
+bool ioUringAvailable() {
+    static const bool available = [] {
+        IoUring ring;
+        if (!ring.init(8)) {
+            logToFile("io_uring不可用，回退到标准文件流", LogLevel::INFO);
+            return false;
+        }
+        if (!ring.supports({IORING_OP_NOP, IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITEV,
+                            IORING_OP_CLOSE, IORING_OP_RENAMEAT})) {
+            logToFile("内核的io_uring不支持所需的操作（需要 Linux 5.11 及以上），回退到标准文件流", LogLevel::INFO);
+            return false;
+        }
+        return true;
+    }();
+    return available;
+}
+
+// io_uring 读取：分阶段批量提交 openat+statx、read、close，失败的文件回退到标准流
+static std::vector<std::string> readFilesUring(const std::vector<std::string>& filePaths) {
+    std::vector<std::string> contents(filePaths.size());
+    std::vector<bool> fallback(filePaths.size(), false);
+    IoUring* ringPtr = threadRing();
+    if (!ringPtr) return readFilesStream(filePaths);
+    IoUring& ring = *ringPtr;
+
+    // 每轮处理 capacity/2 个文件（openat 与 statx 各占一个 SQE）
+    const size_t chunk = ring.capacity() / 2;
+    for (size_t base = 0; base < filePaths.size(); base += chunk) {
+        size_t end = std::min(filePaths.size(), base + chunk);
+        size_t n = end - base;
+        std::vector<int> fds(n, -1);
+        std::vector<struct statx> stats(n);
+        std::vector<bool> statOk(n, false);
+
+        // 阶段1：openat + statx
+        bool ok = runPhase(ring, 0, n * 2, [&](size_t k, io_uring_sqe* sqe) {
+            size_t f = k / 2;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)filePaths[base + f].c_str();
+            if (k % 2 == 0) {
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            } else {
+                sqe->opcode = IORING_OP_STATX;
+                sqe->len = STATX_SIZE;
+                sqe->off = (uint64_t)(uintptr_t)&stats[f];
+            }
+            return true;
+        }, [&](size_t k, int res) {
+            size_t f = k / 2;
+            if (k % 2 == 0) {
+                fds[f] = res;
+            } else {
+                statOk[f] = res == 0;
+            }
+        });
+
+        // 阶段2：按 statx 得到的大小一次读完整个文件
+        if (ok) {
+            ok = runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+                if (fds[f] < 0 || !statOk[f] || stats[f].stx_size == 0 ||
+                    stats[f].stx_size > UINT32_MAX) {
+                    return false;
+                }
+                contents[base + f].resize(stats[f].stx_size);
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fds[f];
+                sqe->addr = (uint64_t)(uintptr_t)&contents[base + f][0];
+                sqe->len = (uint32_t)stats[f].stx_size;
+                sqe->off = 0;
+                return true;
+            }, [&](size_t f, int res) {
+                if (res < 0 || (uint64_t)res != stats[f].stx_size) {
+                    contents[base + f].clear();
+                }
+            });
+        }
+
+        // 阶段3：关闭文件
+        runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+            if (fds[f] < 0) return false;
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[f];
+            return true;
+        }, [&](size_t, int) {});
+
+        if (!ok) {
+            // 提交失败：剩余的文件全部交给标准流，丢弃状态不确定的环形队列
+            discardThreadRing();
+            for (size_t i = base; i < filePaths.size(); ++i) fallback[i] = true;
+            break;
+        }
+        for (size_t f = 0; f < n; ++f) {
+            std::string& content = contents[base + f];
+            if (content.empty()) {
+                // 打开/读取失败或文件为空：交给标准流处理，保持原有的错误输出
+                fallback[base + f] = true;
+                continue;
+            }
+            // 移除UTF-8 BOM
+            if (content.size() >= 3 &&
+                static_cast<unsigned char>(content[0]) == 0xEF &&
+                static_cast<unsigned char>(content[1]) == 0xBB &&
+                static_cast<unsigned char>(content[2]) == 0xBF) {
+                content.erase(0, 3);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < filePaths.size(); ++i) {
+        if (fallback[i]) contents[i] = readFileToString(filePaths[i]);
+    }
+    return contents;
+}
+
+// io_uring 写入：分阶段批量提交 statx(目标文件)、openat(临时文件)、writev、close、renameat
+static std::vector<bool> writeFilesUring(const std::vector<std::pair<std::string, std::string>>& files,
+                                         bool withBom) {
+    static const unsigned char bom[] = {0xEF, 0xBB, 0xBF};
+    const size_t bomSize = withBom ? sizeof(bom) : 0;
+    std::vector<bool> written(files.size(), false);
+    IoUring* ringPtr = threadRing();
+    if (!ringPtr) return writeFilesStream(files, withBom);
+    IoUring& ring = *ringPtr;
+
+    const size_t chunk = ring.capacity();
+    for (size_t base = 0; base < files.size(); base += chunk) {
+        size_t end = std::min(files.size(), base + chunk);
+        size_t n = end - base;
+        std::vector<std::string> tmpPaths(n);
+        std::vector<int> fds(n, -1);
+        std::vector<iovec> iovs(n * 2);
+        std::vector<bool> ok(n, false);
+        std::vector<struct statx> targets(n);
+        std::vector<bool> targetExists(n, false);
+        std::vector<bool> prepared(n, true);
+        for (size_t f = 0; f < n; ++f) {
+            tmpPaths[f] = files[base + f].first + ".reimu.tmp";
+        }
+
+        // 阶段0：读取目标文件的权限与所有者，rename 覆盖后保持不变
+        bool ringOk = runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)files[base + f].first.c_str();
+            sqe->len = STATX_MODE | STATX_UID | STATX_GID;
+            sqe->off = (uint64_t)(uintptr_t)&targets[f];
+            return true;
+        }, [&](size_t f, int res) {
+            targetExists[f] = res == 0;
+        });
+
+        // 阶段1：创建临时文件（新文件使用 0644）
+        if (ringOk) {
+            ringOk = runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = (uint64_t)(uintptr_t)tmpPaths[f].c_str();
+                sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+                sqe->len = 0644;
+                return true;
+            }, [&](size_t f, int res) {
+                fds[f] = res;
+            });
+        }
+
+        // 临时文件设置为目标文件的权限（fchmod 不受 umask 影响）与所有者；
+        // 所有者无法保持时（非 root 覆盖他人的文件）不 rename，改由标准流原地覆盖
+        for (size_t f = 0; f < n; ++f) {
+            if (fds[f] < 0 || !targetExists[f]) continue;
+            const struct statx& target = targets[f];
+            if (fchmod(fds[f], target.stx_mode & 07777) != 0) {
+                prepared[f] = false;
+            } else if ((target.stx_uid != geteuid() || target.stx_gid != getegid()) &&
+                       fchown(fds[f], target.stx_uid, target.stx_gid) != 0) {
+                prepared[f] = false;
+            }
+        }
+
+        // 阶段2：writev 写入 BOM 与内容
+        if (ringOk) {
+            ringOk = runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+                if (fds[f] < 0 || !prepared[f]) return false;
+                const std::string& content = files[base + f].second;
+                iovs[f * 2] = { const_cast<unsigned char*>(bom), bomSize };
+                iovs[f * 2 + 1] = { const_cast<char*>(content.data()), content.size() };
+                sqe->opcode = IORING_OP_WRITEV;
+                sqe->fd = fds[f];
+                sqe->addr = (uint64_t)(uintptr_t)&iovs[f * 2];
+                sqe->len = 2;
+                sqe->off = 0;
+                return true;
+            }, [&](size_t f, int res) {
+                ok[f] = res >= 0 && (size_t)res == bomSize + files[base + f].second.size();
+            });
+        }
+
+        // 阶段3：关闭临时文件
+        runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+            if (fds[f] < 0) return false;
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[f];
+            return true;
+        }, [&](size_t f, int res) {
+            if (res < 0) ok[f] = false;
+        });
+
+        // 阶段4：rename 覆盖目标文件（不执行 fsync）
+        if (ringOk) {
+            ringOk = runPhase(ring, 0, n, [&](size_t f, io_uring_sqe* sqe) {
+                if (!ok[f]) return false;
+                sqe->opcode = IORING_OP_RENAMEAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = (uint64_t)(uintptr_t)tmpPaths[f].c_str();
+                sqe->len = (uint32_t)AT_FDCWD;
+                sqe->off = (uint64_t)(uintptr_t)files[base + f].first.c_str();
+                return true;
+            }, [&](size_t f, int res) {
+                written[base + f] = res == 0;
+            });
+        }
+
+        if (!ringOk) discardThreadRing();
+        for (size_t f = 0; f < n; ++f) {
+            if (written[base + f]) continue;
+            // 任一阶段失败：清理临时文件并回退到标准流写入
+            if (fds[f] >= 0) unlink(tmpPaths[f].c_str());
+            written[base + f] = writeStringToFile(files[base + f].first, files[base + f].second, withBom);
+        }
+        if (!ringOk) {
+            // 剩余的文件全部交给标准流
+            for (size_t i = end; i < files.size(); ++i) {
+                written[i] = writeStringToFile(files[i].first, files[i].second, withBom);
+            }
+            break;
+        }
+    }
+    return written;
+}
+
+#else
+
+bool ioUringAvailable() {
+    return false;
+}
+
+#endif // REIMU_HAVE_IO_URING
+
+IoBackend resolveIoBackend(IoBackend backend) {
+    if (backend == IoBackend::STREAM) return IoBackend::STREAM;
+    if (ioUringAvailable()) return IoBackend::IO_URING;
+    if (backend == IoBackend::IO_URING) {
+        cerr << "io_uring不可用，回退到标准文件流" << endl;
+    }
+    return IoBackend::STREAM;
+}
+
+std::vector<std::string> readFilesBatch(const std::vector<std::string>& filePaths, IoBackend backend) {
+#ifdef REIMU_HAVE_IO_URING
+    if (resolveIoBackend(backend) == IoBackend::IO_URING) {
+        return readFilesUring(filePaths);
+    }
+#else
+    (void)backend;
+#endif
+    return readFilesStream(filePaths);
+}
+
+std::vector<bool> writeFilesBatch(const std::vector<std::pair<std::string, std::string>>& files,
+                                  IoBackend backend, bool withBom) {
+#ifdef REIMU_HAVE_IO_URING
+    if (resolveIoBackend(backend) == IoBackend::IO_URING) {
+        return writeFilesUring(files, withBom);
+    }
+#else
+    (void)backend;
+#endif
+    return writeFilesStream(files, withBom);
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+/**
+ * 批量文件读写的后端
+ */
+enum class IoBackend {
+    AUTO,      ///< 自动选择：Linux 下 io_uring 可用时使用 io_uring，否则使用标准流
+    STREAM,    ///< ifstream/ofstream 逐个文件读写（原有路径）
+    IO_URING   ///< Linux io_uring 批量提交 open/read/write/rename/close
+};
+
+/**
+ * 从字符串解析后端名称（auto / stream / uring）
+ * @param name 后端名称
+ * @param backend 解析结果
+ * @return 名称是否合法
+ */
+bool parseIoBackend(const std::string& name, IoBackend& backend);
+
+/**
+ * 获取后端名称，用于日志输出
+ */
+const char* ioBackendName(IoBackend backend);
+
+/**
+ * 检测当前系统是否可以使用 io_uring（结果会被缓存）
+ *
+ * 除了能创建环形队列，内核还必须支持用到的全部操作码（OPENAT、STATX、RENAMEAT 等，Linux 5.11 及以上）；
+ * 编译时的 io_uring 头文件早于 5.11 时始终返回 false。
+ */
+bool ioUringAvailable();
+
+/**
+ * 将 AUTO 解析为实际使用的后端；请求 IO_URING 但不可用时回退到 STREAM
+ */
+IoBackend resolveIoBackend(IoBackend backend);
+
+/**
+ * 批量读取多个文件，语义与 readFileToString 相同（移除 UTF-8 BOM，失败返回空字符串）
+ *
+ * @param filePaths 文件路径列表
+ * @param backend 使用的后端
+ * @return 与 filePaths 一一对应的文件内容
+ */
+std::vector<std::string> readFilesBatch(const std::vector<std::string>& filePaths,
+                                        IoBackend backend = IoBackend::AUTO);
+
+/**
+ * 批量写入多个文件，语义与 writeStringToFile 相同（默认写入 UTF-8 BOM）
+ *
+ * io_uring 后端先写入同目录下的临时文件，再通过 rename 原子替换目标文件（不执行 fsync），
+ * 临时文件带有目标文件原有的权限与所有者。每个线程复用同一个环形队列。
+ *
+ * @param files (文件路径, 内容) 列表
+ * @param backend 使用的后端
+ * @param withBom 是否在每个文件开头写入 UTF-8 BOM
+ * @return 与 files 一一对应的写入结果
+ */
+std::vector<bool> writeFilesBatch(const std::vector<std::pair<std::string, std::string>>& files,
+                                  IoBackend backend = IoBackend::AUTO, bool withBom = true);
@@ -0,0 +1,126 @@
+﻿/**
+ * 加密块基准：比较 AesEncrypt 与 AesEncryptor::encryptTo 的耗时与堆分配次数，
+ * 以及"encryptTo + base64Encode"与分块融合的 encryptBase64
+ *
+ * 用法: reimuAesBench [块数=20000] [块大小KB=4]
+ * AesEncrypt 每块都会派生密钥并分配若干临时缓冲区；AesEncryptor 只派生一次密钥，
+ * encryptTo 直接写入预先分配好的缓冲区，稳定状态下每块不应发生堆分配。
+ * encryptBase64 每块只分配一次结果字符串，不产生完整的二进制密文。
+ * 计时之前先用确定性密钥在分块边界附近的长度上比较两条路径的输出，不一致时以退出码 1 结束。
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "aceEncrypt.h"
+#include "tool.h"
+
+using namespace std;
+
+// 统计全局 operator new 的调用次数
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static void report(const char* name, size_t blocks, size_t blockSize, double seconds, size_t allocations) {
+    double mb = blocks * blockSize / (1024.0 * 1024.0);
+    cout << name << ": " << seconds * 1000 << " ms (" << blocks / seconds << " 块/s, " << mb / seconds << " MB/s), "
+         << "堆分配 " << allocations << " 次 (" << static_cast<double>(allocations) / blocks << " 次/块)" << endl;
+}
+
+// 确定性模式下 IV 只由明文与标签决定，encryptBase64 必须与 base64Encode(encryptTo(...)) 逐字节相同
+static bool checkBase64(const AesEncryptor& encryptor, const char* name) {
+    const size_t tile = AesEncryptor::BASE64_TILE_SIZE;
+    const size_t sizes[] = {0, 1, 15, 16, 47, 48, tile - 1, tile, tile + 1, 2 * tile + 17};
+    for (size_t size : sizes) {
+        std::string plaintext(size, '\0');
+        for (size_t i = 0; i < size; ++i) plaintext[i] = (char)(i * 131 + 7);
+        std::string binary(encryptor.encryptedSize(size), '\0');
+        binary.resize(encryptor.encryptTo(plaintext.data(), size, &binary[0], "bench"));
+        std::string expected = base64Encode(binary);
+        std::string actual = encryptor.encryptBase64(plaintext.data(), size, "bench");
+        if (expected.empty() || actual != expected) {
+            cerr << "encryptBase64 结果不一致: " << name << ", 明文 " << size << " 字节" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t blocks = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t blockSize = (argc > 2 ? std::stoul(argv[2]) : 4) * 1024;
+    std::string plaintext(blockSize, 'x');
+    const std::string password = "bench-password";
+
+    // 正确性：单密码与多密码两种头部格式
+    DeterministicKey deterministic{"bench-secret", "bench-page"};
+    if (!checkBase64(AesEncryptor({password}, deterministic), "单密码") ||
+        !checkBase64(AesEncryptor({password, "bench-password-2"}, deterministic), "多密码")) {
+        return 1;
+    }
+    cout << "encryptBase64 与 base64Encode(encryptTo) 一致" << endl;
+
+    // AesEncrypt：每块派生一次密钥，返回新字符串。PBKDF2 很慢，只取少量块
+    size_t legacyBlocks = std::min<size_t>(blocks, 200);
+    size_t before = g_allocations.load();
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < legacyBlocks; ++i) {
+        std::string encrypted = AesEncrypt(plaintext, password);
+        if (encrypted.empty()) return 1;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    report("AesEncrypt", legacyBlocks, blockSize, std::chrono::duration<double>(t1 - t0).count(),
+           g_allocations.load() - before);
+
+    // AesEncryptor：密钥派生一次，密文写入复用的缓冲区
+    AesEncryptor encryptor({password});
+    if (!encryptor.valid()) return 1;
+    std::vector<char> buffer(encryptor.encryptedSize(plaintext.size()));
+    encryptor.encryptTo(plaintext.data(), plaintext.size(), buffer.data());  // 预热线程局部的CBC对象
+    before = g_allocations.load();
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < blocks; ++i) {
+        encryptor.encryptTo(plaintext.data(), plaintext.size(), buffer.data());
+    }
+    t1 = std::chrono::steady_clock::now();
+    report("AesEncryptor::encryptTo", blocks, blockSize, std::chrono::duration<double>(t1 - t0).count(),
+           g_allocations.load() - before);
+
+    // 加密后整体 base64：完整密文 + 编码结果两份缓冲区
+    size_t base64Blocks = std::max<size_t>(1, blocks / 4);
+    before = g_allocations.load();
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < base64Blocks; ++i) {
+        std::string ciphertext(encryptor.encryptedSize(plaintext.size()), '\0');
+        encryptor.encryptTo(plaintext.data(), plaintext.size(), &ciphertext[0]);
+        if (base64Encode(ciphertext).empty()) return 1;
+    }
+    t1 = std::chrono::steady_clock::now();
+    report("encryptTo + base64Encode", base64Blocks, blockSize, std::chrono::duration<double>(t1 - t0).count(),
+           g_allocations.load() - before);
+
+    // 分块加密并直接编码进精确大小的结果
+    encryptor.encryptBase64(plaintext.data(), plaintext.size());  // 预热线程局部的分块缓冲区
+    before = g_allocations.load();
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < base64Blocks; ++i) {
+        if (encryptor.encryptBase64(plaintext.data(), plaintext.size()).empty()) return 1;
+    }
+    t1 = std::chrono::steady_clock::now();
+    report("AesEncryptor::encryptBase64", base64Blocks, blockSize, std::chrono::duration<double>(t1 - t0).count(),
+           g_allocations.load() - before);
+    return 0;
+}
@@ -0,0 +1,175 @@
+﻿/**
+ * 端到端扩展性基准：在合成站点上以不同 --jobs 运行 reimuEncrypt
+ *
+ * 用法: reimuScaleBench [--binary 路径] [--jobs 1,2,4,8] [--repeat 3] [--dir 目录] [生成参数]
+ * 先生成一份站点模板，每次运行前复制一份全新的站点（加密会修改页面），
+ * 以 --keep-config 运行真实可执行文件，记录耗时与子进程峰值RSS，
+ * 输出页面/s、MB/s、峰值RSS以及相对单线程的加速比与每核效率。
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "siteGenerator.h"
+
+using namespace std;
+
+#ifdef _WIN32
+
+int main() {
+    cerr << "扩展性基准依赖 fork/wait4，暂不支持Windows" << endl;
+    return 1;
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef REIMU_ENCRYPT_BINARY
+#define REIMU_ENCRYPT_BINARY "./reimuEncrypt"
+#endif
+
+// 单次运行的结果
+struct RunResult {
+    bool ok = false;
+    double seconds = 0;
+    size_t peakRss = 0;  // 字节
+};
+
+// 在 siteDir 中运行一次 reimuEncrypt，日志写在站点目录下
+static RunResult runOnce(const std::string& binary, const fs::path& siteDir, size_t jobs) {
+    RunResult result;
+    std::string jobsArg = std::to_string(jobs);
+    // 子进程先切换到站点目录再执行，路径都须为绝对路径
+    std::string configArg = fs::absolute(siteDir / "encrypt.json").string();
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) return result;
+    if (pid == 0) {
+        if (chdir(siteDir.c_str()) != 0) _exit(127);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) {
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+        }
+        execl(binary.c_str(), binary.c_str(), "--jobs", jobsArg.c_str(), "--keep-config", configArg.c_str(),
+              (char*)nullptr);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage {};
+    if (wait4(pid, &status, 0, &usage) < 0) return result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#if defined(__APPLE__)
+    result.peakRss = (size_t)usage.ru_maxrss;
+#else
+    result.peakRss = (size_t)usage.ru_maxrss * 1024;
+#endif
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return result;
+}
+
+// 解析 "1,2,4,8"
+static bool parseJobsList(const std::string& value, std::vector<size_t>& jobs) {
+    jobs.clear();
+    std::stringstream ss(value);
+    std::string item;
+    try {
+        while (std::getline(ss, item, ',')) {
+            size_t n = std::stoul(item);
+            if (n == 0) return false;
+            jobs.push_back(n);
+        }
+    } catch (...) {
+        return false;
+    }
+    return !jobs.empty();
+}
+
+int main(int argc, char* argv[]) {
+    std::string binary = REIMU_ENCRYPT_BINARY;
+    std::vector<size_t> jobsList;
+    size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t n = 1; n < hw; n *= 2) jobsList.push_back(n);
+    jobsList.push_back(hw);
+    size_t repeat = 3;
+    fs::path dir = fs::temp_directory_path() / "reimu-scale-bench";
+    SiteParams params;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        bool ok = true;
+        if (arg == "--binary") binary = value;
+        else if (arg == "--jobs") ok = parseJobsList(value, jobsList);
+        else if (arg == "--repeat") ok = (repeat = std::strtoul(value.c_str(), nullptr, 10)) > 0;
+        else if (arg == "--dir") dir = value;
+        else ok = parseSiteOption(arg, value, params);
+        if (!ok) {
+            cerr << "错误: 无法解析参数 " << arg << "\n"
+                 << "用法: " << argv[0] << " [--binary 路径] [--jobs 1,2,4,8] [--repeat 3] [--dir 目录] [生成参数]\n"
+                 << siteOptionsUsage();
+            return 1;
+        }
+        ++i;
+    }
+
+    // 子进程在站点目录中执行，相对路径须先相对当前目录解析
+    binary = fs::absolute(binary).string();
+    fs::path templateDir = dir / "template";
+    fs::path runDir = dir / "run";
+    fs::remove_all(dir);
+    SiteStats stats = generateSite(params, templateDir);
+    double mb = stats.bytes / (1024.0 * 1024.0);
+    cout << "合成站点: 页面 " << stats.pages << ", " << std::fixed << std::setprecision(1) << mb
+         << " MB, 局部加密块 " << stats.blocks << ", 种子 " << params.seed << endl;
+    cout << "可执行文件: " << binary << ", 每组取 " << repeat << " 次中最快的一次" << endl << endl;
+
+    cout << std::left << std::setw(6) << "jobs" << std::right
+         << std::setw(10) << "秒" << std::setw(12) << "页面/s" << std::setw(10) << "MB/s"
+         << std::setw(14) << "峰值RSS(MB)" << std::setw(10) << "加速比" << std::setw(10) << "每核效率" << endl;
+
+    double baseline = 0;  // 单线程（或第一组除以线程数）的页面/s
+    int exitCode = 0;
+    for (size_t jobs : jobsList) {
+        RunResult best;
+        for (size_t r = 0; r < repeat; ++r) {
+            fs::remove_all(runDir);
+            fs::copy(templateDir, runDir, fs::copy_options::recursive);
+            RunResult run = runOnce(binary, runDir, jobs);
+            if (!run.ok) {
+                cerr << "运行失败: --jobs " << jobs << "（检查 " << (runDir / "log.txt").string() << "）" << endl;
+                exitCode = 1;
+                best = run;
+                break;
+            }
+            if (!best.ok || run.seconds < best.seconds) best = run;
+        }
+        if (!best.ok) continue;
+
+        double pagesPerSec = stats.pages / best.seconds;
+        if (baseline == 0) baseline = pagesPerSec / jobs;
+        double speedup = pagesPerSec / baseline;
+        cout << std::left << std::setw(6) << jobs << std::right << std::setprecision(3)
+             << std::setw(10) << best.seconds << std::setprecision(1)
+             << std::setw(12) << pagesPerSec << std::setw(10) << mb / best.seconds
+             << std::setw(14) << best.peakRss / (1024.0 * 1024.0)
+             << std::setprecision(2) << std::setw(10) << speedup << std::setw(10) << speedup / jobs << endl;
+    }
+
+    fs::remove_all(dir);
+    return exitCode;
+}
+
+#endif
@@ -0,0 +1,35 @@
+﻿/**
+ * 合成站点生成器
+ *
+ * 用法: reimuSiteGen 输出目录 [生成参数]
+ * 生成可复现的类 Hugo 站点与 encrypt.json，用于性能测试和问题复现。
+ */
+#include <iostream>
+#include <string>
+
+#include "siteGenerator.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "用法: " << argv[0] << " 输出目录 [生成参数]\n" << siteOptionsUsage();
+        return 1;
+    }
+    SiteParams params;
+    for (int i = 2; i < argc; ++i) {
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (!parseSiteOption(argv[i], value, params)) {
+            cerr << "错误: 无法解析参数 " << argv[i] << "\n" << siteOptionsUsage();
+            return 1;
+        }
+        ++i;
+    }
+
+    fs::path dir = argv[1];
+    fs::remove_all(dir);
+    SiteStats stats = generateSite(params, dir);
+    cout << "已生成: " << dir.string() << ", 页面 " << stats.pages << ", 总大小 "
+         << stats.bytes / (1024.0 * 1024.0) << " MB, 局部加密块 " << stats.blocks << endl;
+    return 0;
+}
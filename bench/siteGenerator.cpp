@@ -0,0 +1,143 @@
+﻿#include "siteGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "nlohmann/json.hpp"
+#include "tool.h"
+
+bool parseSiteOption(const std::string& arg, const std::string& value, SiteParams& params) {
+    try {
+        if (arg == "--pages") params.pages = std::stoul(value);
+        else if (arg == "--size") params.sizeMedianKb = std::stod(value);
+        else if (arg == "--sigma") params.sizeSigma = std::stod(value);
+        else if (arg == "--max-size") params.maxSizeKb = std::stod(value);
+        else if (arg == "--depth") params.domDepth = std::stoul(value);
+        else if (arg == "--matches") params.selectAllMatches = std::stoul(value);
+        else if (arg == "--password-ratio") params.passwordRatio = std::stod(value);
+        else if (arg == "--all-ratio") params.fullArticleRatio = std::stod(value);
+        else if (arg == "--seed") params.seed = (uint32_t)std::stoul(value);
+        else return false;
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+const char* siteOptionsUsage() {
+    return "  --pages N            页面数量（默认1000）\n"
+           "  --size KB            页面大小中位数（默认24）\n"
+           "  --sigma S            页面大小对数正态分布的sigma（默认0.8）\n"
+           "  --max-size KB        单页大小上限（默认4096）\n"
+           "  --depth D            正文外层嵌套层数（默认6）\n"
+           "  --matches M          局部加密页面的selectAll匹配块数（默认8）\n"
+           "  --password-ratio R   带页面内密码元素的块比例（默认0.25）\n"
+           "  --all-ratio R        整篇加密页面比例（默认0.5）\n"
+           "  --seed S             随机种子（默认42）\n";
+}
+
+// 追加一段正文，直到页面达到目标大小
+static void appendParagraphs(std::string& html, size_t target, std::mt19937& gen) {
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+                                  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "labore"};
+    std::uniform_int_distribution<size_t> wordDis(0, sizeof(words) / sizeof(words[0]) - 1);
+    std::uniform_int_distribution<int> kindDis(0, 9);
+    while (html.size() < target) {
+        int kind = kindDis(gen);
+        if (kind == 0) {
+            html += "<pre><code>for (int i = 0; i &lt; n; ++i) { sum += a[i]; }</code></pre>\n";
+        } else if (kind == 1) {
+            html += "<ul><li>" + std::string(words[wordDis(gen)]) + "</li><li>" + words[wordDis(gen)] + "</li></ul>\n";
+        } else {
+            html += "<p>";
+            for (int w = 0; w < 24; ++w) {
+                html += words[wordDis(gen)];
+                html += w % 7 == 6 ? ", " : " ";
+            }
+            html += "<a href=\"/posts/\">link</a>.</p>\n";
+        }
+    }
+}
+
+SiteStats generateSite(const SiteParams& params, const fs::path& dir) {
+    SiteStats stats;
+    std::mt19937 gen(params.seed);
+    std::lognormal_distribution<double> sizeDis(std::log(std::max(params.sizeMedianKb, 0.1)), params.sizeSigma);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    nlohmann::json articles = nlohmann::json::array();
+    fs::create_directories(dir);
+
+    for (size_t i = 0; i < params.pages; ++i) {
+        size_t target = (size_t)(std::min(sizeDis(gen), params.maxSizeKb) * 1024);
+        bool all = unit(gen) < params.fullArticleRatio;
+        std::string id = std::to_string(i);
+
+        std::string html;
+        html.reserve(target + 4096);
+        html += "<!DOCTYPE html>\n<html lang=\"zh-CN\"><head><meta charset=\"utf-8\"><title>Post " + id +
+                "</title><link rel=\"stylesheet\" href=\"/css/main.css\"></head>\n<body><header><nav>"
+                "<a href=\"/\">Home</a><a href=\"/posts/\">Posts</a></nav></header>\n<main>";
+        for (size_t d = 0; d < params.domDepth; ++d) {
+            html += "<div class=\"wrap-" + std::to_string(d) + "\">";
+        }
+        html += "<nav id=\"TableOfContents\"><ul><li><a href=\"#a\">A</a></li><li><a href=\"#b\">B</a></li></ul></nav>\n";
+        html += "<article class=\"post\"><h1>Post " + id + "</h1>\n";
+
+        // 局部加密页面：正文中均匀分布 selectAll 匹配的块
+        size_t blocks = all ? 0 : params.selectAllMatches;
+        size_t bodyStart = html.size();
+        size_t bodySize = target > bodyStart ? target - bodyStart : 0;
+        for (size_t b = 0; b <= blocks; ++b) {
+            appendParagraphs(html, bodyStart + bodySize * (b + 1) / (blocks + 1), gen);
+            if (b == blocks) break;
+            html += "<div class=\"secret\">";
+            if (unit(gen) < params.passwordRatio) {
+                html += "<span class=\"secret-password\">pw-" + id + "-" + std::to_string(b) + "</span>";
+            }
+            html += "<p>secret block " + std::to_string(b) + "</p></div>\n";
+        }
+        stats.blocks += blocks;
+
+        html += "</article>";
+        for (size_t d = 0; d < params.domDepth; ++d) {
+            html += "</div>";
+        }
+        html += "</main>\n<footer>generated</footer></body></html>\n";
+
+        std::string filePath = "posts/" + id + "/index.html";
+        fs::create_directories(dir / "posts" / id);
+        writeStringToFile((dir / filePath).string(), html);
+        stats.bytes += html.size();
+        ++stats.pages;
+
+        articles.push_back({{"title", "Post " + id},
+                            {"filePath", filePath},
+                            {"uniqueID", "synthetic-" + id},
+                            {"password", i % 3 == 0 ? "" : "pw-" + id},
+                            {"all", all}});
+    }
+
+    nlohmann::json config = {
+        {"generatedAt", "synthetic"},
+        {"totalCount", params.pages},
+        {"defaultPassword", "123456"},
+        {"encrypted-all", {
+            {{"name", "article"}, {"selector", "article"}, {"selectAll", false},
+             {"replace", {{"innerHTML", false}, {"content", ""}}}, {"password", ""}},
+            {{"name", "sidebar"}, {"selector", "#TableOfContents"}, {"selectAll", false},
+             {"replace", {{"innerHTML", false}, {"content", ""}}}},
+        }},
+        {"encrypted-partial", {
+            {{"name", "secret"}, {"selector", ".secret"}, {"selectAll", true},
+             {"replace", {{"innerHTML", true}, {"content", "<p class=\"locked\">此内容已加密</p>"}}},
+             {"password", ".secret-password"}},
+        }},
+        {"articles", articles},
+    };
+    std::ofstream out(dir / "encrypt.json");
+    out << config.dump(2);
+    return stats;
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+/**
+ * 合成站点的参数，同一组参数（含随机种子）总是生成完全相同的站点
+ */
+struct SiteParams {
+    size_t pages = 1000;              ///< 页面数量
+    double sizeMedianKb = 24;         ///< 页面大小中位数（KB），按对数正态分布抽样
+    double sizeSigma = 0.8;           ///< 对数正态分布的 sigma，越大长尾页面越多
+    double maxSizeKb = 4096;          ///< 单页大小上限（KB）
+    size_t domDepth = 6;              ///< 正文外层嵌套的 <div> 层数
+    size_t selectAllMatches = 8;      ///< 局部加密页面中 selectAll 规则匹配的块数
+    double passwordRatio = 0.25;      ///< 带页面内密码元素（密码选择器）的块所占比例
+    double fullArticleRatio = 0.5;    ///< 整篇加密（all=true）的页面比例，其余为局部加密
+    uint32_t seed = 42;               ///< 随机种子
+};
+
+/**
+ * 生成结果统计
+ */
+struct SiteStats {
+    size_t pages = 0;   ///< 页面数量
+    size_t bytes = 0;   ///< 页面总字节数
+    size_t blocks = 0;  ///< 局部加密块总数
+};
+
+/**
+ * 解析一个生成参数（如 --pages 1000），供生成器与基准驱动共用
+ * @param arg 参数名
+ * @param value 参数值
+ * @param params 解析结果
+ * @return arg 是生成参数且 value 合法时返回 true
+ */
+bool parseSiteOption(const std::string& arg, const std::string& value, SiteParams& params);
+
+/**
+ * 生成参数的用法说明
+ */
+const char* siteOptionsUsage();
+
+/**
+ * 在 dir 下生成类 Hugo 站点（posts/<n>/index.html）与对应的 encrypt.json
+ * @param params 生成参数
+ * @param dir 输出目录（已存在的内容会被覆盖）
+ * @return 生成结果统计
+ */
+SiteStats generateSite(const SiteParams& params, const fs::path& dir);
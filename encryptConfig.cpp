@@ -1,6 +1,9 @@
-﻿#include <fstream>
+﻿#include <cstdlib>
+#include <fstream>
+#include <iostream>
 #include <nlohmann/json.hpp>
 
+#include "aceEncrypt.h"
 #include "tool.h"
 #include "encryptConfig.h"
 
@@ -29,15 +32,62 @@ ArticleItem ArticleItem::fromJson(const nlohmann::json& j) {
     item.filePath = decodeUrl(item.filePath); // 文件路径可能需要进行 URL 解码
     if (j.contains("uniqueID")) item.uniqueID = j["uniqueID"].get<std::string>();
     if (j.contains("password")) item.password = j["password"].get<std::string>();
+    if (j.contains("passwords")) item.passwords = j["passwords"].get<std::vector<std::string>>();
+    if (j.contains("kdfIterations")) item.kdfIterations = j["kdfIterations"].get<unsigned int>();
     if (j.contains("all")) item.all = j["all"].get<bool>();
     return item;
 }
 
+ScrubFile ScrubFile::fromJson(const nlohmann::json& j) {
+    ScrubFile file;
+    if (j.is_string()) {
+        file.path = j.get<std::string>();
+        return file;
+    }
+    if (j.contains("path")) file.path = j["path"].get<std::string>();
+    if (j.contains("action")) file.action = j["action"].get<std::string>();
+    return file;
+}
+
+ScrubConfig ScrubConfig::fromJson(const nlohmann::json& j) {
+    ScrubConfig scrub;
+    if (j.contains("files")) {
+        for (const auto& file : j["files"]) {
+            scrub.files.push_back(ScrubFile::fromJson(file));
+        }
+    }
+    if (j.contains("action")) scrub.action = j["action"].get<std::string>();
+    if (j.contains("placeholder")) scrub.placeholder = j["placeholder"].get<std::string>();
+    if (j.contains("fields")) scrub.fields = j["fields"].get<std::vector<std::string>>();
+    if (j.contains("linkKeys")) scrub.linkKeys = j["linkKeys"].get<std::vector<std::string>>();
+    if (j.contains("basePath")) scrub.basePath = j["basePath"].get<std::string>();
+    return scrub;
+}
+
+AssetConfig AssetConfig::fromJson(const nlohmann::json& j) {
+    AssetConfig assets;
+    if (j.contains("extensions")) assets.extensions = j["extensions"].get<std::vector<std::string>>();
+    if (j.contains("chunkSize")) assets.chunkSize = j["chunkSize"].get<unsigned int>();
+    if (j.contains("suffix")) assets.suffix = j["suffix"].get<std::string>();
+    if (j.contains("keepOriginal")) assets.keepOriginal = j["keepOriginal"].get<bool>();
+    return assets;
+}
+
+SiteKeyConfig SiteKeyConfig::fromJson(const nlohmann::json& j) {
+    SiteKeyConfig siteKey;
+    if (j.contains("salt")) siteKey.salt = j["salt"].get<std::string>();
+    if (j.contains("maxAge")) siteKey.maxAge = j["maxAge"].get<unsigned int>();
+    return siteKey;
+}
+
 EncryptConfig EncryptConfig::fromJson(const nlohmann::json& j) {
     EncryptConfig cfg;
     if (j.contains("generatedAt")) cfg.generatedAt = j["generatedAt"].get<std::string>();
     if (j.contains("totalCount")) cfg.totalCount = j["totalCount"].get<int>();
     if (j.contains("defaultPassword")) cfg.defaultPassword = j["defaultPassword"].get<std::string>();
+    if (j.contains("passwords")) cfg.passwords = j["passwords"].get<std::vector<std::string>>();
+    if (j.contains("siteSecret")) cfg.siteSecret = j["siteSecret"].get<std::string>();
+    if (j.contains("kdfIterations")) cfg.kdfIterations = j["kdfIterations"].get<unsigned int>();
 
     if (j.contains("encrypted-all")) {
         for (const auto& item : j["encrypted-all"]) {
@@ -54,6 +104,9 @@ EncryptConfig EncryptConfig::fromJson(const nlohmann::json& j) {
             cfg.articles.push_back(ArticleItem::fromJson(item));
         }
     }
+    if (j.contains("scrub")) cfg.scrub = ScrubConfig::fromJson(j["scrub"]);
+    if (j.contains("assets")) cfg.assets = AssetConfig::fromJson(j["assets"]);
+    if (j.contains("siteKey")) cfg.siteKey = SiteKeyConfig::fromJson(j["siteKey"]);
     return cfg;
 }
 
@@ -68,5 +121,58 @@ std::optional<EncryptConfig> loadEncryptConfig(const std::string& filePath) {
     } catch (...) {
         return std::nullopt;
     }
-    return EncryptConfig::fromJson(j);
+    EncryptConfig config = EncryptConfig::fromJson(j);
+    // 迭代次数超出范围时拒绝加载：过小不安全，过大则解密端与 --verify 都会拒绝
+    auto checkIterations = [](unsigned int iterations, const std::string& where) {
+        if (iterations == 0 || validKdfIterations(iterations)) return true;
+        std::cerr << "错误: " << where << " 的 kdfIterations 必须在 " << MIN_KDF_ITERATIONS << " ~ "
+                  << MAX_KDF_ITERATIONS << " 之间" << std::endl;
+        logToFile(where + " 的 kdfIterations 不合法: " + std::to_string(iterations), LogLevel::ERROR);
+        return false;
+    };
+    if (!checkIterations(config.kdfIterations, "全局配置")) return std::nullopt;
+    for (const auto& article : config.articles) {
+        if (!checkIterations(article.kdfIterations, article.filePath)) return std::nullopt;
+    }
+    if (config.scrub) {
+        auto checkAction = [](const std::string& action, const std::string& where) {
+            if (action == "redact" || action == "encrypt" || action == "remove") return true;
+            std::cerr << "错误: " << where << " 的 action 必须为 redact、encrypt 或 remove" << std::endl;
+            logToFile(where + " 的 action 不合法: " + action, LogLevel::ERROR);
+            return false;
+        };
+        if (!checkAction(config.scrub->action, "scrub")) return std::nullopt;
+        for (const auto& file : config.scrub->files) {
+            if (!file.action.empty() && !checkAction(file.action, file.path)) return std::nullopt;
+        }
+    }
+    // 块太小时 GCM 标签的开销过大，太大时读者解密一块需要的内存过多
+    if (config.assets && (config.assets->chunkSize < 4096 || config.assets->chunkSize > 64 * 1024 * 1024)) {
+        std::cerr << "错误: assets.chunkSize 必须在 4096 ~ 67108864 之间" << std::endl;
+        logToFile("assets.chunkSize 不合法: " + std::to_string(config.assets->chunkSize), LogLevel::ERROR);
+        return std::nullopt;
+    }
+    if (config.assets && config.assets->suffix.empty()) {
+        std::cerr << "错误: assets.suffix 不能为空" << std::endl;
+        logToFile("assets.suffix 为空", LogLevel::ERROR);
+        return std::nullopt;
+    }
+    // 站点密钥也可以通过环境变量提供，避免写入配置文件
+    if (config.siteSecret.empty()) {
+        if (const char* secret = std::getenv("REIMU_SITE_SECRET")) config.siteSecret = secret;
+    }
+    // 站点级盐值需要在每次构建之间保持不变：显式配置，或由站点密钥派生
+    if (config.siteKey) {
+        if (config.siteKey->salt.empty() && config.siteSecret.empty()) {
+            std::cerr << "错误: siteKey 需要配置 salt 或 siteSecret" << std::endl;
+            logToFile("siteKey 缺少 salt 与 siteSecret", LogLevel::ERROR);
+            return std::nullopt;
+        }
+        if (!config.siteKey->salt.empty() && base64Decode(config.siteKey->salt).size() != 16) {
+            std::cerr << "错误: siteKey.salt 必须是16字节的 base64" << std::endl;
+            logToFile("siteKey.salt 不合法: " + config.siteKey->salt, LogLevel::ERROR);
+            return std::nullopt;
+        }
+    }
+    return config;
 }
\ No newline at end of file
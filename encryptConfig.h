@@ -29,19 +29,69 @@ struct ArticleItem {
     std::string filePath;
     std::string uniqueID;
     std::string password;
+    std::vector<std::string> passwords;  // 额外密码，每个都可以解密本文章
+    unsigned int kdfIterations = 0;  // PBKDF2 迭代次数，0 表示使用全局设置
     bool all = false;
 
     static ArticleItem fromJson(const nlohmann::json& j);
 };
 
+// 需要清理的订阅源/站点地图/搜索索引文件
+struct ScrubFile {
+    std::string path;    // 相对配置文件（站点根目录）的路径，.xml 或 .json
+    std::string action;  // redact / encrypt / remove，为空时使用 ScrubConfig::action
+
+    // 可以是路径字符串，或 {"path": ..., "action": ...}
+    static ScrubFile fromJson(const nlohmann::json& j);
+};
+
+// 订阅源、站点地图与搜索索引中加密文章条目的清理配置
+struct ScrubConfig {
+    std::vector<ScrubFile> files;
+    std::string action = "redact";  // redact：字段替换为占位文本；encrypt：字段加密；remove：删除整个条目
+    std::string placeholder = "该文章已加密";
+    // 改写的字段：XML 子元素名或 JSON 键
+    std::vector<std::string> fields = {"description", "content:encoded", "content", "summary", "contents"};
+    // JSON 记录中用于识别文章的键（链接或ID），其他字段（标题等）即使与文章路径相同也不作为判断依据
+    std::vector<std::string> linkKeys = {"permalink", "relpermalink", "url", "uri", "uniqueID"};
+    // 站点部署的子路径（如 "/blog"），"/" 表示根路径；未配置时从第一个订阅源的频道链接推断
+    std::optional<std::string> basePath;
+
+    static ScrubConfig fromJson(const nlohmann::json& j);
+};
+
+// 加密块中引用的本地资源文件（图片、PDF、视频等）的加密配置
+struct AssetConfig {
+    std::vector<std::string> extensions;  // 需要加密的扩展名（小写，不含点），为空时加密 .html 以外的所有本地文件
+    unsigned int chunkSize = 1024 * 1024;  // 每块的明文字节数
+    std::string suffix = ".enc";           // 加密文件名 = 原文件名 + suffix
+    bool keepOriginal = false;             // 加密后保留原文件（资源同时被公开页面引用时使用）
+
+    static AssetConfig fromJson(const nlohmann::json& j);
+};
+
+// 站点级密钥：全站的 PBKDF2 使用同一个盐值，读者在会话内只需输入并派生一次密码
+struct SiteKeyConfig {
+    std::string salt;             // base64 编码的16字节盐值，为空时由 siteSecret 派生
+    unsigned int maxAge = 86400;  // 浏览器保存派生密钥的秒数，0 表示不保存（只共用盐值）
+
+    static SiteKeyConfig fromJson(const nlohmann::json& j);
+};
+
 // 总配置
 struct EncryptConfig {
     std::string generatedAt;
     int totalCount = 0;
     std::string defaultPassword;
+    std::vector<std::string> passwords;  // 额外密码，每个都可以解密所有文章
+    std::string siteSecret;  // 站点密钥：设置后启用确定性加密（内容不变时输出不变）
+    unsigned int kdfIterations = 0;  // PBKDF2 迭代次数，0 表示使用默认值
     std::vector<EncryptedItem> encryptedAll;
     std::vector<EncryptedItem> encryptedPartial;
     std::vector<ArticleItem> articles;
+    std::optional<ScrubConfig> scrub;  // 加密后清理订阅源与搜索索引，未配置时不处理
+    std::optional<AssetConfig> assets;  // 加密块中引用的本地资源，未配置时不处理
+    std::optional<SiteKeyConfig> siteKey;  // 站点级密钥，未配置时每个页面使用独立的盐值
 
     static EncryptConfig fromJson(const nlohmann::json& j);
 };
@@ -0,0 +1,540 @@
+﻿#include <iostream>
+#include <cctype>
+#include <sstream>
+#include <future>
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "encryptCore.h"
+#include "aceEncrypt.h"
+#include "praseHtml.h"
+#include "tool.h"
+
+using namespace std;
+
+const std::string ENCRYPT_JS = R"(
+/**
+* 解密函数
+* @param {*} base64Data base64编码的加密数据
+* @param {*} password 解密密码（启用站点级密钥时可为空，使用本会话中保存的密钥）
+* @returns {Promise<string>} 解密后的明文数据
+*/
+async function encrypt(base64Data,password){if(!base64Data||(!password&&!reimuSiteKey())){throw new Error("请填写加密数据和密码");}const results=await decryptBlocks([base64Data],password);return results[0];}async function decryptAll(data,password,onBlock){if(!data||(!password&&!reimuSiteKey())){throw new Error("请填写加密数据和密码");}const blocks=[];const slots=[];for(const name of Object.keys(data)){const value=data[name];if(Array.isArray(value)){value.forEach((block,index)=>{blocks.push(block);slots.push({name:name,index:index});});}else{blocks.push(value);slots.push({name:name,index:-1});}}const callback=onBlock?(i,html)=>onBlock(slots[i].name,slots[i].index,html):null;const results=await decryptBlocks(blocks,password,callback);const output={};slots.forEach((slot,i)=>{if(slot.index<0){output[slot.name]=results[i];}else{(output[slot.name]=output[slot.name]||[])[slot.index]=results[i];}});return output;}function reimuDecryptCore(scope){const subtle=scope.crypto.subtle;const MODE_WRAPPED_KEYS=0x02;const WRAP_SIZE=76;const MODE_KEY_CHECK=0x03;const KEY_CHECK_HEADER_SIZE=33;const BASE64_TABLE=new Uint8Array(256);const alphabet="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";for(let i=0;i<alphabet.length;i++){BASE64_TABLE[alphabet.charCodeAt(i)]=i;}function base64ToArrayBuffer(base64){if(typeof Uint8Array.fromBase64==="function"){return Uint8Array.fromBase64(base64).buffer;}let length=base64.length;while(length>0&&base64.charCodeAt(length-1)===61){length--;}const bytes=new Uint8Array((length*3)>>2);let out=0;let i=0;for(;i+4<=length;i+=4){const n=(BASE64_TABLE[base64.charCodeAt(i)]<<18)|(BASE64_TABLE[base64.charCodeAt(i+1)]<<12)|(BASE64_TABLE[base64.charCodeAt(i+2)]<<6)|BASE64_TABLE[base64.charCodeAt(i+3)];bytes[out++]=n>>16;bytes[out++]=(n>>8)&255;bytes[out++]=n&255;}if(length-i>=2){const n=(BASE64_TABLE[base64.charCodeAt(i)]<<18)|(BASE64_TABLE[base64.charCodeAt(i+1)]<<12)|(length-i===3?BASE64_TABLE[base64.charCodeAt(i+2)]<<6:0);bytes[out++]=n>>16;if(length-i===3){bytes[out++]=(n>>8)&255;}}return bytes.buffer;}function toHex(buffer){return Array.from(new Uint8Array(buffer),(b)=>(b<16?"0":"")+b.toString(16)).join("");}function cached(cache,id,create){if(!cache.has(id)){cache.set(id,create());}return cache.get(id);}let siteKeyDb;function openSiteKeyDb(){siteKeyDb=siteKeyDb||new Promise((resolve)=>{try{const request=scope.indexedDB.open("reimu-encrypt",1);request.onupgradeneeded=()=>request.result.createObjectStore("keys",{keyPath:"id"});request.onsuccess=()=>resolve(request.result);request.onerror=()=>resolve(null);}catch(error){resolve(null);}});return siteKeyDb;}async function siteKeyRequest(mode,run){const db=await openSiteKeyDb();if(!db){return undefined;}return new Promise((resolve)=>{try{const request=run(db.transaction("keys",mode).objectStore("keys"));request.onsuccess=()=>resolve(request.result);request.onerror=()=>resolve(undefined);}catch(error){resolve(undefined);}});}async function loadSiteKeys(kind,iterations,saltHex){const records=(await siteKeyRequest("readonly",(store)=>store.getAll()))||[];const now=Date.now();records.filter((record)=>record.expires<=now).forEach((record)=>siteKeyRequest("readwrite",(store)=>store.delete(record.id)));return records.filter((record)=>record.expires>now&&record.kind===kind&&record.iterations===iterations&&record.salt===saltHex);}function saveSiteKey(siteKey,record){if(!siteKey.maxAge){return;}record.id=record.kind+":"+record.iterations+":"+record.salt+":"+Date.now()+":"+Math.random();record.expires=Date.now()+siteKey.maxAge*1000;siteKeyRequest("readwrite",(store)=>store.put(record));}function clearSiteKeys(){return siteKeyRequest("readwrite",(store)=>store.clear());}function containerMode(buffer){const bytes=new Uint8Array(buffer);if(bytes.length<10||String.fromCharCode(bytes[0],bytes[1],bytes[2],bytes[3])!=="RENC"){return 0;}return bytes[4];}async function deriveKeyFromPassword(password,salt,algorithm,iterations){const passwordKey=await subtle.importKey("raw",new TextEncoder().encode(password),{name:"PBKDF2"},false,["deriveKey",]);return await subtle.deriveKey({name:"PBKDF2",salt:salt,iterations:iterations,hash:"SHA-256"},passwordKey,{name:algorithm,length:256},false,["decrypt"]);}async function deriveCheckedKey(password,salt,iterations){const passwordKey=await subtle.importKey("raw",new TextEncoder().encode(password),{name:"PBKDF2"},false,["deriveBits",]);const bits=await subtle.deriveBits({name:"PBKDF2",salt:salt,iterations:iterations,hash:"SHA-256"},passwordKey,256);const hmacKey=await subtle.importKey("raw",bits,{name:"HMAC",hash:"SHA-256"},false,["sign"]);const check=await subtle.sign("HMAC",hmacKey,new TextEncoder().encode("reimu-kcv"));const key=await subtle.importKey("raw",bits,{name:"AES-CBC"},false,["decrypt"]);return{key:key,check:toHex(check.slice(0,8))};}async function unwrapWith(kek,wrap,header){const rawKey=await subtle.decrypt({name:"AES-GCM",iv:wrap.slice(16,28),additionalData:header},kek,wrap.slice(28));return await subtle.importKey("raw",rawKey,{name:"AES-CBC"},false,["decrypt"]);}async function unwrapContentKey(wrap,password,iterations,header,cache,siteKey){const salt=wrap.slice(0,16);const id=iterations+":"+toHex(salt);const kek=await cached(cache,"AES-GCM:"+id,()=>deriveKeyFromPassword(password,salt,"AES-GCM",iterations));const key=await unwrapWith(kek,wrap,header);if(siteKey&&siteKey.salt===toHex(salt)){cached(cache,"save:wrap:"+id,()=>saveSiteKey(siteKey,{kind:"wrap",iterations:iterations,salt:siteKey.salt,key:kek}));}return key;}async function unwrapAny(buffer,password,count,cache,siteKey){const view=new DataView(buffer);const iterations=view.getUint32(5);const header=buffer.slice(0,9);const wraps=[];for(let i=0;i<count;i++){wraps.push(buffer.slice(10+i*WRAP_SIZE,10+(i+1)*WRAP_SIZE));}const siteWraps=siteKey?wraps.filter((wrap)=>toHex(wrap.slice(0,16))===siteKey.salt):[];if(siteWraps.length>0){const stored=await cached(cache,"site:wrap:"+iterations,()=>loadSiteKeys("wrap",iterations,siteKey.salt));const attempts=[];stored.forEach((record)=>siteWraps.forEach((wrap)=>attempts.push(unwrapWith(record.key,wrap,header))));try{return await Promise.any(attempts);}catch(error){}}if(!password){throw new Error("解密失败: 需要密码");}try{return await Promise.any(wraps.map((wrap)=>unwrapContentKey(wrap,password,iterations,header,cache,siteKey)));}catch(error){throw new Error("解密失败: 密码错误");}}async function checkedKey(password,salt,iterations,check,cache,siteKey){const id=iterations+":"+toHex(salt);const site=siteKey&&siteKey.salt===toHex(salt);if(site){const stored=await cached(cache,"site:checked:"+iterations,()=>loadSiteKeys("checked",iterations,siteKey.salt));const hit=stored.find((record)=>record.check===check);if(hit){return hit;}}if(!password){throw new Error("解密失败: 需要密码");}const derived=await cached(cache,"checked:"+id,()=>deriveCheckedKey(password,salt,iterations));if(site&&derived.check===check){cached(cache,"save:checked:"+id+":"+check,()=>saveSiteKey(siteKey,{kind:"checked",iterations:iterations,salt:siteKey.salt,key:derived.key,check:check}));}return derived;}async function decryptData(ciphertext,key,iv){try{return await subtle.decrypt({name:"AES-CBC",iv:iv},key,ciphertext);}catch(error){throw new Error("解密失败: "+error.message);}}async function decryptBlock(buffer,password,cache,siteKey){if(buffer.byteLength===0){return new ArrayBuffer(0);}if(containerMode(buffer)===MODE_WRAPPED_KEYS){const count=new Uint8Array(buffer)[9];const dataOffset=10+count*WRAP_SIZE;if(buffer.byteLength<dataOffset+16){throw new Error("加密数据长度不足，无法解密");}const key=await cached(cache,"wrap:"+toHex(buffer.slice(0,dataOffset)),()=>unwrapAny(buffer,password,count,cache,siteKey));return await decryptData(buffer.slice(dataOffset+16),key,buffer.slice(dataOffset,dataOffset+16));}if(containerMode(buffer)===MODE_KEY_CHECK){if(buffer.byteLength<KEY_CHECK_HEADER_SIZE+16){throw new Error("加密数据长度不足，无法解密");}const iterations=new DataView(buffer).getUint32(5);const salt=buffer.slice(9,25);const check=toHex(buffer.slice(25,KEY_CHECK_HEADER_SIZE));const derived=await checkedKey(password,salt,iterations,check,cache,siteKey);if(derived.check!==check){throw new Error("解密失败: 密码错误");}const ivEnd=KEY_CHECK_HEADER_SIZE+16;return await decryptData(buffer.slice(ivEnd),derived.key,buffer.slice(KEY_CHECK_HEADER_SIZE,ivEnd));}if(buffer.byteLength<32){throw new Error("加密数据长度不足，无法解密");}const salt=buffer.slice(0,16);const key=await cached(cache,"AES-CBC:10000:"+toHex(salt),()=>deriveKeyFromPassword(password,salt,"AES-CBC",10000));return await decryptData(buffer.slice(32),key,buffer.slice(16,32));}return{base64ToArrayBuffer:base64ToArrayBuffer,decryptBlock:decryptBlock,toHex:toHex,clearSiteKeys:clearSiteKeys};}function reimuWorkerMain(scope,core){scope.postMessage({ready:true});scope.onmessage=(event)=>{const id=event.data.id;const password=event.data.password;const cache=new Map();event.data.blocks.forEach(async(block,index)=>{try{const buffer=typeof block==="string"?core.base64ToArrayBuffer(block):block;const plain=await core.decryptBlock(buffer,password,cache,event.data.siteKey);scope.postMessage({id:id,index:index,plain:plain},[plain]);}catch(error){scope.postMessage({id:id,index:index,error:error.message});}});};}function reimuSiteKey(){if(typeof __ENCRYPT_SITE_KEY__==="undefined"||!__ENCRYPT_SITE_KEY__.salt){return null;}reimuLocalCore=reimuLocalCore||reimuDecryptCore(window);const salt=reimuLocalCore.toHex(reimuLocalCore.base64ToArrayBuffer(__ENCRYPT_SITE_KEY__.salt));return{salt:salt,maxAge:__ENCRYPT_SITE_KEY__.maxAge||0};}async function reimuForgetSiteKeys(){reimuLocalCore=reimuLocalCore||reimuDecryptCore(window);await reimuLocalCore.clearSiteKeys();}let reimuWorker;let reimuWorkerReady=false;let reimuLocalCore;let reimuNextId=0;const reimuPending=new Map();function reimuGetWorker(){if(reimuWorker!==undefined){return reimuWorker;}reimuWorker=null;try{const source=reimuDecryptCore.toString()+"\n"+reimuWorkerMain.toString()+"\nreimuWorkerMain(self, reimuDecryptCore(self));";const worker=new Worker(URL.createObjectURL(new Blob([source],{type:"text/javascript"})));worker.onmessage=(event)=>{if(event.data.ready){reimuWorkerReady=true;return;}const request=reimuPending.get(event.data.id);if(request){request.settle(event.data.index,event.data.error,event.data.plain);}};worker.onerror=()=>{worker.terminate();reimuWorker=null;const requests=Array.from(reimuPending.values());reimuPending.clear();requests.forEach((request)=>request.runLocally());};reimuWorker=worker;}catch(error){reimuWorker=null;}return reimuWorker;}function decryptBlocks(blocks,password,onBlock){const siteKey=reimuSiteKey();return new Promise((resolve,reject)=>{const decoder=new TextDecoder();const results=new Array(blocks.length);const done=new Array(blocks.length).fill(false);let remaining=blocks.length;let failure=null;let id=0;if(remaining===0){resolve(results);return;}const settle=(index,error,plain)=>{if(done[index]){return;}done[index]=true;if(error){failure=failure||error;}else{results[index]=decoder.decode(plain);if(onBlock&&!failure){onBlock(index,results[index]);}}if(--remaining===0){reimuPending.delete(id);failure?reject(new Error(failure)):resolve(results);}};const runLocally=()=>{reimuLocalCore=reimuLocalCore||reimuDecryptCore(window);const cache=new Map();blocks.forEach(async(block,index)=>{if(done[index]){return;}try{const buffer=typeof block==="string"?reimuLocalCore.base64ToArrayBuffer(block):block;settle(index,null,await reimuLocalCore.decryptBlock(buffer,password,cache,siteKey));}catch(error){settle(index,error.message);}});};const worker=reimuGetWorker();if(!worker){runLocally();return;}id=++reimuNextId;reimuPending.set(id,{settle:settle,runLocally:runLocally});const transfer=reimuWorkerReady?blocks.filter((block)=>block instanceof ArrayBuffer):[];worker.postMessage({id:id,password:password,blocks:blocks,siteKey:siteKey},transfer);});}const REIMU_ASSET_ATTRIBUTES=["src","poster","data","href"];const REIMU_ASSET_SELECTOR=REIMU_ASSET_ATTRIBUTES.map((name)=>"[data-reimu-"+name+"]").join(",");const REIMU_ASSET_HEADER_SIZE=17;const REIMU_ASSET_TAG_SIZE=16;const reimuAssetCache=new Map();let reimuAssetObserver;function reimuFetchAsset(value){const first=value.indexOf(" ");const second=value.indexOf(" ",first+1);const url=value.slice(second+1);if(!reimuAssetCache.has(url)){const pending=reimuDecryptAsset(url,value.slice(0,first),value.slice(first+1,second));reimuAssetCache.set(url,pending);pending.catch(()=>reimuAssetCache.delete(url));}return reimuAssetCache.get(url);}async function reimuDecryptAsset(url,keyBase64,type){reimuLocalCore=reimuLocalCore||reimuDecryptCore(window);const subtle=window.crypto.subtle;const key=await subtle.importKey("raw",reimuLocalCore.base64ToArrayBuffer(keyBase64),{name:"AES-GCM"},false,["decrypt",]);const response=await fetch(url);if(!response.ok){throw new Error("加载加密资源失败: "+url+", HTTP "+response.status);}let pieces=[];let buffered=0;const take=(size)=>{const out=new Uint8Array(size);let offset=0;while(offset<size){const piece=pieces[0];const count=Math.min(piece.length,size-offset);out.set(piece.subarray(0,count),offset);offset+=count;if(count===piece.length){pieces.shift();}else{pieces[0]=piece.subarray(count);}}buffered-=size;return out;};let header=null;let chunkSize=0;let index=0;const parts=[];const decryptChunk=(chunk,last)=>{const iv=new Uint8Array(12);iv.set(header.subarray(9,17));new DataView(iv.buffer).setUint32(8,index++);const additionalData=new Uint8Array(REIMU_ASSET_HEADER_SIZE+1);additionalData.set(header);additionalData[REIMU_ASSET_HEADER_SIZE]=last?1:0;const part=subtle.decrypt({name:"AES-GCM",iv:iv,additionalData:additionalData},key,chunk);part.catch(()=>{});parts.push(part);};const consume=(done)=>{if(!header){if(buffered<REIMU_ASSET_HEADER_SIZE){return;}header=take(REIMU_ASSET_HEADER_SIZE);if(String.fromCharCode(header[0],header[1],header[2],header[3])!=="RENC"||header[4]!==0x04){throw new Error("不是加密资源: "+url);}chunkSize=new DataView(header.buffer).getUint32(5);}while(buffered>chunkSize+REIMU_ASSET_TAG_SIZE){decryptChunk(take(chunkSize+REIMU_ASSET_TAG_SIZE),false);}if(done){decryptChunk(take(buffered),true);}};if(response.body&&response.body.getReader){const reader=response.body.getReader();for(;;){const{done,value}=await reader.read();if(done){break;}pieces.push(value);buffered+=value.length;consume(false);}}else{const whole=new Uint8Array(await response.arrayBuffer());pieces.push(whole);buffered=whole.length;}if(!header&&buffered<REIMU_ASSET_HEADER_SIZE){throw new Error("加密资源不完整: "+url);}consume(true);try{return URL.createObjectURL(new Blob(await Promise.all(parts),{type:type}));}catch(error){throw new Error("资源解密失败: "+url);}}function reimuApplyAssets(element){REIMU_ASSET_ATTRIBUTES.forEach((name)=>{const value=name!=="href"&&element.getAttribute("data-reimu-"+name);if(!value){return;}element.removeAttribute("data-reimu-"+name);reimuFetchAsset(value).then((blobUrl)=>{element.setAttribute(name,blobUrl);const media=element.parentElement;if((element.tagName==="SOURCE"||element.tagName==="TRACK")&&media&&media.load){media.load();}}).catch((error)=>console.error(error));});}function reimuBindLink(element){const value=element.getAttribute("data-reimu-href");element.removeAttribute("data-reimu-href");let pending=null;const load=()=>{pending=pending||reimuFetchAsset(value).then((blobUrl)=>element.setAttribute("href",blobUrl));return pending;};element.addEventListener("pointerenter",()=>load().catch(()=>(pending=null)),{once:true});element.addEventListener("focus",()=>load().catch(()=>(pending=null)),{once:true});element.addEventListener("click",(event)=>{if(element.hasAttribute("href")){return;}event.preventDefault();load().then(()=>element.click()).catch((error)=>{pending=null;console.error(error);});});}function reimuLoadAssets(root){const elements=[];if(root.matches&&root.matches(REIMU_ASSET_SELECTOR)){elements.push(root);}if(root.querySelectorAll){elements.push(...root.querySelectorAll(REIMU_ASSET_SELECTOR));}elements.forEach((element)=>{if(element.hasAttribute("data-reimu-href")){reimuBindLink(element);}if(!REIMU_ASSET_ATTRIBUTES.some((name)=>name!=="href"&&element.hasAttribute("data-reimu-"+name))){return;}const lazy=element.tagName!=="SOURCE"&&element.tagName!=="TRACK";if(!lazy||typeof IntersectionObserver!=="function"){reimuApplyAssets(element);return;}reimuAssetObserver=reimuAssetObserver||new IntersectionObserver((entries)=>{entries.forEach((entry)=>{if(entry.isIntersecting){reimuAssetObserver.unobserve(entry.target);reimuApplyAssets(entry.target);}});},{rootMargin:"200px"});reimuAssetObserver.observe(element);});}if(typeof document!=="undefined"&&typeof MutationObserver==="function"){new MutationObserver((mutations)=>{mutations.forEach((mutation)=>mutation.addedNodes.forEach((node)=>node.nodeType===1&&reimuLoadAssets(node)));}).observe(document.documentElement,{childList:true,subtree:true});}
+)";
+
+// 单条规则的加密结果：selectAll 为 true 时输出为数组
+struct EncryptedEntry {
+    std::string name;
+    bool isArray = false;
+    std::vector<std::string> values;
+    std::vector<std::future<std::string>> pending;  ///< 尚未完成的加密任务（按文档顺序）
+};
+
+// 将规则名转为JS字符串字面量内容（规则名通常无需转义，这里只做兜底）
+static std::string escapeJsString(const std::string& str) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(str.size());
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20 || c == '<' || c == '>') {
+            // 控制字符与尖括号使用 \u00XX，避免提前结束<script>
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        } else {
+            out += (char)c;
+        }
+    }
+    return out;
+}
+
+/**
+ * 生成 __ENCRYPT_DATA__ 脚本内容
+ *
+ * Base64数据只包含 [A-Za-z0-9+/=]，无需转义，直接写入；先计算精确长度，
+ * 整个脚本只分配一次内存。
+ */
+static std::string buildEncryptDataScript(const std::vector<EncryptedEntry>& entries) {
+    static const std::string prefix = "var __ENCRYPT_DATA__ = {";
+    static const std::string suffix = "};";
+
+    std::vector<std::string> names;
+    size_t size = prefix.size() + suffix.size();
+    for (const auto& entry : entries) {
+        names.push_back(escapeJsString(entry.name));
+        size += names.back().size() + 3;         // "name":
+        if (entry.isArray) size += 2;            // []
+        for (const auto& value : entry.values) {
+            size += value.size() + 2;            // "value"
+        }
+        if (entry.values.size() > 1) size += entry.values.size() - 1;  // 数组元素间的逗号
+    }
+    if (entries.size() > 1) size += entries.size() - 1;  // 键值对间的逗号
+
+    std::string script;
+    script.reserve(size);
+    script += prefix;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (i > 0) script += ',';
+        script += '"';
+        script += names[i];
+        script += "\":";
+        if (entry.isArray) script += '[';
+        for (size_t k = 0; k < entry.values.size(); ++k) {
+            if (k > 0) script += ',';
+            script += '"';
+            script += entry.values[k];
+            script += '"';
+        }
+        if (entry.isArray) script += ']';
+    }
+    script += suffix;
+    return script;
+}
+
+/**
+ * 构建站点级密钥脚本：var __ENCRYPT_SITE_KEY__ = {"salt":"...","maxAge":N};
+ */
+static std::string buildSiteKeyScript(const SiteKey& siteKey) {
+    return "var __ENCRYPT_SITE_KEY__ = {\"salt\":\"" + base64Encode(siteKey.salt) + "\",\"maxAge\":" +
+           std::to_string(siteKey.maxAge) + "};";
+}
+
+// 查找同名规则的结果项，不存在时按出现顺序追加
+static EncryptedEntry& entryFor(std::vector<EncryptedEntry>& entries, const std::string& name) {
+    for (auto& entry : entries) {
+        if (entry.name == name) return entry;
+    }
+    entries.push_back(EncryptedEntry{name});
+    return entries.back();
+}
+
+// 确定节点的加密密码：规则配置了密码选择器时从节点内查找，找不到则使用默认密码
+static string resolvePassword(const string &defaultPassword,
+                              const std::shared_ptr<LexborNode> &node,
+                              const EncryptedItem &item) {
+    string password;
+    if (!item.password.empty()) {
+        auto passwordNode = node->querySelector(item.password);
+        if (passwordNode) {
+            password = trim(passwordNode->getContent());
+        }
+    }
+    if (password.empty()) {
+        password = defaultPassword;
+    }
+    return password;
+}
+
+// 节点的全部密码：主密码在前，其后为额外密码（去重）
+static std::vector<string> resolvePasswords(const string &defaultPassword,
+                                            const std::vector<string> &extraPasswords,
+                                            const std::shared_ptr<LexborNode> &node,
+                                            const EncryptedItem &item) {
+    std::vector<string> passwords{resolvePassword(defaultPassword, node, item)};
+    for (const auto &password : extraPasswords) {
+        if (!password.empty() && std::find(passwords.begin(), passwords.end(), password) == passwords.end()) {
+            passwords.push_back(password);
+        }
+    }
+    return passwords;
+}
+
+// 加密节点内容快照并进行base64编码（不访问DOM，可在任意线程执行）
+static string encryptSnapshot(const string &name, const string &content, const AesEncryptor &encryptor) {
+    string encryptedBase64;
+    if (!content.empty() && encryptor.valid()) {
+        // 分块加密后直接编码进精确大小的 base64 结果，不保留完整的二进制密文
+        encryptedBase64 = encryptor.encryptBase64(content.data(), content.size(), name);
+        logToFile("加密内容: " + name + ", 内容(Base64前100): " + encryptedBase64.substr(0, 100), LogLevel::DEBUG);
+    } else {
+        logToFile("内容为空无法加密: " + name + ", 内容: " + content.substr(0, 100), LogLevel::DEBUG);
+    }
+    return encryptedBase64;
+}
+
+// 同一文档中按密码列表复用加密器：PBKDF2 与密钥扩展每组密码只做一次
+using EncryptorCache = std::map<std::vector<string>, std::shared_ptr<const AesEncryptor>>;
+
+static std::shared_ptr<const AesEncryptor> encryptorFor(EncryptorCache &encryptors, std::vector<string> passwords,
+                                                        const DeterministicKey &deterministic,
+                                                        unsigned int kdfIterations, const std::string &siteSalt) {
+    auto it = encryptors.find(passwords);
+    if (it != encryptors.end()) return it->second;
+    auto encryptor = std::make_shared<const AesEncryptor>(passwords, deterministic, kdfIterations, siteSalt);
+    encryptors.emplace(std::move(passwords), encryptor);
+    return encryptor;
+}
+
+const std::string RESTORE_ANCHOR_END = "/reimu";
+
+std::string restoreAnchor(const std::string &name, size_t index) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string anchor = "reimu:";
+    // 规则名中字母数字以外的字符按百分号编码，注释中不会出现 "--" 或 ">"
+    for (unsigned char c : name) {
+        if (std::isalnum(c) || c == '_' || c == '.') {
+            anchor += (char)c;
+        } else {
+            anchor += '%';
+            anchor += hex[c >> 4];
+            anchor += hex[c & 0xF];
+        }
+    }
+    anchor += ':';
+    anchor += std::to_string(index);
+    return anchor;
+}
+
+// 可能引用本地资源的元素与属性
+static const std::vector<std::pair<std::string, std::string>> ASSET_ATTRIBUTES = {
+    {"img", "src"},     {"video", "src"}, {"video", "poster"}, {"audio", "src"},  {"source", "src"},
+    {"track", "src"},   {"a", "href"},    {"object", "data"},  {"embed", "src"},
+};
+
+// 是否为站内相对/绝对路径（不含协议、协议相对URL与页内锚点）
+static bool isLocalUrl(const std::string &url) {
+    if (url.empty() || url[0] == '#' || url.compare(0, 2, "//") == 0) return false;
+    for (char c : url) {
+        if (c == ':') return false;  // http:、data:、mailto:、javascript: 等
+        if (c == '/' || c == '?' || c == '#') break;
+    }
+    return true;
+}
+
+/**
+ * 把节点内引用的本地资源改写为 data-reimu-<属性>="密钥 类型 加密URL"
+ *
+ * 原属性被删除，明文资源的地址不会出现在页面中；解密脚本在节点解密后按该属性取回并解密资源。
+ * 改写了 src 的 img/source 同时删除 srcset，避免浏览器继续加载其中的明文资源。
+ *
+ * @return 改写的属性数
+ */
+static size_t rewriteAssetReferences(const std::shared_ptr<LexborNode> &node, const AssetResolver &assets) {
+    size_t rewritten = 0;
+    for (const auto &element : node->elements()) {
+        std::string tag = element->tagName();
+        for (const auto &[elementTag, attribute] : ASSET_ATTRIBUTES) {
+            if (elementTag != tag) continue;
+            std::optional<std::string> url = element->getAttribute(attribute);
+            if (!url || !isLocalUrl(*url)) continue;
+            std::optional<AssetRef> asset = assets(*url);
+            if (!asset) continue;
+            element->setAttribute("data-reimu-" + attribute, asset->key + " " + asset->type + " " + asset->url);
+            element->removeAttribute(attribute);
+            if (attribute == "src" && (tag == "img" || tag == "source")) element->removeAttribute("srcset");
+            logToFile("资源引用已改写: " + *url + " -> " + asset->url, LogLevel::DEBUG);
+            ++rewritten;
+        }
+    }
+    return rewritten;
+}
+
+std::vector<AssetRef> restoreAssetReferences(const std::shared_ptr<LexborNode> &node, const std::string &suffix) {
+    std::vector<AssetRef> restored;
+    for (const auto &element : node->elements()) {
+        std::string tag = element->tagName();
+        for (const auto &[elementTag, attribute] : ASSET_ATTRIBUTES) {
+            if (elementTag != tag) continue;
+            const std::string name = "data-reimu-" + attribute;
+            std::optional<std::string> value = element->getAttribute(name);
+            if (!value) continue;
+            // "密钥 类型 加密URL"：URL 中可能含空格，只按前两个空格拆分
+            size_t first = value->find(' ');
+            size_t second = first == std::string::npos ? first : value->find(' ', first + 1);
+            if (second == std::string::npos) continue;
+            AssetRef ref;
+            ref.key = value->substr(0, first);
+            ref.type = value->substr(first + 1, second - first - 1);
+            ref.url = value->substr(second + 1);
+            std::string url = ref.url;
+            if (!suffix.empty() && url.size() > suffix.size() &&
+                url.compare(url.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                url.resize(url.size() - suffix.size());
+            }
+            element->setAttribute(attribute, url);
+            element->removeAttribute(name);
+            restored.push_back(std::move(ref));
+        }
+    }
+    return restored;
+}
+
+// 按配置替换节点，index 为节点在 __ENCRYPT_DATA__ 中对应的下标
+static void replaceNode(const std::shared_ptr<LexborNode> &node, const EncryptedItem &item, size_t index,
+                        LexborFragmentCache &fragments) {
+    if (item.replace && item.replace->innerHTML) {
+        // 替换节点内容（节点本身保留，恢复时按选择器定位）
+        node->setInnerHtml(item.replace->content, fragments);
+        logToFile("InnerHtml替换: " + item.name + ", 内容: " + item.replace->content.substr(0, 100), LogLevel::DEBUG);
+    } else if (item.replace) {
+        // 替换节点外部HTML，前后留下恢复锚点
+        node->insertCommentBefore(restoreAnchor(item.name, index));
+        node->insertCommentAfter(RESTORE_ANCHOR_END);
+        node->setOuterHtml(item.replace->content, fragments);
+        logToFile("OuterHtml替换: " + item.name + ", 内容: " + item.replace->content.substr(0, 100), LogLevel::DEBUG);
+    }
+}
+
+/**
+ * 处理一条规则选中的全部节点
+ *
+ * 1. 依次读取每个节点的密码，改写其中引用的本地资源后取HTML快照（串行访问DOM），取得该组密码的加密器
+ * 2. 将快照提交到线程池并发加密
+ * 3. 按文档顺序串行替换节点（替换片段每个文档只解析一次，之后深拷贝），
+ *    整体替换的节点前后留下恢复锚点
+ *
+ * 替换在下一条规则查询之前完成，因此规则之间的可见性与串行处理一致；
+ * 加密任务则与后续规则的DOM处理并行进行。
+ */
+static void processNodes(const string &defaultPassword,
+                         const std::vector<string> &extraPasswords,
+                         const std::vector<std::shared_ptr<LexborNode>> &nodes,
+                         const EncryptedItem &item,
+                         ThreadPool *pool,
+                         LexborFragmentCache &fragments,
+                         EncryptorCache &encryptors,
+                         const DeterministicKey &deterministic,
+                         unsigned int kdfIterations,
+                         const std::string &siteSalt,
+                         const AssetResolver &assets,
+                         EncryptedEntry &entry) {
+    for (const auto &node : nodes) {
+        auto encryptor = encryptorFor(encryptors, resolvePasswords(defaultPassword, extraPasswords, node, item),
+                                      deterministic, kdfIterations, siteSalt);
+        if (assets) rewriteAssetReferences(node, assets);
+        string content = node->getHtml();
+        auto task = [name = item.name, content = std::move(content), encryptor = std::move(encryptor)]() {
+            return encryptSnapshot(name, content, *encryptor);
+        };
+        if (pool) {
+            entry.pending.push_back(pool->submit(std::move(task)));
+        } else {
+            std::packaged_task<string()> inlineTask(std::move(task));
+            entry.pending.push_back(inlineTask.get_future());
+            inlineTask();
+        }
+    }
+    size_t first = entry.pending.size() - nodes.size();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        replaceNode(nodes[i], item, first + i, fragments);
+    }
+}
+
+std::optional<std::string> encryptHtml(const std::string &html,
+                                       const std::vector<EncryptedItem> &rules,
+                                       const std::string &defaultPassword,
+                                       ThreadPool *pool,
+                                       const std::vector<std::string> &extraPasswords,
+                                       const DeterministicKey &deterministic,
+                                       unsigned int kdfIterations,
+                                       const AssetResolver &assets,
+                                       const SiteKey &siteKey) {
+    if (html.empty()) {
+        logToFile("HTML内容为空，无法加密", LogLevel::ERROR);
+        return std::nullopt;
+    }
+
+    // 定义变量保存加密结果（按规则出现顺序）
+    std::vector<EncryptedEntry> result;
+
+    LexborDocument doc(html);
+    auto docRoot = doc.root();
+    if (!docRoot) {
+        logToFile("HTML文档创建失败", LogLevel::ERROR);
+        return std::nullopt;
+    }
+    // 替换片段模板，生命周期不超过 doc
+    LexborFragmentCache fragments;
+    // 本文档内按密码复用的加密器
+    EncryptorCache encryptors;
+
+    for (const auto &item : rules) {
+        logToFile("处理加密配置: name=" + item.name +
+                  ", selector=" + item.selector +
+                  ", replace=" + (item.replace ? "true" : "false") +
+                  ", selectAll=" + (item.selectAll ? "true" : "false") +
+                  ", password=" + item.password, LogLevel::DEBUG);
+
+        if (item.selectAll){
+            std::vector<std::shared_ptr<LexborNode>> nodes = docRoot->querySelectorAll(item.selector);
+            if (nodes.empty()) continue;
+            EncryptedEntry &entry = entryFor(result, item.name);
+            entry.isArray = true;
+            processNodes(defaultPassword, extraPasswords, nodes, item, pool, fragments, encryptors, deterministic,
+                         kdfIterations, siteKey.salt, assets, entry);
+        } else {
+            std::shared_ptr<LexborNode> node = docRoot->querySelector(item.selector);
+            if (!node) {
+                logToFile("未找到匹配节点: name=" + item.name + ", selector=" + item.selector, LogLevel::WARN);
+                continue;
+            }
+            EncryptedEntry &entry = entryFor(result, item.name);
+            entry.isArray = false;
+            entry.values.clear();
+            entry.pending.clear();
+            processNodes(defaultPassword, extraPasswords, {node}, item, pool, fragments, encryptors, deterministic,
+                         kdfIterations, siteKey.salt, assets, entry);
+        }
+    }
+
+    // 收集加密结果（等待期间当前线程也参与执行加密任务）
+    for (auto &entry : result) {
+        for (auto &future : entry.pending) {
+            entry.values.push_back(pool ? pool->wait(future) : future.get());
+        }
+        entry.pending.clear();
+    }
+
+    // 写入加密数据
+    auto headNode = docRoot->querySelector("head");
+    if (headNode) {
+        headNode->appendElement("script", {}, buildEncryptDataScript(result));
+        headNode->appendElement("script", {}, ENCRYPT_JS);
+        if (siteKey.enabled()) headNode->appendElement("script", {}, buildSiteKeyScript(siteKey));
+    } else {
+        cerr << "未找到<head>节点，无法写入加密数据。" << endl;
+        logToFile("未找到<head>节点，无法写入加密数据。", LogLevel::ERROR);
+        return std::nullopt;
+    }
+    return docRoot->getHtml();
+}
+
+HtmlPlan planHtml(const std::string &html,
+                  const std::vector<EncryptedItem> &rules,
+                  const std::string &defaultPassword,
+                  const std::vector<std::string> &extraPasswords,
+                  const AssetResolver &assets,
+                  const SiteKey &siteKey) {
+    HtmlPlan plan;
+    plan.inputBytes = html.size();
+    if (html.empty()) return plan;
+
+    LexborDocument doc(html);
+    auto docRoot = doc.root();
+    if (!docRoot) return plan;
+    LexborFragmentCache fragments;
+
+    // 与 encryptHtml 相同的规则顺序与替换，只是用空字符串代替密文，密文长度另外记录
+    std::vector<EncryptedEntry> entries;
+    std::map<string, std::vector<size_t>> encodedSizes;  // 规则名 -> 各加密块的 base64 字节数
+    std::set<std::vector<string>> passwordSets;  // 本文档内已派生过密钥的密码组合
+    for (const auto &item : rules) {
+        RulePlan rulePlan;
+        rulePlan.name = item.name;
+        std::vector<std::shared_ptr<LexborNode>> nodes;
+        if (item.selectAll) {
+            nodes = docRoot->querySelectorAll(item.selector);
+        } else if (auto node = docRoot->querySelector(item.selector)) {
+            nodes.push_back(node);
+        }
+        rulePlan.matches = nodes.size();
+        if (!nodes.empty()) {
+            EncryptedEntry &entry = entryFor(entries, item.name);
+            entry.isArray = item.selectAll;
+            std::vector<size_t> &sizes = encodedSizes[item.name];
+            if (!item.selectAll) {
+                // 非数组规则覆盖同名规则之前的结果
+                entry.values.clear();
+                sizes.clear();
+            }
+            size_t first = entry.values.size();
+            for (const auto &node : nodes) {
+                std::vector<string> passwords = resolvePasswords(defaultPassword, extraPasswords, node, item);
+                // 与 encryptorFor 一样，每组密码在文档内只派生一次（每个密码一次 PBKDF2）
+                if (passwordSets.insert(passwords).second) rulePlan.derivations += passwords.size();
+                if (assets) rewriteAssetReferences(node, assets);
+                size_t size = node->getHtml().size();
+                size_t encoded = size > 0 ? (encryptedPayloadSize(size, passwords.size()) + 2) / 3 * 4 : 0;
+                rulePlan.plaintextBytes += size;
+                rulePlan.payloadBytes += encoded;
+                entry.values.emplace_back();
+                sizes.push_back(encoded);
+            }
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                replaceNode(nodes[i], item, first + i, fragments);
+            }
+        }
+        plan.rules.push_back(std::move(rulePlan));
+    }
+
+    if (!docRoot->querySelector("head")) return plan;
+    // 注入的 <script></script> 标签：加密数据、解密脚本，以及启用时的站点级密钥
+    static const size_t SCRIPT_TAG_SIZE = sizeof("<script></script>") - 1;
+    plan.outputBytes = docRoot->getHtml().size() + buildEncryptDataScript(entries).size() + ENCRYPT_JS.size() +
+                       2 * SCRIPT_TAG_SIZE;
+    if (siteKey.enabled()) plan.outputBytes += buildSiteKeyScript(siteKey).size() + SCRIPT_TAG_SIZE;
+    for (const auto &entry : encodedSizes) {
+        for (size_t size : entry.second) plan.outputBytes += size;
+    }
+    plan.ok = true;
+    return plan;
+}
+
+const std::vector<EncryptedItem> &articleRules(const EncryptConfig &config, const ArticleItem &article) {
+    return article.all ? config.encryptedAll : config.encryptedPartial;
+}
+
+std::string articleDefaultPassword(const EncryptConfig &config, const ArticleItem &article) {
+    if (article.password.empty()) {
+        return config.defaultPassword;
+    }
+    return article.password;
+}
+
+DeterministicKey articleDeterministicKey(const EncryptConfig &config, const ArticleItem &article) {
+    DeterministicKey key;
+    key.secret = config.siteSecret;
+    key.scope = article.uniqueID.empty() ? article.filePath : article.uniqueID;
+    return key;
+}
+
+unsigned int articleKdfIterations(const EncryptConfig &config, const ArticleItem &article) {
+    if (article.kdfIterations != 0) return article.kdfIterations;
+    if (config.kdfIterations != 0) return config.kdfIterations;
+    return DEFAULT_KDF_ITERATIONS;
+}
+
+SiteKey configSiteKey(const EncryptConfig &config) {
+    SiteKey siteKey;
+    if (!config.siteKey) return siteKey;
+    siteKey.salt = config.siteKey->salt.empty() ? deriveSiteSalt(config.siteSecret) : base64Decode(config.siteKey->salt);
+    siteKey.maxAge = config.siteKey->maxAge;
+    return siteKey;
+}
+
+std::vector<std::string> articleExtraPasswords(const EncryptConfig &config, const ArticleItem &article) {
+    std::vector<std::string> passwords = config.passwords;
+    passwords.insert(passwords.end(), article.passwords.begin(), article.passwords.end());
+    return passwords;
+}
+
+std::optional<std::string> processArticle(const EncryptConfig &config,
+                                          const ArticleItem &article,
+                                          const std::string &html,
+                                          ThreadPool *pool,
+                                          const AssetResolver &assets) {
+    // 根据配置选取加密配置（整篇/局部）
+    const std::vector<EncryptedItem> &rules = articleRules(config, article);
+
+    // 多篇文章并行处理时整段输出，避免行间交错
+    std::ostringstream out;
+    for (const auto &item : rules) {
+        out << "处理加密配置: name=" << item.name
+            << ", selector=" << item.selector
+            << ", replace=" << (item.replace ? "true" : "false")
+            << ", selectAll=" << (item.selectAll ? "true" : "false")
+            << ", password=" << item.password
+            << "\n";
+    }
+    cout << out.str() << flush;
+
+    return encryptHtml(html, rules, articleDefaultPassword(config, article), pool,
+                       articleExtraPasswords(config, article), articleDeterministicKey(config, article),
+                       articleKdfIterations(config, article), assets, configSiteKey(config));
+}
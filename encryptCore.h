@@ -0,0 +1,199 @@
+﻿#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include "aceEncrypt.h"
+#include "encryptConfig.h"
+#include "threadPool.h"
+
+class LexborNode;
+
+/**
+ * reimuencrypt_core：与文件系统无关的加密核心
+ *
+ * 所有接口均为可重入的：不依赖全局状态，输入输出都在内存中完成，
+ * 可以在多个线程中同时调用（每次调用使用独立的DOM文档），也可以共享同一个线程池。
+ */
+
+/**
+ * 注入页面<head>末尾的解密运行时脚本（纯JS代码，不含<script>标签）
+ */
+extern const std::string ENCRYPT_JS;
+
+/**
+ * 恢复锚点：整体替换（replace.innerHTML 为 false）的节点在页面中留下
+ * <!--reimu:规则名:下标--> 替换内容 <!--/reimu-->，--restore 据此把解密后的节点放回原处。
+ * 下标为节点在 __ENCRYPT_DATA__ 对应规则中的位置（非数组的规则为 0）。
+ *
+ * @param name 规则名（字母数字、'_'、'.' 以外的字符按百分号编码）
+ * @param index 下标
+ * @return 起始注释的内容
+ */
+std::string restoreAnchor(const std::string& name, size_t index);
+
+/**
+ * 恢复锚点结束注释的内容
+ */
+extern const std::string RESTORE_ANCHOR_END;
+
+/**
+ * 加密块中引用的本地资源加密后的位置与密钥
+ */
+struct AssetRef {
+    std::string url;   ///< 加密文件的URL（写入页面时原样使用）
+    std::string key;   ///< 资源密钥（base64）
+    std::string type;  ///< MIME类型，解密后生成 Blob 时使用
+};
+
+/**
+ * 资源解析器：给定加密块中的本地URL（属性原值），返回加密后的资源，不需要加密时返回 std::nullopt
+ *
+ * 在处理DOM的线程中调用；多篇文章并行处理时会被同时调用，必须是线程安全的。
+ */
+using AssetResolver = std::function<std::optional<AssetRef>(const std::string& url)>;
+
+/**
+ * 撤销资源引用的改写（--restore）：把 data-reimu-<属性> 改回原属性，加密URL去掉 suffix
+ *
+ * 加密时删除的 srcset 与URL中的查询串、片段无法还原。
+ *
+ * @param node 要处理的节点（含其后代元素）
+ * @param suffix 加密文件名的后缀（AssetConfig::suffix）
+ * @return 被还原的引用，url 为加密后的URL、key 为资源密钥
+ */
+std::vector<AssetRef> restoreAssetReferences(const std::shared_ptr<LexborNode>& node, const std::string& suffix);
+
+/**
+ * 站点级密钥：全站的 PBKDF2 使用同一个盐值，同一密码在每个页面派生出同一密钥
+ *
+ * 盐值与保存时长写入页面的 __ENCRYPT_SITE_KEY__，解密脚本把派生出的密钥（不可导出的 CryptoKey）
+ * 保存在 IndexedDB 中，在有效期内打开其他加密页面时无需再次输入密码与派生。
+ */
+struct SiteKey {
+    std::string salt;         ///< 16字节盐值，为空时不启用
+    unsigned int maxAge = 0;  ///< 浏览器保存派生密钥的秒数，0 表示不保存
+
+    bool enabled() const { return !salt.empty(); }
+};
+
+/**
+ * 按加密规则处理一段HTML
+ *
+ * 对每条规则选中的节点进行AES加密并按配置替换，然后在<head>末尾写入
+ * __ENCRYPT_DATA__ 数据与解密脚本。
+ *
+ * @param html 原始HTML内容
+ * @param rules 加密规则（encrypted-all / encrypted-partial 中的项）
+ * @param defaultPassword 规则未能从页面中取得密码时使用的密码
+ * @param pool 用于并发加密节点的线程池，为 nullptr 时在当前线程串行加密
+ * @param extraPasswords 额外密码：每个加密块同样可以用这些密码解密（内容只加密一次，
+ *                       每个密码只增加一个密钥包装）
+ * @param deterministic 确定性加密的密钥材料：启用时相同输入得到逐字节相同的输出
+ * @param kdfIterations PBKDF2 迭代次数，写入每个加密块的头部
+ * @param assets 资源解析器：加密前把节点内 img/video/audio/source/track/a/object/embed 引用的本地资源
+ *               改写为 data-reimu-* 属性（"密钥 类型 加密URL"），由解密脚本取回并解密；为空时不改写
+ * @param siteKey 站点级密钥，启用时所有加密块使用站点盐值，并在解密脚本之后写入 __ENCRYPT_SITE_KEY__
+ * @return 加密后的HTML，HTML为空或缺少<head>节点时返回std::nullopt
+ */
+std::optional<std::string> encryptHtml(const std::string& html,
+                                       const std::vector<EncryptedItem>& rules,
+                                       const std::string& defaultPassword,
+                                       ThreadPool* pool = nullptr,
+                                       const std::vector<std::string>& extraPasswords = {},
+                                       const DeterministicKey& deterministic = DeterministicKey(),
+                                       unsigned int kdfIterations = DEFAULT_KDF_ITERATIONS,
+                                       const AssetResolver& assets = AssetResolver(),
+                                       const SiteKey& siteKey = SiteKey());
+
+/**
+ * 单条规则在一个页面上的加密计划
+ */
+struct RulePlan {
+    std::string name;           ///< 规则名
+    size_t matches = 0;         ///< 选中的节点数
+    size_t plaintextBytes = 0;  ///< 待加密的明文字节数（节点HTML快照之和）
+    size_t payloadBytes = 0;    ///< 写入 __ENCRYPT_DATA__ 的 base64 字节数
+    size_t derivations = 0;     ///< 由本规则引入的 PBKDF2 次数（文档内首次出现的密码组合，每个密码一次）
+};
+
+/**
+ * 单个页面的加密计划
+ */
+struct HtmlPlan {
+    bool ok = false;             ///< 页面可以加密（能解析且有<head>节点）
+    std::vector<RulePlan> rules; ///< 与传入的规则一一对应
+    size_t inputBytes = 0;       ///< 原始页面字节数
+    size_t outputBytes = 0;      ///< 加密后页面的字节数（含站点级密钥脚本与资源引用的改写，随机IV下精确，不含BOM）
+};
+
+/**
+ * 加密的演练（--plan）：与 encryptHtml 相同地匹配与替换节点并测量明文，但不派生密钥、不加密
+ *
+ * 替换在内存中的DOM上完成，因此后续规则的匹配结果与真正加密时一致。
+ *
+ * @param html 原始HTML内容
+ * @param rules 加密规则
+ * @param defaultPassword 规则未能从页面中取得密码时使用的密码
+ * @param extraPasswords 额外密码
+ * @param assets 与加密时相同地改写资源引用（应返回与真实密钥等长的引用，见 AssetRegistry::preview），为空时不改写
+ * @param siteKey 站点级密钥，启用时计入注入的 __ENCRYPT_SITE_KEY__ 脚本
+ * @return 加密计划
+ */
+HtmlPlan planHtml(const std::string& html,
+                  const std::vector<EncryptedItem>& rules,
+                  const std::string& defaultPassword,
+                  const std::vector<std::string>& extraPasswords = {},
+                  const AssetResolver& assets = AssetResolver(),
+                  const SiteKey& siteKey = SiteKey());
+
+/**
+ * 根据 article.all 选取文章使用的加密规则（整篇/局部）
+ */
+const std::vector<EncryptedItem>& articleRules(const EncryptConfig& config, const ArticleItem& article);
+
+/**
+ * 文章的默认密码：优先使用文章密码，否则使用全局默认密码
+ */
+std::string articleDefaultPassword(const EncryptConfig& config, const ArticleItem& article);
+
+/**
+ * 文章的确定性加密密钥材料：配置中的 siteSecret 与文章的 uniqueID（为空时使用文件路径）
+ */
+DeterministicKey articleDeterministicKey(const EncryptConfig& config, const ArticleItem& article);
+
+/**
+ * 文章的 PBKDF2 迭代次数：文章 kdfIterations -> 全局 kdfIterations -> 默认值
+ */
+unsigned int articleKdfIterations(const EncryptConfig& config, const ArticleItem& article);
+
+/**
+ * 站点级密钥：配置了 siteKey 时使用其盐值（为空时由 siteSecret 派生），未配置时返回未启用的 SiteKey
+ */
+SiteKey configSiteKey(const EncryptConfig& config);
+
+/**
+ * 文章的额外密码：全局 passwords 与文章 passwords 的合并
+ */
+std::vector<std::string> articleExtraPasswords(const EncryptConfig& config, const ArticleItem& article);
+
+/**
+ * 按配置处理单篇文章
+ *
+ * 根据 article.all 选择整篇/局部加密规则，按"文章密码 -> 全局默认密码"确定默认密码，
+ * 配置了 siteSecret 时使用确定性加密，配置了 siteKey 时使用站点级盐值，再调用 encryptHtml。
+ *
+ * @param config 加密配置
+ * @param article 文章配置
+ * @param html 文章的HTML内容
+ * @param pool 用于并发加密节点的线程池，为 nullptr 时串行加密
+ * @param assets 资源解析器（见 encryptHtml），为空时不改写资源引用
+ * @return 加密后的HTML，失败返回std::nullopt
+ */
+std::optional<std::string> processArticle(const EncryptConfig& config,
+                                          const ArticleItem& article,
+                                          const std::string& html,
+                                          ThreadPool* pool = nullptr,
+                                          const AssetResolver& assets = AssetResolver());
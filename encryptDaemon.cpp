@@ -0,0 +1,377 @@
+﻿#include "encryptDaemon.h"
+
+#include <iostream>
+#include "tool.h"
+
+using namespace std;
+
+#ifdef _WIN32
+
+int runDaemon(const DaemonOptions& options) {
+    (void)options;
+    cerr << "错误: 守护进程模式暂不支持Windows" << endl;
+    logToFile("守护进程模式暂不支持Windows", LogLevel::ERROR);
+    return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <optional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "siteJob.h"
+
+// 单行请求的最大长度
+static const size_t MAX_REQUEST_LINE = 1024 * 1024;
+
+static std::atomic<bool> stopRequested(false);
+
+static void handleStopSignal(int) {
+    stopRequested = true;
+}
+
+// 已加载的配置，按路径缓存，文件修改后重新加载
+class ConfigCache {
+public:
+    std::optional<EncryptConfig> load(const fs::path& path) {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) return std::nullopt;
+        uintmax_t size = fs::file_size(path, ec);
+        if (ec) return std::nullopt;
+
+        std::string key = path.lexically_normal().string();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end() && it->second.mtime == mtime && it->second.size == size) {
+                return it->second.config;
+            }
+        }
+        auto config = loadEncryptConfig(path.string());
+        if (!config) return std::nullopt;
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[key] = Entry{mtime, size, *config};
+        return config;
+    }
+
+private:
+    struct Entry {
+        fs::file_time_type mtime;
+        uintmax_t size;
+        EncryptConfig config;
+    };
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+};
+
+// 所有连接共享的常驻状态
+struct DaemonState {
+    explicit DaemonState(const DaemonOptions& options)
+        : ioBackend(options.ioBackend),
+          precompress(options.precompress),
+          pool(ThreadPool::defaultConcurrency(options.jobs) - 1),
+          governor(options.maxMemory) {}
+
+    IoBackend ioBackend;
+    PrecompressOptions precompress;
+    ThreadPool pool;
+    MemoryGovernor governor;
+    ConfigCache configs;
+};
+
+// 单个客户端连接：按行读取请求，按行写回结果
+class Connection {
+public:
+    Connection(int fd, DaemonState& state) : fd_(fd), state_(state) {}
+    ~Connection() { close(fd_); }
+
+    void run() {
+        std::string line;
+        while (readLine(line)) {
+            if (trim(line).empty()) continue;
+            if (!handleRequest(line)) break;
+        }
+    }
+
+private:
+    // 读取一行（不含换行符），连接关闭、出错或守护进程停止时返回 false
+    bool readLine(std::string& line) {
+        while (true) {
+            size_t pos = buffer_.find('\n');
+            if (pos != std::string::npos) {
+                line = buffer_.substr(0, pos);
+                buffer_.erase(0, pos + 1);
+                return true;
+            }
+            if (buffer_.size() > MAX_REQUEST_LINE) {
+                send({{"type", "error"}, {"message", "请求过长"}});
+                return false;
+            }
+            pollfd pfd{fd_, POLLIN, 0};
+            int ready = poll(&pfd, 1, 200);
+            if (stopRequested) return false;
+            if (ready < 0 && errno != EINTR) return false;
+            if (ready <= 0) continue;
+            char chunk[64 * 1024];
+            ssize_t n = read(fd_, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buffer_.append(chunk, (size_t)n);
+        }
+    }
+
+    // 写回一行JSON
+    void send(const nlohmann::json& message) {
+        std::string data = message.dump() + "\n";
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t n = write(fd_, data.data() + offset, data.size() - offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;  // 客户端已断开，任务继续完成
+            offset += (size_t)n;
+        }
+    }
+
+    // 处理一条请求，返回 false 表示关闭连接
+    bool handleRequest(const std::string& line) {
+        nlohmann::json request = nlohmann::json::parse(line, nullptr, false);
+        if (request.is_discarded() || !request.is_object()) {
+            send({{"type", "error"}, {"message", "请求不是合法的JSON对象"}});
+            return true;
+        }
+        nlohmann::json id = request.value("id", nlohmann::json());
+        std::string invalid = requestError(request);
+        if (!invalid.empty()) {
+            send({{"id", id}, {"type", "error"}, {"message", invalid}});
+            return true;
+        }
+
+        try {
+            if (request.value("command", "") == "shutdown") {
+                logToFile("守护进程收到停止请求", LogLevel::INFO);
+                stopRequested = true;
+                send({{"id", id}, {"type", "done"}, {"ok", true}});
+                return false;
+            }
+            runJob(request, id);
+        } catch (const std::exception& e) {
+            logToFile(std::string("守护进程任务失败: ") + e.what(), LogLevel::ERROR);
+            send({{"id", id}, {"type", "error"}, {"message", e.what()}});
+        }
+        return true;
+    }
+
+    /**
+     * 检查请求中各字段的类型，避免 get/value 在连接线程中抛出异常
+     *
+     * @param request 请求对象
+     * @return 字段类型错误时返回错误信息，否则返回空字符串
+     */
+    static std::string requestError(const nlohmann::json& request) {
+        for (const char* key : {"command", "mode", "config", "root", "precompress"}) {
+            if (request.contains(key) && !request[key].is_string()) {
+                return std::string("请求字段 ") + key + " 必须是字符串";
+            }
+        }
+        if (request.contains("keepConfig") && !request["keepConfig"].is_boolean()) {
+            return "请求字段 keepConfig 必须是布尔值";
+        }
+        if (request.contains("files")) {
+            const nlohmann::json& files = request["files"];
+            if (!files.is_array() ||
+                !std::all_of(files.begin(), files.end(), [](const nlohmann::json& file) { return file.is_string(); })) {
+                return "请求字段 files 必须是字符串数组";
+            }
+        }
+        return "";
+    }
+
+    void runJob(const nlohmann::json& request, const nlohmann::json& id) {
+        std::string mode = request.value("mode", "encrypt");
+        if (mode != "encrypt" && mode != "verify" && mode != "restore" && mode != "plan") {
+            send({{"id", id}, {"type", "error"}, {"message", "未知的 mode: " + mode}});
+            return;
+        }
+
+        SiteJob job;
+        job.ioBackend = state_.ioBackend;
+        job.precompress = state_.precompress;
+        if (request.contains("precompress") &&
+            !parsePrecompress(request["precompress"].get<std::string>(), job.precompress)) {
+            send({{"id", id}, {"type", "error"}, {"message", "未知的 precompress 格式，可选 gz,br,all"}});
+            return;
+        }
+        if (request.contains("config")) {
+            job.jsonFilePath = request["config"].get<std::string>();
+            job.rootDir = job.jsonFilePath.parent_path();
+        } else if (request.contains("root")) {
+            job.rootDir = request["root"].get<std::string>();
+            job.jsonFilePath = job.rootDir / "encrypt.json";
+        } else {
+            send({{"id", id}, {"type", "error"}, {"message", "请求需要 root 或 config"}});
+            return;
+        }
+        if (request.contains("root")) {
+            job.rootDir = request["root"].get<std::string>();
+        }
+
+        auto config = state_.configs.load(job.jsonFilePath);
+        if (!config) {
+            send({{"id", id}, {"type", "error"}, {"message", "读取加密配置失败: " + job.jsonFilePath.string()}});
+            return;
+        }
+        job.config = std::move(*config);
+
+        // 只处理指定文件时按完整路径筛选文章
+        std::vector<ArticleItem> articles;
+        bool partial = request.contains("files");
+        if (partial) {
+            std::vector<std::string> wanted;
+            for (const auto& file : request["files"]) {
+                wanted.push_back((job.rootDir / file.get<std::string>()).lexically_normal().string());
+            }
+            for (const auto& article : job.config.articles) {
+                std::string path = (job.rootDir / fs::path(article.filePath)).lexically_normal().string();
+                if (std::find(wanted.begin(), wanted.end(), path) != wanted.end()) {
+                    articles.push_back(article);
+                }
+            }
+        } else {
+            articles = job.config.articles;
+        }
+
+        logToFile("守护进程任务: " + job.jsonFilePath.string() + " mode=" + mode +
+                  " 文章数=" + std::to_string(articles.size()), LogLevel::INFO);
+
+        size_t files = 0, failed = 0;
+        job.onResult = [&](const FileResult& result) {
+            ++files;
+            if (!result.ok) ++failed;
+            nlohmann::json message = {{"id", id}, {"type", "file"}, {"path", result.path}, {"ok", result.ok}};
+            if (!result.message.empty()) message["message"] = result.message;
+            send(message);
+        };
+
+        // 派生密钥只在本任务内缓存，任务结束即释放，不在常驻进程中累积密码派生出的密钥
+        KeyCache keyCache;
+        auto start = std::chrono::steady_clock::now();
+        if (mode == "verify") {
+            verifyArticles(job, articles, state_.pool, keyCache);
+        } else if (mode == "restore") {
+            restoreArticles(job, articles, state_.pool, keyCache);
+        } else if (mode == "plan") {
+            send({{"id", id}, {"type", "plan"}, {"report", planArticles(job, articles, state_.pool)}});
+        } else {
+            processArticles(job, articles, state_.pool, state_.governor);
+            // 只处理部分文件的任务（增量构建）不改写全站文件，由完整站点的任务清理
+            if (!partial) scrubSiteFiles(job, state_.pool);
+            if (!partial && !request.value("keepConfig", false)) {
+                removeEncryptConfigFile(job.jsonFilePath);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        send({{"id", id}, {"type", "done"}, {"ok", failed == 0}, {"files", files}, {"failed", failed},
+              {"seconds", seconds}});
+    }
+
+    int fd_;
+    DaemonState& state_;
+    std::string buffer_;
+};
+
+int runDaemon(const DaemonOptions& options) {
+    sockaddr_un addr{};
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "错误: 套接字路径为空或过长: " << options.socketPath << endl;
+        return 1;
+    }
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        cerr << "错误: 创建套接字失败" << endl;
+        logToFile("创建套接字失败", LogLevel::ERROR);
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::copy(options.socketPath.begin(), options.socketPath.end(), addr.sun_path);
+
+    // 清理上次异常退出留下的套接字文件
+    struct stat st;
+    if (stat(options.socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(options.socketPath.c_str());
+    }
+    // 只允许当前用户连接：套接字文件在 bind 时就以 0600 创建，不存在其他用户可以连接的窗口
+    mode_t previousMask = umask(077);
+    bool bound = bind(listenFd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(previousMask);
+    if (!bound || listen(listenFd, 16) != 0) {
+        cerr << "错误: 无法监听套接字 " << options.socketPath << endl;
+        logToFile("无法监听套接字 " + options.socketPath, LogLevel::ERROR);
+        close(listenFd);
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    DaemonState state(options);
+    cout << "守护进程已启动: " << options.socketPath << "（并发线程数 "
+         << state.pool.size() + 1 << "）" << endl;
+    logToFile("守护进程已启动: " + options.socketPath, LogLevel::INFO);
+
+    struct ConnectionThread {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+    std::vector<ConnectionThread> connections;
+    while (!stopRequested) {
+        // 回收已结束的连接线程
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (*it->finished) {
+                it->thread.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) continue;
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        std::thread thread([clientFd, &state, finished]() {
+            Connection(clientFd, state).run();
+            *finished = true;
+        });
+        connections.push_back({std::move(thread), finished});
+    }
+
+    close(listenFd);
+    unlink(options.socketPath.c_str());
+    // 等待正在执行的任务完成
+    for (auto& connection : connections) {
+        connection.thread.join();
+    }
+    cout << "守护进程已停止" << endl;
+    logToFile("守护进程已停止", LogLevel::INFO);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,40 @@
+﻿#pragma once
+#include <string>
+
+#include "batchIO.h"
+#include "precompress.h"
+
+/**
+ * 守护进程参数
+ */
+struct DaemonOptions {
+    std::string socketPath;                 ///< Unix 域套接字路径
+    IoBackend ioBackend = IoBackend::AUTO;  ///< 批量文件读写后端
+    size_t jobs = 0;                        ///< 并发线程数，0 表示使用硬件线程数
+    size_t maxMemory = 0;                   ///< 所有任务共享的内存预算，0 表示不限制
+    PrecompressOptions precompress;         ///< 默认的预压缩格式，请求中的 "precompress" 可覆盖
+};
+
+/**
+ * 以守护进程模式运行：监听 Unix 域套接字，接收以换行分隔的JSON任务
+ *
+ * 请求（每行一个）：
+ *   {"id": "1", "root": "/site"}                              站点根目录下的 encrypt.json
+ *   {"id": "2", "config": "/site/encrypt.json",
+ *    "files": ["posts/a/index.html"], "mode": "verify"}       只处理指定文件；mode 为 encrypt（默认）、verify、restore 或 plan
+ *   {"id": "3", "root": "/site", "precompress": "gz,br"}      同时写出 .gz/.br 兄弟文件
+ *   {"command": "shutdown"}                                   停止守护进程
+ *
+ * 响应（每行一个，同一连接内按任务顺序）：
+ *   {"id": "1", "type": "file", "path": "...", "ok": true}
+ *   {"id": "1", "type": "done", "ok": true, "files": 10, "failed": 0, "seconds": 0.5}
+ *   {"id": "1", "type": "plan", "report": {...}}           plan 任务在 done 之前发送报告
+ *   {"id": "1", "type": "error", "message": "..."}
+ *
+ * 不同连接的任务并发执行，共享同一个线程池与内存预算；派生密钥缓存属于单个任务，
+ * 任务结束即释放。线程池工作线程的选择器缓存在任务之间保持有效。完整站点的加密任务完成后
+ * 与命令行一样删除配置文件，请求中 "keepConfig": true 时保留。
+ *
+ * @return 进程退出码
+ */
+int runDaemon(const DaemonOptions& options);
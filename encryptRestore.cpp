@@ -0,0 +1,159 @@
+﻿#include <map>
+#include <set>
+
+#include "encryptCore.h"
+#include "encryptRestore.h"
+#include "encryptVerify.h"
+#include "praseHtml.h"
+#include "tool.h"
+
+using namespace std;
+
+// 数据脚本与解密脚本的内容特征
+static const std::string DATA_SCRIPT_PREFIX = "var __ENCRYPT_DATA__ = ";
+static const std::string RUNTIME_SCRIPT_MARKER = "async function encrypt(";
+static const std::string SITE_KEY_SCRIPT_PREFIX = "var __ENCRYPT_SITE_KEY__ = ";
+
+// 移除 encryptHtml 注入到 <head> 末尾的数据脚本及其后的解密脚本与站点级密钥脚本
+static bool removeInjectedScripts(const std::shared_ptr<LexborNode>& root) {
+    for (const auto& script : root->querySelectorAll("head > script")) {
+        if (script->getContent().compare(0, DATA_SCRIPT_PREFIX.size(), DATA_SCRIPT_PREFIX) != 0) continue;
+        auto runtime = script->nextElementSibling();
+        if (runtime && runtime->getContent().find(RUNTIME_SCRIPT_MARKER) != std::string::npos) {
+            auto siteKey = runtime->nextElementSibling();
+            if (siteKey && siteKey->getContent().compare(0, SITE_KEY_SCRIPT_PREFIX.size(), SITE_KEY_SCRIPT_PREFIX) == 0) {
+                siteKey->remove();
+            }
+            runtime->remove();
+        }
+        script->remove();
+        return true;
+    }
+    return false;
+}
+
+PageRestore restoreHtml(const std::string& html,
+                        const std::vector<EncryptedItem>& rules,
+                        const std::string& defaultPassword,
+                        KeyCache* cache,
+                        const std::string& assetSuffix) {
+    PageRestore result;
+    auto data = extractEncryptData(html);
+    if (!data || !data->is_object()) {
+        result.message = "未找到 __ENCRYPT_DATA__";
+        return result;
+    }
+
+    // 同名规则的结果在加密时会合并，无法区分各自的节点
+    std::set<std::string> names;
+    for (const auto& rule : rules) {
+        if (!names.insert(rule.name).second) {
+            result.message = "规则名重复: " + rule.name;
+            return result;
+        }
+    }
+
+    // 先解密全部块，任何一块失败都不修改页面
+    std::map<std::string, std::vector<std::string>> plaintexts;
+    for (const auto& rule : rules) {
+        auto it = data->find(rule.name);
+        if (it == data->end()) continue;  // 加密时没有匹配到节点
+        std::vector<std::string> values;
+        if (it->is_string()) {
+            values.push_back(it->get<std::string>());
+        } else if (it->is_array()) {
+            for (const auto& item : *it) {
+                if (!item.is_string()) {
+                    result.message = "规则=" + rule.name + ": 加密数据格式不正确";
+                    return result;
+                }
+                values.push_back(item.get<std::string>());
+            }
+        } else {
+            result.message = "规则=" + rule.name + ": 加密数据格式不正确";
+            return result;
+        }
+        std::vector<std::string>& blocks = plaintexts[rule.name];
+        for (size_t i = 0; i < values.size(); ++i) {
+            std::string plaintext;
+            // 空字符串表示加密时节点内容为空
+            if (!values[i].empty()) {
+                plaintext = AesDecrypt(base64Decode(values[i]), defaultPassword, cache);
+                if (plaintext.empty()) {
+                    result.message = "规则=" + rule.name + "[" + std::to_string(i) + "]: " +
+                                     (rule.password.empty() ? "解密失败（密码错误或数据损坏）"
+                                                            : "密码来自页面元素，无法使用配置密码解密");
+                    return result;
+                }
+            }
+            blocks.push_back(std::move(plaintext));
+        }
+    }
+
+    LexborDocument doc(html);
+    auto root = doc.root();
+    if (!root) {
+        result.message = "HTML文档创建失败";
+        return result;
+    }
+
+    // 逆序撤销各规则的替换：后一条规则的快照中包含前面规则的替换结果
+    for (auto rule = rules.rbegin(); rule != rules.rend(); ++rule) {
+        auto found = plaintexts.find(rule->name);
+        if (found == plaintexts.end() || !rule->replace) continue;
+        const std::vector<std::string>& blocks = found->second;
+
+        if (rule->replace->innerHTML) {
+            // 节点本身仍在页面中：按选择器找回，用加密时的完整节点替换
+            std::vector<std::shared_ptr<LexborNode>> nodes;
+            if (rule->selectAll) {
+                nodes = root->querySelectorAll(rule->selector);
+            } else if (auto node = root->querySelector(rule->selector)) {
+                nodes.push_back(node);
+            }
+            if (nodes.size() != blocks.size()) {
+                result.message = "规则=" + rule->name + ": 选择器匹配到 " + std::to_string(nodes.size()) +
+                                 " 个节点，加密块 " + std::to_string(blocks.size()) + " 个";
+                return result;
+            }
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                nodes[i]->setOuterHtml(blocks[i]);
+            }
+            result.blocks += blocks.size();
+            continue;
+        }
+
+        // 整体替换：按恢复锚点放回。锚点可能位于刚恢复的后续规则的节点中，因此每条规则重新查找；
+        // 嵌套在同一规则其他节点中的节点随外层节点一起恢复，没有自己的锚点
+        std::string prefix = restoreAnchor(rule->name, 0);
+        prefix.resize(prefix.rfind(':') + 1);
+        std::map<std::string, std::shared_ptr<LexborNode>> anchors;
+        for (auto& comment : root->findComments(prefix)) {
+            anchors.emplace(std::move(comment.first), std::move(comment.second));
+        }
+        size_t restored = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            auto anchor = anchors.find(restoreAnchor(rule->name, i));
+            if (anchor == anchors.end()) continue;
+            if (!anchor->second->replaceThroughComment(RESTORE_ANCHOR_END, blocks[i])) {
+                result.message = "规则=" + rule->name + "[" + std::to_string(i) + "]: 恢复锚点不完整";
+                return result;
+            }
+            ++restored;
+        }
+        if (restored == 0) {
+            result.message = "规则=" + rule->name + ": 缺少恢复锚点（页面由旧版本加密，请重新构建）";
+            return result;
+        }
+        result.blocks += blocks.size();
+    }
+
+    if (!removeInjectedScripts(root)) {
+        result.message = "未找到注入的 __ENCRYPT_DATA__ 脚本";
+        return result;
+    }
+    // 解密脚本已移除，资源引用必须改回普通属性；资源文件由调用方解密回原位置
+    result.assets = restoreAssetReferences(root, assetSuffix);
+    result.html = root->getHtml();
+    return result;
+}
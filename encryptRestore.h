@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "aceEncrypt.h"
+#include "encryptConfig.h"
+#include "encryptCore.h"
+
+/**
+ * 单个页面的恢复结果
+ */
+struct PageRestore {
+    std::optional<std::string> html;  ///< 恢复后的HTML，失败时为空（页面不应被改写）
+    std::string message;              ///< 失败原因
+    size_t blocks = 0;                ///< 解密并放回的加密块数
+    std::vector<AssetRef> assets;     ///< 已还原引用的加密资源（url 为加密文件的URL），由调用方解密回原文件
+};
+
+/**
+ * 将已加密页面恢复为明文页面（--restore）
+ *
+ * 用配置中的密码解密 __ENCRYPT_DATA__ 中的全部块，按规则的逆序把原节点放回：
+ * 替换了 innerHTML 的节点按选择器定位，整体替换的节点按恢复锚点定位，未配置替换的节点
+ * 仍在页面中无需处理；最后移除注入的数据与解密脚本，并把改写过的资源引用改回原属性
+ * （见 restoreAssetReferences）。任一块无法解密或定位时整页失败。
+ *
+ * @param html 已加密页面的HTML
+ * @param rules 加密时使用的规则
+ * @param defaultPassword 文章密码或全局默认密码
+ * @param cache 共享的派生密钥缓存
+ * @param assetSuffix 加密资源文件名的后缀
+ * @return 恢复结果
+ */
+PageRestore restoreHtml(const std::string& html,
+                        const std::vector<EncryptedItem>& rules,
+                        const std::string& defaultPassword,
+                        KeyCache* cache,
+                        const std::string& assetSuffix = AssetConfig().suffix);
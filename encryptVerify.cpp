@@ -0,0 +1,255 @@
+﻿#include <algorithm>
+#include <cctype>
+
+#include "encryptVerify.h"
+#include "pagePrefilter.h"
+#include "tool.h"
+
+using namespace std;
+
+std::optional<nlohmann::json> extractEncryptData(const std::string& html) {
+    // 与 encryptHtml 写入的脚本保持一致，脚本内容不会被序列化转义
+    static const std::string marker = "<script>var __ENCRYPT_DATA__ = ";
+    size_t pos = findBytes(html, marker);
+    if (pos == std::string::npos) return std::nullopt;
+    size_t begin = pos + marker.size();
+    size_t end = html.find("</script", begin);
+    if (end == std::string::npos) return std::nullopt;
+    // 去掉末尾的分号与空白
+    while (end > begin && (html[end - 1] == ';' || std::isspace(static_cast<unsigned char>(html[end - 1])))) {
+        --end;
+    }
+    nlohmann::json data = nlohmann::json::parse(html.begin() + begin, html.begin() + end, nullptr, false);
+    if (data.is_discarded()) return std::nullopt;
+    return data;
+}
+
+// 检查是否为合法的UTF-8编码
+static bool isValidUtf8(const std::string& str) {
+    size_t i = 0, len = str.size();
+    while (i < len) {
+        unsigned char c = str[i];
+        size_t n;
+        uint32_t cp;
+        if (c < 0x80) { ++i; continue; }
+        else if ((c & 0xE0) == 0xC0) { n = 1; cp = c & 0x1F; }
+        else if ((c & 0xF0) == 0xE0) { n = 2; cp = c & 0x0F; }
+        else if ((c & 0xF8) == 0xF0) { n = 3; cp = c & 0x07; }
+        else return false;
+        if (i + n >= len) return false;
+        for (size_t k = 1; k <= n; ++k) {
+            unsigned char cc = str[i + k];
+            if ((cc & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+        // 拒绝过长编码、代理区与超出范围的码点
+        if ((n == 1 && cp < 0x80) || (n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000) ||
+            (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) {
+            return false;
+        }
+        i += n + 1;
+    }
+    return true;
+}
+
+static bool isVoidElement(const std::string& tag) {
+    static const char* voids[] = {
+        "area", "base", "br", "col", "embed", "hr", "img", "input", "link", "meta",
+        "source", "track", "wbr", "param", "keygen", "basefont", "bgsound", "frame"
+    };
+    for (const char* v : voids) {
+        if (tag == v) return true;
+    }
+    return false;
+}
+
+static bool isRawTextElement(const std::string& tag) {
+    return tag == "script" || tag == "style" || tag == "textarea" || tag == "title" ||
+           tag == "xmp" || tag == "iframe" || tag == "noembed" || tag == "noframes" ||
+           tag == "plaintext";
+}
+
+bool isWellFormedHtml(const std::string& html) {
+    if (!isValidUtf8(html)) return false;
+
+    std::vector<std::string> stack;
+    size_t i = 0, len = html.size();
+    while (i < len) {
+        size_t lt = html.find('<', i);
+        if (lt == std::string::npos) break;
+        i = lt + 1;
+        if (i >= len) return false;
+
+        if (html.compare(lt, 4, "<!--") == 0) {
+            size_t end = html.find("-->", lt + 4);
+            if (end == std::string::npos) return false;
+            i = end + 3;
+            continue;
+        }
+        if (html[i] == '!' || html[i] == '?') {
+            size_t end = html.find('>', i);
+            if (end == std::string::npos) return false;
+            i = end + 1;
+            continue;
+        }
+
+        bool closing = html[i] == '/';
+        if (closing) ++i;
+        size_t nameBegin = i;
+        while (i < len && !std::isspace(static_cast<unsigned char>(html[i])) && html[i] != '>' && html[i] != '/') ++i;
+        std::string tag = html.substr(nameBegin, i - nameBegin);
+        std::transform(tag.begin(), tag.end(), tag.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (tag.empty()) return false;
+
+        // 跳过属性，引号内的 '>' 不结束标签
+        char quote = 0;
+        bool selfClosing = false;
+        while (i < len) {
+            char c = html[i];
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                selfClosing = i > 0 && html[i - 1] == '/';
+                break;
+            }
+            ++i;
+        }
+        if (i >= len) return false;
+        ++i;
+
+        if (closing) {
+            if (stack.empty() || stack.back() != tag) return false;
+            stack.pop_back();
+        } else if (!selfClosing && !isVoidElement(tag)) {
+            if (isRawTextElement(tag)) {
+                // 原始文本元素的内容不参与标签匹配，直接跳到对应的结束标签
+                std::string endTag = "</" + tag;
+                size_t end = i;
+                for (;;) {
+                    end = html.find("</", end);
+                    if (end == std::string::npos) return false;
+                    std::string candidate = html.substr(end, endTag.size());
+                    std::transform(candidate.begin(), candidate.end(), candidate.begin(),
+                                   [](unsigned char c) { return (char)std::tolower(c); });
+                    if (candidate == endTag) break;
+                    end += 2;
+                }
+                i = end;
+            }
+            stack.push_back(tag);
+        }
+    }
+    return stack.empty();
+}
+
+// 查找与加密数据键名对应的规则
+static const EncryptedItem* findRule(const std::vector<EncryptedItem>& rules, const std::string& name) {
+    for (const auto& rule : rules) {
+        if (rule.name == name) return &rule;
+    }
+    return nullptr;
+}
+
+static BlockCheck checkBlock(const std::string& name, size_t index, const std::string& base64,
+                             const EncryptedItem* rule, const std::string& defaultPassword,
+                             KeyCache* cache) {
+    BlockCheck block;
+    block.name = name;
+    block.index = index;
+    if (base64.empty()) {
+        // 加密时节点内容为空
+        block.ok = true;
+        return block;
+    }
+    std::string encrypted = base64Decode(base64);
+    block.bytes = encrypted.size();
+    bool passwordFromPage = rule && !rule->password.empty();
+    // 先只派生密钥比较校验值，密码不对时不必解密正文
+    KeyCheck check = AesCheckKey(encrypted, defaultPassword, cache);
+    if (check == KeyCheck::MALFORMED) {
+        block.message = "加密数据长度不合法";
+        return block;
+    }
+    if (check == KeyCheck::WRONG_PASSWORD) {
+        if (passwordFromPage) {
+            block.skipped = true;
+            block.message = "密码来自页面元素，无法使用配置密码校验";
+        } else {
+            block.message = "密码错误（密钥校验值不匹配）";
+        }
+        return block;
+    }
+
+    std::string plaintext = AesDecrypt(encrypted, defaultPassword, cache);
+    if (plaintext.empty()) {
+        if (passwordFromPage) {
+            block.skipped = true;
+            block.message = "密码来自页面元素，无法使用配置密码校验";
+        } else {
+            block.message = "解密失败（密码错误或数据损坏）";
+        }
+        return block;
+    }
+    if (!isWellFormedHtml(plaintext)) {
+        // 密钥已通过校验值确认时密码一定正确，结果不完整是数据本身的问题，不能归因于页面密码；
+        // 只有旧格式（无校验值）才可能是错误密码恰好通过了填充检查
+        if (passwordFromPage && check == KeyCheck::UNCHECKED) {
+            block.skipped = true;
+            block.message = "密码来自页面元素，无法使用配置密码校验";
+        } else {
+            block.message = "解密结果不是完整的HTML";
+        }
+        return block;
+    }
+    block.ok = true;
+    return block;
+}
+
+PageCheck verifyHtml(const std::string& html,
+                     const std::vector<EncryptedItem>& rules,
+                     const std::string& defaultPassword,
+                     KeyCache* cache) {
+    PageCheck page;
+    auto data = extractEncryptData(html);
+    if (!data) return page;
+    page.hasData = true;
+    if (!data->is_object()) return page;
+
+    for (auto it = data->begin(); it != data->end(); ++it) {
+        const std::string& name = it.key();
+        const nlohmann::json& value = it.value();
+        const EncryptedItem* rule = findRule(rules, name);
+        if (!rule) {
+            BlockCheck block;
+            block.name = name;
+            block.message = "配置中没有对应的加密规则";
+            page.blocks.push_back(block);
+            continue;
+        }
+        if (value.is_string()) {
+            page.blocks.push_back(checkBlock(name, 0, value.get<std::string>(), rule, defaultPassword, cache));
+        } else if (value.is_array()) {
+            size_t index = 0;
+            for (const auto& item : value) {
+                if (item.is_string()) {
+                    page.blocks.push_back(checkBlock(name, index, item.get<std::string>(), rule, defaultPassword, cache));
+                } else {
+                    BlockCheck block;
+                    block.name = name;
+                    block.index = index;
+                    block.message = "加密数据格式不正确";
+                    page.blocks.push_back(block);
+                }
+                ++index;
+            }
+        } else {
+            BlockCheck block;
+            block.name = name;
+            block.message = "加密数据格式不正确";
+            page.blocks.push_back(block);
+        }
+    }
+    return page;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <nlohmann/json.hpp>
+
+#include "aceEncrypt.h"
+#include "encryptConfig.h"
+
+/**
+ * 单个加密块的校验结果
+ */
+struct BlockCheck {
+    std::string name;        ///< 规则名
+    size_t index = 0;        ///< selectAll 数组中的下标
+    bool ok = false;         ///< 是否成功解密且为合法HTML
+    bool skipped = false;    ///< 密码来自页面元素，无法用配置密码校验
+    std::string message;     ///< 失败原因
+    size_t bytes = 0;        ///< 密文字节数
+};
+
+/**
+ * 单个页面的校验结果
+ */
+struct PageCheck {
+    bool hasData = false;            ///< 是否找到 __ENCRYPT_DATA__
+    std::vector<BlockCheck> blocks;
+};
+
+/**
+ * 在不构建DOM的情况下从HTML中提取 __ENCRYPT_DATA__ 对象
+ *
+ * @param html 已加密页面的HTML
+ * @return 加密数据对象，未找到或无法解析时返回std::nullopt
+ */
+std::optional<nlohmann::json> extractEncryptData(const std::string& html);
+
+/**
+ * 简单检查HTML是否结构完整：合法的UTF-8，且非空元素的开始/结束标签成对出现
+ *
+ * 加密内容来自 Lexbor 序列化结果，总是带有完整的结束标签，
+ * 因此解密后能通过此检查即可认为内容完整。
+ */
+bool isWellFormedHtml(const std::string& html);
+
+/**
+ * 校验页面中所有加密块能否用配置中的密码解密
+ *
+ * @param html 已加密页面的HTML
+ * @param rules 加密时使用的规则
+ * @param defaultPassword 文章密码或全局默认密码
+ * @param cache 共享的派生密钥缓存
+ */
+PageCheck verifyHtml(const std::string& html,
+                     const std::vector<EncryptedItem>& rules,
+                     const std::string& defaultPassword,
+                     KeyCache* cache);
@@ -1,89 +1,712 @@
 /**
  * 解密函数
  * @param {*} base64Data base64编码的加密数据
- * @param {*} password 解密密码
+ * @param {*} password 解密密码（启用站点级密钥时可为空，使用本会话中保存的密钥）
  * @returns {Promise<string>} 解密后的明文数据
  */
 async function encrypt(base64Data, password) {
-  if (!base64Data || !password) {
+  if (!base64Data || (!password && !reimuSiteKey())) {
     throw new Error("请填写加密数据和密码");
   }
+  const results = await decryptBlocks([base64Data], password);
+  return results[0];
+}
+
+/**
+ * 一次解密 __ENCRYPT_DATA__ 中的全部加密块
+ * @param {object} data 形如 __ENCRYPT_DATA__ 的对象，值为base64字符串或其数组
+ * @param {string} password 解密密码（启用站点级密钥时可为空，使用本会话中保存的密钥）
+ * @param {function} [onBlock] 可选，每个块解密完成时调用 onBlock(name, index, html)，可用于逐块显示
+ * @returns {Promise<object>} 与 data 结构相同、值为解密后HTML的对象
+ */
+async function decryptAll(data, password, onBlock) {
+  if (!data || (!password && !reimuSiteKey())) {
+    throw new Error("请填写加密数据和密码");
+  }
+  const blocks = [];
+  const slots = [];
+  for (const name of Object.keys(data)) {
+    const value = data[name];
+    if (Array.isArray(value)) {
+      value.forEach((block, index) => {
+        blocks.push(block);
+        slots.push({ name: name, index: index });
+      });
+    } else {
+      blocks.push(value);
+      slots.push({ name: name, index: -1 });
+    }
+  }
+  const callback = onBlock ? (i, html) => onBlock(slots[i].name, slots[i].index, html) : null;
+  const results = await decryptBlocks(blocks, password, callback);
+  const output = {};
+  slots.forEach((slot, i) => {
+    if (slot.index < 0) {
+      output[slot.name] = results[i];
+    } else {
+      (output[slot.name] = output[slot.name] || [])[slot.index] = results[i];
+    }
+  });
+  return output;
+}
+
+/**
+ * 解密核心：base64解码与解密，既在 Web Worker 中运行，也作为无法创建 Worker 时的回退
+ * @param {object} scope 全局对象（Worker 中为 self，页面中为 window）
+ */
+function reimuDecryptCore(scope) {
+  const subtle = scope.crypto.subtle;
+
+  // 多密码格式："RENC" + 模式(1) + 迭代次数(u32) + 包装数量(1)
+  //   + 每个密码一个包装 [盐值16 + nonce12 + AES-GCM加密的内容密钥32 + 标签16] + IV16 + 密文
+  const MODE_WRAPPED_KEYS = 0x02;
+  const WRAP_SIZE = 76;
+  // 单密码格式："RENC" + 模式(1) + 迭代次数(u32) + 盐值16 + 密钥校验值8 + IV16 + 密文
+  const MODE_KEY_CHECK = 0x03;
+  const KEY_CHECK_HEADER_SIZE = 33;
+
+  const BASE64_TABLE = new Uint8Array(256);
+  const alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (let i = 0; i < alphabet.length; i++) {
+    BASE64_TABLE[alphabet.charCodeAt(i)] = i;
+  }
+
+  // Base64转ArrayBuffer：优先使用原生 Uint8Array.fromBase64，否则按4字符一组查表解码
+  function base64ToArrayBuffer(base64) {
+    if (typeof Uint8Array.fromBase64 === "function") {
+      return Uint8Array.fromBase64(base64).buffer;
+    }
+    let length = base64.length;
+    while (length > 0 && base64.charCodeAt(length - 1) === 61) {
+      length--;
+    }
+    const bytes = new Uint8Array((length * 3) >> 2);
+    let out = 0;
+    let i = 0;
+    for (; i + 4 <= length; i += 4) {
+      const n = (BASE64_TABLE[base64.charCodeAt(i)] << 18) | (BASE64_TABLE[base64.charCodeAt(i + 1)] << 12) |
+        (BASE64_TABLE[base64.charCodeAt(i + 2)] << 6) | BASE64_TABLE[base64.charCodeAt(i + 3)];
+      bytes[out++] = n >> 16;
+      bytes[out++] = (n >> 8) & 255;
+      bytes[out++] = n & 255;
+    }
+    if (length - i >= 2) {
+      const n = (BASE64_TABLE[base64.charCodeAt(i)] << 18) | (BASE64_TABLE[base64.charCodeAt(i + 1)] << 12) |
+        (length - i === 3 ? BASE64_TABLE[base64.charCodeAt(i + 2)] << 6 : 0);
+      bytes[out++] = n >> 16;
+      if (length - i === 3) {
+        bytes[out++] = (n >> 8) & 255;
+      }
+    }
+    return bytes.buffer;
+  }
+
+  function toHex(buffer) {
+    return Array.from(new Uint8Array(buffer), (b) => (b < 16 ? "0" : "") + b.toString(16)).join("");
+  }
+
+  // 同一次解密中按 (盐值, 算法, 迭代次数) 缓存派生结果，同一页面的多个块只派生一次
+  function cached(cache, id, create) {
+    if (!cache.has(id)) {
+      cache.set(id, create());
+    }
+    return cache.get(id);
+  }
+
+  // 站点级密钥：盐值等于站点盐值的派生结果（不可导出的 CryptoKey）保存在 IndexedDB 中，
+  // 有效期内打开其他加密页面时不需要密码，也不再运行 PBKDF2
+  let siteKeyDb;
+  function openSiteKeyDb() {
+    siteKeyDb =
+      siteKeyDb ||
+      new Promise((resolve) => {
+        try {
+          const request = scope.indexedDB.open("reimu-encrypt", 1);
+          request.onupgradeneeded = () => request.result.createObjectStore("keys", { keyPath: "id" });
+          request.onsuccess = () => resolve(request.result);
+          request.onerror = () => resolve(null);
+        } catch (error) {
+          resolve(null);
+        }
+      });
+    return siteKeyDb;
+  }
+
+  // 在 keys 仓库上执行一次请求，IndexedDB 不可用（隐私模式等）时返回 undefined
+  async function siteKeyRequest(mode, run) {
+    const db = await openSiteKeyDb();
+    if (!db) {
+      return undefined;
+    }
+    return new Promise((resolve) => {
+      try {
+        const request = run(db.transaction("keys", mode).objectStore("keys"));
+        request.onsuccess = () => resolve(request.result);
+        request.onerror = () => resolve(undefined);
+      } catch (error) {
+        resolve(undefined);
+      }
+    });
+  }
 
-  const encryptedBytes = base64ToArrayBuffer(base64Data);
+  // 读取某种用途（checked / wrap）、迭代次数与盐值下未过期的密钥，顺便删除过期的记录
+  async function loadSiteKeys(kind, iterations, saltHex) {
+    const records = (await siteKeyRequest("readonly", (store) => store.getAll())) || [];
+    const now = Date.now();
+    records
+      .filter((record) => record.expires <= now)
+      .forEach((record) => siteKeyRequest("readwrite", (store) => store.delete(record.id)));
+    return records.filter(
+      (record) => record.expires > now && record.kind === kind && record.iterations === iterations && record.salt === saltHex
+    );
+  }
+
+  function saveSiteKey(siteKey, record) {
+    if (!siteKey.maxAge) {
+      return;
+    }
+    record.id = record.kind + ":" + record.iterations + ":" + record.salt + ":" + Date.now() + ":" + Math.random();
+    record.expires = Date.now() + siteKey.maxAge * 1000;
+    siteKeyRequest("readwrite", (store) => store.put(record));
+  }
+
+  // 清除保存的全部站点级密钥
+  function clearSiteKeys() {
+    return siteKeyRequest("readwrite", (store) => store.clear());
+  }
+
+  // 返回容器格式的模式字节，旧格式返回 0
+  function containerMode(buffer) {
+    const bytes = new Uint8Array(buffer);
+    if (bytes.length < 10 || String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]) !== "RENC") {
+      return 0;
+    }
+    return bytes[4];
+  }
+
+  // 从密码和盐值派生密钥 (PBKDF2)
+  async function deriveKeyFromPassword(password, salt, algorithm, iterations) {
+    const passwordKey = await subtle.importKey("raw", new TextEncoder().encode(password), { name: "PBKDF2" }, false, [
+      "deriveKey",
+    ]);
+    return await subtle.deriveKey(
+      { name: "PBKDF2", salt: salt, iterations: iterations, hash: "SHA-256" },
+      passwordKey,
+      { name: algorithm, length: 256 },
+      false,
+      ["decrypt"]
+    );
+  }
+
+  // 派生 AES-CBC 密钥及其校验值 HMAC-SHA256(密钥, "reimu-kcv") 的前8字节
+  async function deriveCheckedKey(password, salt, iterations) {
+    const passwordKey = await subtle.importKey("raw", new TextEncoder().encode(password), { name: "PBKDF2" }, false, [
+      "deriveBits",
+    ]);
+    const bits = await subtle.deriveBits({ name: "PBKDF2", salt: salt, iterations: iterations, hash: "SHA-256" }, passwordKey, 256);
+    const hmacKey = await subtle.importKey("raw", bits, { name: "HMAC", hash: "SHA-256" }, false, ["sign"]);
+    const check = await subtle.sign("HMAC", hmacKey, new TextEncoder().encode("reimu-kcv"));
+    const key = await subtle.importKey("raw", bits, { name: "AES-CBC" }, false, ["decrypt"]);
+    return { key: key, check: toHex(check.slice(0, 8)) };
+  }
+
+  // 用 KEK 解开一个包装，得到 AES-CBC 内容密钥（GCM 标签校验失败时抛出异常）
+  async function unwrapWith(kek, wrap, header) {
+    const rawKey = await subtle.decrypt({ name: "AES-GCM", iv: wrap.slice(16, 28), additionalData: header }, kek, wrap.slice(28));
+    return await subtle.importKey("raw", rawKey, { name: "AES-CBC" }, false, ["decrypt"]);
+  }
+
+  // 用密码解开一个包装；盐值为站点盐值时保存解开成功的 KEK
+  async function unwrapContentKey(wrap, password, iterations, header, cache, siteKey) {
+    const salt = wrap.slice(0, 16);
+    const id = iterations + ":" + toHex(salt);
+    const kek = await cached(cache, "AES-GCM:" + id, () => deriveKeyFromPassword(password, salt, "AES-GCM", iterations));
+    const key = await unwrapWith(kek, wrap, header);
+    if (siteKey && siteKey.salt === toHex(salt)) {
+      cached(cache, "save:wrap:" + id, () => saveSiteKey(siteKey, { kind: "wrap", iterations: iterations, salt: siteKey.salt, key: kek }));
+    }
+    return key;
+  }
+
+  // 解开多密码格式的内容密钥：先尝试保存的站点级 KEK，再用密码尝试每个包装，任意一个解开即可
+  async function unwrapAny(buffer, password, count, cache, siteKey) {
+    const view = new DataView(buffer);
+    const iterations = view.getUint32(5);
+    const header = buffer.slice(0, 9);
+    const wraps = [];
+    for (let i = 0; i < count; i++) {
+      wraps.push(buffer.slice(10 + i * WRAP_SIZE, 10 + (i + 1) * WRAP_SIZE));
+    }
+    const siteWraps = siteKey ? wraps.filter((wrap) => toHex(wrap.slice(0, 16)) === siteKey.salt) : [];
+    if (siteWraps.length > 0) {
+      const stored = await cached(cache, "site:wrap:" + iterations, () => loadSiteKeys("wrap", iterations, siteKey.salt));
+      const attempts = [];
+      stored.forEach((record) => siteWraps.forEach((wrap) => attempts.push(unwrapWith(record.key, wrap, header))));
+      try {
+        return await Promise.any(attempts);
+      } catch (error) {
+        // 没有保存的密钥或都不匹配，继续使用密码
+      }
+    }
+    if (!password) {
+      throw new Error("解密失败: 需要密码");
+    }
+    try {
+      return await Promise.any(wraps.map((wrap) => unwrapContentKey(wrap, password, iterations, header, cache, siteKey)));
+    } catch (error) {
+      throw new Error("解密失败: 密码错误");
+    }
+  }
+
+  // 单密码格式的派生密钥：盐值为站点盐值时先查找校验值相同的保存密钥，派生成功后保存
+  async function checkedKey(password, salt, iterations, check, cache, siteKey) {
+    const id = iterations + ":" + toHex(salt);
+    const site = siteKey && siteKey.salt === toHex(salt);
+    if (site) {
+      const stored = await cached(cache, "site:checked:" + iterations, () => loadSiteKeys("checked", iterations, siteKey.salt));
+      const hit = stored.find((record) => record.check === check);
+      if (hit) {
+        return hit;
+      }
+    }
+    if (!password) {
+      throw new Error("解密失败: 需要密码");
+    }
+    const derived = await cached(cache, "checked:" + id, () => deriveCheckedKey(password, salt, iterations));
+    if (site && derived.check === check) {
+      cached(cache, "save:checked:" + id + ":" + check, () =>
+        saveSiteKey(siteKey, { kind: "checked", iterations: iterations, salt: siteKey.salt, key: derived.key, check: check })
+      );
+    }
+    return derived;
+  }
 
-  // 确保数据至少包含盐值和IV (16+16=32字节)
-  if (encryptedBytes.byteLength < 32) {
-    throw new Error("加密数据长度不足，无法解密");
+  // AES-CBC 解密，返回明文的 ArrayBuffer
+  async function decryptData(ciphertext, key, iv) {
+    try {
+      return await subtle.decrypt({ name: "AES-CBC", iv: iv }, key, ciphertext);
+    } catch (error) {
+      throw new Error("解密失败: " + error.message);
+    }
   }
 
-  // 从加密数据中提取盐值、IV和实际密文
-  const salt = encryptedBytes.slice(0, 16);
-  const iv = encryptedBytes.slice(16, 32);
-  const ciphertext = encryptedBytes.slice(32);
+  /**
+   * 解密一个块
+   * @param {ArrayBuffer} buffer 加密数据
+   * @param {string} password 解密密码
+   * @param {Map} cache 本次解密共享的密钥缓存
+   * @param {object} [siteKey] 站点级密钥 {salt: 盐值的十六进制, maxAge: 保存秒数}，未启用时为空
+   * @returns {Promise<ArrayBuffer>} UTF-8 明文
+   */
+  async function decryptBlock(buffer, password, cache, siteKey) {
+    if (buffer.byteLength === 0) {
+      return new ArrayBuffer(0);
+    }
+    if (containerMode(buffer) === MODE_WRAPPED_KEYS) {
+      const count = new Uint8Array(buffer)[9];
+      const dataOffset = 10 + count * WRAP_SIZE;
+      if (buffer.byteLength < dataOffset + 16) {
+        throw new Error("加密数据长度不足，无法解密");
+      }
+      // 同一页面中密码相同的块共用同一组包装，只解开一次
+      const key = await cached(cache, "wrap:" + toHex(buffer.slice(0, dataOffset)), () =>
+        unwrapAny(buffer, password, count, cache, siteKey)
+      );
+      return await decryptData(buffer.slice(dataOffset + 16), key, buffer.slice(dataOffset, dataOffset + 16));
+    }
+    if (containerMode(buffer) === MODE_KEY_CHECK) {
+      if (buffer.byteLength < KEY_CHECK_HEADER_SIZE + 16) {
+        throw new Error("加密数据长度不足，无法解密");
+      }
+      const iterations = new DataView(buffer).getUint32(5);
+      const salt = buffer.slice(9, 25);
+      const check = toHex(buffer.slice(25, KEY_CHECK_HEADER_SIZE));
+      const derived = await checkedKey(password, salt, iterations, check, cache, siteKey);
+      // 校验值不匹配即密码错误，不必解密正文
+      if (derived.check !== check) {
+        throw new Error("解密失败: 密码错误");
+      }
+      const ivEnd = KEY_CHECK_HEADER_SIZE + 16;
+      return await decryptData(buffer.slice(ivEnd), derived.key, buffer.slice(KEY_CHECK_HEADER_SIZE, ivEnd));
+    }
+
+    // 确保数据至少包含盐值和IV (16+16=32字节)
+    if (buffer.byteLength < 32) {
+      throw new Error("加密数据长度不足，无法解密");
+    }
+    const salt = buffer.slice(0, 16);
+    const key = await cached(cache, "AES-CBC:10000:" + toHex(salt), () =>
+      deriveKeyFromPassword(password, salt, "AES-CBC", 10000)
+    );
+    return await decryptData(buffer.slice(32), key, buffer.slice(16, 32));
+  }
 
-  // 从密码和盐值派生密钥
-  const key = await deriveKeyFromPassword(password, salt);
+  return { base64ToArrayBuffer: base64ToArrayBuffer, decryptBlock: decryptBlock, toHex: toHex, clearSiteKeys: clearSiteKeys };
+}
 
-  // 使用派生密钥和IV解密数据
-  const decrypted = await decryptData(ciphertext, key, iv);
+/**
+ * Worker 入口：收到 {id, password, blocks, siteKey} 后并行解密，每个块完成时转移明文 ArrayBuffer 回页面
+ */
+function reimuWorkerMain(scope, core) {
+  scope.postMessage({ ready: true });
+  scope.onmessage = (event) => {
+    const id = event.data.id;
+    const password = event.data.password;
+    const cache = new Map();
+    event.data.blocks.forEach(async (block, index) => {
+      try {
+        const buffer = typeof block === "string" ? core.base64ToArrayBuffer(block) : block;
+        const plain = await core.decryptBlock(buffer, password, cache, event.data.siteKey);
+        scope.postMessage({ id: id, index: index, plain: plain }, [plain]);
+      } catch (error) {
+        scope.postMessage({ id: id, index: index, error: error.message });
+      }
+    });
+  };
+}
 
-  return decrypted;
+/**
+ * 页面的站点级密钥配置（__ENCRYPT_SITE_KEY__），盐值转为十六进制；未启用时返回 null
+ */
+function reimuSiteKey() {
+  if (typeof __ENCRYPT_SITE_KEY__ === "undefined" || !__ENCRYPT_SITE_KEY__.salt) {
+    return null;
+  }
+  reimuLocalCore = reimuLocalCore || reimuDecryptCore(window);
+  const salt = reimuLocalCore.toHex(reimuLocalCore.base64ToArrayBuffer(__ENCRYPT_SITE_KEY__.salt));
+  return { salt: salt, maxAge: __ENCRYPT_SITE_KEY__.maxAge || 0 };
 }
 
-// 从密码和盐值派生密钥 (PBKDF2)
-async function deriveKeyFromPassword(password, salt) {
-  // 将密码转换为编码
-  const passwordBuffer = new TextEncoder().encode(password);
-
-  // 从密码导入原始密钥材料
-  const passwordKey = await window.crypto.subtle.importKey(
-    "raw",
-    passwordBuffer,
-    { name: "PBKDF2" },
-    false,
-    ["deriveBits", "deriveKey"]
-  );
-
-  // 使用PBKDF2派生密钥
-  return await window.crypto.subtle.deriveKey(
-    {
-      name: "PBKDF2",
-      salt: salt,
-      iterations: 10000, // 与C++代码中相同的迭代次数
-      hash: "SHA-256",
-    },
-    passwordKey,
-    { name: "AES-CBC", length: 256 }, // 生成256位(32字节)的AES密钥
-    false,
-    ["decrypt"]
-  );
+/**
+ * 清除本浏览器保存的站点级密钥（例如"退出"或更换密码后），之后打开加密页面需要重新输入密码
+ * @returns {Promise<void>}
+ */
+async function reimuForgetSiteKeys() {
+  reimuLocalCore = reimuLocalCore || reimuDecryptCore(window);
+  await reimuLocalCore.clearSiteKeys();
 }
 
-// 解密数据
-async function decryptData(ciphertext, key, iv) {
+let reimuWorker;
+let reimuWorkerReady = false;
+let reimuLocalCore;
+let reimuNextId = 0;
+const reimuPending = new Map();
+
+// 懒创建解密 Worker（Blob URL），CSP 等原因无法创建时返回 null，由页面线程解密
+function reimuGetWorker() {
+  if (reimuWorker !== undefined) {
+    return reimuWorker;
+  }
+  reimuWorker = null;
   try {
-    const decryptedBuffer = await window.crypto.subtle.decrypt(
-      {
-        name: "AES-CBC",
-        iv: iv,
-      },
-      key,
-      ciphertext
-    );
+    const source = reimuDecryptCore.toString() + "\n" + reimuWorkerMain.toString() +
+      "\nreimuWorkerMain(self, reimuDecryptCore(self));";
+    const worker = new Worker(URL.createObjectURL(new Blob([source], { type: "text/javascript" })));
+    worker.onmessage = (event) => {
+      if (event.data.ready) {
+        reimuWorkerReady = true;
+        return;
+      }
+      const request = reimuPending.get(event.data.id);
+      if (request) {
+        request.settle(event.data.index, event.data.error, event.data.plain);
+      }
+    };
+    // Worker 加载失败：之后都在页面线程解密，未完成的请求转到页面线程继续
+    worker.onerror = () => {
+      worker.terminate();
+      reimuWorker = null;
+      const requests = Array.from(reimuPending.values());
+      reimuPending.clear();
+      requests.forEach((request) => request.runLocally());
+    };
+    reimuWorker = worker;
+  } catch (error) {
+    reimuWorker = null;
+  }
+  return reimuWorker;
+}
+
+/**
+ * 解密一组块（base64字符串或 ArrayBuffer，ArrayBuffer 会被转移给 Worker）
+ * @returns {Promise<string[]>} 与 blocks 一一对应的解密结果，任一块失败时 reject
+ */
+function decryptBlocks(blocks, password, onBlock) {
+  const siteKey = reimuSiteKey();
+  return new Promise((resolve, reject) => {
+    const decoder = new TextDecoder();
+    const results = new Array(blocks.length);
+    const done = new Array(blocks.length).fill(false);
+    let remaining = blocks.length;
+    let failure = null;
+    let id = 0;
+    if (remaining === 0) {
+      resolve(results);
+      return;
+    }
+
+    const settle = (index, error, plain) => {
+      if (done[index]) {
+        return;
+      }
+      done[index] = true;
+      if (error) {
+        failure = failure || error;
+      } else {
+        results[index] = decoder.decode(plain);
+        if (onBlock && !failure) {
+          onBlock(index, results[index]);
+        }
+      }
+      if (--remaining === 0) {
+        reimuPending.delete(id);
+        failure ? reject(new Error(failure)) : resolve(results);
+      }
+    };
+
+    const runLocally = () => {
+      reimuLocalCore = reimuLocalCore || reimuDecryptCore(window);
+      const cache = new Map();
+      blocks.forEach(async (block, index) => {
+        if (done[index]) {
+          return;
+        }
+        try {
+          const buffer = typeof block === "string" ? reimuLocalCore.base64ToArrayBuffer(block) : block;
+          settle(index, null, await reimuLocalCore.decryptBlock(buffer, password, cache, siteKey));
+        } catch (error) {
+          settle(index, error.message);
+        }
+      });
+    };
+
+    const worker = reimuGetWorker();
+    if (!worker) {
+      runLocally();
+      return;
+    }
+    id = ++reimuNextId;
+    reimuPending.set(id, { settle: settle, runLocally: runLocally });
+    // Worker 确认加载成功后才转移 ArrayBuffer，否则复制一份，以便加载失败时回退到页面线程
+    const transfer = reimuWorkerReady ? blocks.filter((block) => block instanceof ArrayBuffer) : [];
+    worker.postMessage({ id: id, password: password, blocks: blocks, siteKey: siteKey }, transfer);
+  });
+}
+
+/**
+ * 加密资源：加密块中引用的本地资源被改写为 data-reimu-<属性>="密钥 类型 加密URL"，
+ * 解密后的HTML插入页面时自动取回并逐块解密为 Blob URL。
+ * 图片、视频等进入视口附近时才加载，链接在悬停、聚焦或点击时加载。
+ */
+const REIMU_ASSET_ATTRIBUTES = ["src", "poster", "data", "href"];
+const REIMU_ASSET_SELECTOR = REIMU_ASSET_ATTRIBUTES.map((name) => "[data-reimu-" + name + "]").join(",");
+const REIMU_ASSET_HEADER_SIZE = 17;
+const REIMU_ASSET_TAG_SIZE = 16;
+const reimuAssetCache = new Map();
+let reimuAssetObserver;
+
+/**
+ * 取回并解密一个资源（相同URL只取一次）
+ * @param {string} value data-reimu-* 属性的值
+ * @returns {Promise<string>} 解密后资源的 Blob URL
+ */
+function reimuFetchAsset(value) {
+  const first = value.indexOf(" ");
+  const second = value.indexOf(" ", first + 1);
+  const url = value.slice(second + 1);
+  if (!reimuAssetCache.has(url)) {
+    const pending = reimuDecryptAsset(url, value.slice(0, first), value.slice(first + 1, second));
+    reimuAssetCache.set(url, pending);
+    pending.catch(() => reimuAssetCache.delete(url));
+  }
+  return reimuAssetCache.get(url);
+}
+
+/**
+ * 流式解密资源：格式为 "RENC" | 0x04 | 块大小(u32) | nonce前缀(8) | 块...，
+ * 每块为 AES-GCM 密文 + 16字节标签，nonce 为 "nonce前缀 | 块序号(u32)"，附加数据为头部与"是否最后一块"标记。
+ * 边下载边解密：缓冲超过一块时解密这一块，下载结束时剩余的是最后一块。
+ */
+async function reimuDecryptAsset(url, keyBase64, type) {
+  reimuLocalCore = reimuLocalCore || reimuDecryptCore(window);
+  const subtle = window.crypto.subtle;
+  const key = await subtle.importKey("raw", reimuLocalCore.base64ToArrayBuffer(keyBase64), { name: "AES-GCM" }, false, [
+    "decrypt",
+  ]);
+  const response = await fetch(url);
+  if (!response.ok) {
+    throw new Error("加载加密资源失败: " + url + ", HTTP " + response.status);
+  }
+
+  let pieces = [];
+  let buffered = 0;
+  const take = (size) => {
+    const out = new Uint8Array(size);
+    let offset = 0;
+    while (offset < size) {
+      const piece = pieces[0];
+      const count = Math.min(piece.length, size - offset);
+      out.set(piece.subarray(0, count), offset);
+      offset += count;
+      if (count === piece.length) {
+        pieces.shift();
+      } else {
+        pieces[0] = piece.subarray(count);
+      }
+    }
+    buffered -= size;
+    return out;
+  };
+
+  let header = null;
+  let chunkSize = 0;
+  let index = 0;
+  const parts = [];
+  const decryptChunk = (chunk, last) => {
+    const iv = new Uint8Array(12);
+    iv.set(header.subarray(9, 17));
+    new DataView(iv.buffer).setUint32(8, index++);
+    const additionalData = new Uint8Array(REIMU_ASSET_HEADER_SIZE + 1);
+    additionalData.set(header);
+    additionalData[REIMU_ASSET_HEADER_SIZE] = last ? 1 : 0;
+    const part = subtle.decrypt({ name: "AES-GCM", iv: iv, additionalData: additionalData }, key, chunk);
+    part.catch(() => {});
+    parts.push(part);
+  };
+  const consume = (done) => {
+    if (!header) {
+      if (buffered < REIMU_ASSET_HEADER_SIZE) {
+        return;
+      }
+      header = take(REIMU_ASSET_HEADER_SIZE);
+      if (String.fromCharCode(header[0], header[1], header[2], header[3]) !== "RENC" || header[4] !== 0x04) {
+        throw new Error("不是加密资源: " + url);
+      }
+      chunkSize = new DataView(header.buffer).getUint32(5);
+    }
+    while (buffered > chunkSize + REIMU_ASSET_TAG_SIZE) {
+      decryptChunk(take(chunkSize + REIMU_ASSET_TAG_SIZE), false);
+    }
+    if (done) {
+      decryptChunk(take(buffered), true);
+    }
+  };
 
-    // 将解密后的数据转换为文本
-    return new TextDecoder().decode(decryptedBuffer);
+  if (response.body && response.body.getReader) {
+    const reader = response.body.getReader();
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) {
+        break;
+      }
+      pieces.push(value);
+      buffered += value.length;
+      consume(false);
+    }
+  } else {
+    const whole = new Uint8Array(await response.arrayBuffer());
+    pieces.push(whole);
+    buffered = whole.length;
+  }
+  if (!header && buffered < REIMU_ASSET_HEADER_SIZE) {
+    throw new Error("加密资源不完整: " + url);
+  }
+  consume(true);
+  try {
+    return URL.createObjectURL(new Blob(await Promise.all(parts), { type: type }));
   } catch (error) {
-    throw new Error("解密失败: " + error.message);
+    throw new Error("资源解密失败: " + url);
   }
 }
 
-// Base64转ArrayBuffer工具函数
-function base64ToArrayBuffer(base64) {
-  const binaryString = atob(base64);
-  const bytes = new Uint8Array(binaryString.length);
-  for (let i = 0; i < binaryString.length; i++) {
-    bytes[i] = binaryString.charCodeAt(i);
+// 把元素上的 data-reimu-src/poster/data 换成解密后的 Blob URL
+function reimuApplyAssets(element) {
+  REIMU_ASSET_ATTRIBUTES.forEach((name) => {
+    const value = name !== "href" && element.getAttribute("data-reimu-" + name);
+    if (!value) {
+      return;
+    }
+    element.removeAttribute("data-reimu-" + name);
+    reimuFetchAsset(value)
+      .then((blobUrl) => {
+        element.setAttribute(name, blobUrl);
+        const media = element.parentElement;
+        if ((element.tagName === "SOURCE" || element.tagName === "TRACK") && media && media.load) {
+          media.load();
+        }
+      })
+      .catch((error) => console.error(error));
+  });
+}
+
+// 链接在悬停或聚焦时预先解密；点击时尚未完成则等待完成后再打开
+function reimuBindLink(element) {
+  const value = element.getAttribute("data-reimu-href");
+  element.removeAttribute("data-reimu-href");
+  let pending = null;
+  const load = () => {
+    pending = pending || reimuFetchAsset(value).then((blobUrl) => element.setAttribute("href", blobUrl));
+    return pending;
+  };
+  element.addEventListener("pointerenter", () => load().catch(() => (pending = null)), { once: true });
+  element.addEventListener("focus", () => load().catch(() => (pending = null)), { once: true });
+  element.addEventListener("click", (event) => {
+    if (element.hasAttribute("href")) {
+      return;
+    }
+    event.preventDefault();
+    load()
+      .then(() => element.click())
+      .catch((error) => {
+        pending = null;
+        console.error(error);
+      });
+  });
+}
+
+/**
+ * 处理 root 及其后代中的加密资源引用（解密后的HTML插入页面时会自动调用）
+ * @param {Element} root 根元素
+ */
+function reimuLoadAssets(root) {
+  const elements = [];
+  if (root.matches && root.matches(REIMU_ASSET_SELECTOR)) {
+    elements.push(root);
   }
-  return bytes.buffer;
+  if (root.querySelectorAll) {
+    elements.push(...root.querySelectorAll(REIMU_ASSET_SELECTOR));
+  }
+  elements.forEach((element) => {
+    if (element.hasAttribute("data-reimu-href")) {
+      reimuBindLink(element);
+    }
+    if (!REIMU_ASSET_ATTRIBUTES.some((name) => name !== "href" && element.hasAttribute("data-reimu-" + name))) {
+      return;
+    }
+    const lazy = element.tagName !== "SOURCE" && element.tagName !== "TRACK";
+    if (!lazy || typeof IntersectionObserver !== "function") {
+      reimuApplyAssets(element);
+      return;
+    }
+    reimuAssetObserver =
+      reimuAssetObserver ||
+      new IntersectionObserver(
+        (entries) => {
+          entries.forEach((entry) => {
+            if (entry.isIntersecting) {
+              reimuAssetObserver.unobserve(entry.target);
+              reimuApplyAssets(entry.target);
+            }
+          });
+        },
+        { rootMargin: "200px" }
+      );
+    reimuAssetObserver.observe(element);
+  });
+}
+
+if (typeof document !== "undefined" && typeof MutationObserver === "function") {
+  new MutationObserver((mutations) => {
+    mutations.forEach((mutation) => mutation.addedNodes.forEach((node) => node.nodeType === 1 && reimuLoadAssets(node)));
+  }).observe(document.documentElement, { childList: true, subtree: true });
 }
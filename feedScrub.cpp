@@ -0,0 +1,632 @@
+﻿#include "feedScrub.h"
+
+#include <algorithm>
+#include <cctype>
+#include <nlohmann/json.hpp>
+
+static const size_t npos = std::string_view::npos;
+
+const std::string SCRUB_ENCRYPTED_PREFIX = "reimu-encrypted:";
+
+// 参与匹配的字段值的最大长度，更长的值（正文等）不可能是链接或 uniqueID
+static const size_t MAX_MATCH_VALUE = 2048;
+
+// XML 记录元素：RSS <item>、Atom <entry>、站点地图 <url>
+static const std::string_view XML_RECORD_TAGS[] = {"item", "entry", "url"};
+// 记录中用于匹配文章的子元素（文本内容或 href 属性）
+static const std::string_view XML_LINK_TAGS[] = {"link", "guid", "id", "loc"};
+// 每次从输入读取的字节数
+static const size_t XML_CHUNK_SIZE = 64 * 1024;
+// 判断标记类型需要的最多字节数（"<![CDATA["）
+static const size_t XML_MARKUP_PREFIX = 9;
+// 查找频道链接时最多读取的字节数
+static const size_t FEED_HEADER_LIMIT = 1024 * 1024;
+
+// 百分号解码（与 decodeUrl 不同，'+' 在路径中保持原样）
+static std::string decodePercent(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size() && std::isxdigit((unsigned char)value[i + 1]) &&
+            std::isxdigit((unsigned char)value[i + 2])) {
+            result += (char)std::stoi(std::string(value.substr(i + 1, 2)), nullptr, 16);
+            i += 2;
+        } else {
+            result += value[i];
+        }
+    }
+    return result;
+}
+
+// 去掉末尾的 index.html 与首尾的 '/'：posts/a/index.html、/posts/a/ 都得到 posts/a
+static std::string trimPath(std::string path) {
+    static const std::string index = "index.html";
+    if (path.size() >= index.size() && path.compare(path.size() - index.size(), index.size(), index) == 0 &&
+        (path.size() == index.size() || path[path.size() - index.size() - 1] == '/')) {
+        path.resize(path.size() - index.size());
+    }
+    size_t first = path.find_first_not_of('/');
+    if (first == std::string::npos) return "";
+    size_t last = path.find_last_not_of('/');
+    return path.substr(first, last - first + 1);
+}
+
+// URL 或站内路径的规范形式：去掉协议与主机、查询与片段，百分号解码
+static std::string normalizeUrlPath(std::string_view value) {
+    size_t scheme = value.find("://");
+    if (scheme != npos && scheme < value.find('/')) {
+        size_t slash = value.find('/', scheme + 3);
+        value = slash == npos ? std::string_view() : value.substr(slash);
+    } else if (value.compare(0, 2, "//") == 0) {
+        size_t slash = value.find('/', 2);
+        value = slash == npos ? std::string_view() : value.substr(slash);
+    }
+    value = value.substr(0, value.find_first_of("?#"));
+    return trimPath(decodePercent(value));
+}
+
+ScrubMatcher::ScrubMatcher(const std::vector<ArticleItem>& articles, const std::string& basePath)
+    : basePath_(normalizeUrlPath(basePath)) {
+    for (size_t i = 0; i < articles.size(); ++i) {
+        // filePath 在加载配置时已经解码
+        std::string path = trimPath(articles[i].filePath);
+        if (!path.empty()) paths_.emplace(path, i);
+        if (!articles[i].uniqueID.empty()) ids_.emplace(articles[i].uniqueID, i);
+    }
+}
+
+size_t ScrubMatcher::find(std::string_view value) const {
+    if (value.empty() || value.size() > MAX_MATCH_VALUE) return npos;
+    if (std::any_of(value.begin(), value.end(), [](char c) { return std::isspace((unsigned char)c); })) return npos;
+
+    auto id = ids_.find(std::string(value));
+    if (id != ids_.end()) return id->second;
+
+    std::string path = normalizeUrlPath(value);
+    if (path.empty()) return npos;
+    auto it = paths_.find(path);
+    if (it != paths_.end()) return it->second;
+    // 站点部署在子路径下时只去掉已知的子路径，其余路径段必须与文章路径完全相同
+    if (!basePath_.empty() && path.size() > basePath_.size() && path[basePath_.size()] == '/' &&
+        path.compare(0, basePath_.size(), basePath_) == 0) {
+        it = paths_.find(path.substr(basePath_.size() + 1));
+        if (it != paths_.end()) return it->second;
+    }
+    return npos;
+}
+
+// ---------------------------------------------------------------- XML
+
+// 从 lt（'<' 的位置）开始的标记的结束位置（'>' 之后），内容不完整时返回 npos
+static size_t markupEnd(std::string_view data, size_t lt) {
+    auto until = [&](std::string_view terminator, size_t from) {
+        size_t end = data.find(terminator, from);
+        return end == npos ? npos : end + terminator.size();
+    };
+    if (data.compare(lt, 4, "<!--") == 0) return until("-->", lt + 4);
+    if (data.compare(lt, 9, "<![CDATA[") == 0) return until("]]>", lt + 9);
+    if (data.compare(lt, 2, "<?") == 0) return until("?>", lt + 2);
+    // 开始/结束标签与 <!DOCTYPE>：跳过引号中的 '>'
+    char quote = 0;
+    for (size_t i = lt + 1; i < data.size(); ++i) {
+        char c = data[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i + 1;
+        }
+    }
+    return npos;
+}
+
+// 标签名（含命名空间前缀），markup 为完整的开始或结束标签
+static std::string_view tagName(std::string_view markup) {
+    size_t start = markup.size() > 1 && markup[1] == '/' ? 2 : 1;
+    size_t end = start;
+    while (end < markup.size() && !std::isspace((unsigned char)markup[end]) && markup[end] != '>' &&
+           markup[end] != '/') {
+        ++end;
+    }
+    return markup.substr(start, end - start);
+}
+
+static bool isStartTag(std::string_view markup) {
+    return markup.size() > 2 && markup[1] != '/' && markup[1] != '!' && markup[1] != '?';
+}
+
+static bool isSelfClosing(std::string_view markup) {
+    return markup.size() >= 2 && markup[markup.size() - 2] == '/';
+}
+
+static void appendUtf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// 元素或属性的文本：展开 CDATA，解码预定义实体与字符引用
+static std::string xmlText(std::string_view content) {
+    std::string text;
+    text.reserve(content.size());
+    for (size_t i = 0; i < content.size();) {
+        if (content.compare(i, 9, "<![CDATA[") == 0) {
+            size_t end = content.find("]]>", i + 9);
+            if (end == npos) end = content.size();
+            text.append(content.substr(i + 9, end - i - 9));
+            i = std::min(content.size(), end + 3);
+            continue;
+        }
+        if (content[i] == '&') {
+            size_t semi = content.find(';', i);
+            if (semi != npos && semi - i <= 10) {
+                std::string_view entity = content.substr(i + 1, semi - i - 1);
+                static const std::pair<std::string_view, char> named[] = {
+                    {"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'}, {"apos", '\''}};
+                bool decoded = false;
+                for (const auto& [name, c] : named) {
+                    if (entity == name) {
+                        text += c;
+                        decoded = true;
+                    }
+                }
+                if (!decoded && entity.size() > 1 && entity[0] == '#') {
+                    bool hex = entity[1] == 'x' || entity[1] == 'X';
+                    std::string digits(entity.substr(hex ? 2 : 1));
+                    char* end = nullptr;
+                    unsigned long cp = std::strtoul(digits.c_str(), &end, hex ? 16 : 10);
+                    if (!digits.empty() && *end == '\0' && cp > 0 && cp <= 0x10FFFF) {
+                        appendUtf8(text, cp);
+                        decoded = true;
+                    }
+                }
+                if (decoded) {
+                    i = semi + 1;
+                    continue;
+                }
+            }
+        }
+        text += content[i++];
+    }
+    return text;
+}
+
+static std::string escapeXml(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// 开始标签中的属性值，不存在时返回空字符串
+static std::string xmlAttribute(std::string_view tag, std::string_view name) {
+    for (size_t pos = tag.find(name); pos != npos; pos = tag.find(name, pos + 1)) {
+        if (pos == 0 || !std::isspace((unsigned char)tag[pos - 1])) continue;
+        size_t i = pos + name.size();
+        while (i < tag.size() && std::isspace((unsigned char)tag[i])) ++i;
+        if (i >= tag.size() || tag[i] != '=') continue;
+        ++i;
+        while (i < tag.size() && std::isspace((unsigned char)tag[i])) ++i;
+        if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\'')) continue;
+        size_t end = tag.find(tag[i], i + 1);
+        if (end == npos) return "";
+        return xmlText(tag.substr(i + 1, end - i - 1));
+    }
+    return "";
+}
+
+// 记录的直接子元素
+struct XmlChild {
+    std::string_view name;
+    std::string_view startTag;
+    size_t contentStart = 0;  ///< 内容起点（开始标签之后）
+    size_t contentEnd = 0;    ///< 内容终点（结束标签之前），自闭合元素与 contentStart 相同
+};
+
+static std::vector<XmlChild> xmlChildren(std::string_view record) {
+    std::vector<XmlChild> children;
+    XmlChild current;
+    int depth = 0;
+    for (size_t pos = markupEnd(record, 0); pos != npos;) {
+        size_t lt = record.find('<', pos);
+        if (lt == npos) break;
+        size_t end = markupEnd(record, lt);
+        if (end == npos) break;
+        std::string_view markup = record.substr(lt, end - lt);
+        pos = end;
+        if (markup[1] == '/') {
+            if (depth == 0) break;  // 记录自身的结束标签
+            if (--depth == 0) {
+                current.contentEnd = lt;
+                children.push_back(current);
+            }
+        } else if (isStartTag(markup)) {
+            if (depth == 0) {
+                current.name = tagName(markup);
+                current.startTag = markup;
+                current.contentStart = current.contentEnd = end;
+            }
+            if (!isSelfClosing(markup)) {
+                ++depth;
+            } else if (depth == 0) {
+                children.push_back(current);
+            }
+        }
+    }
+    return children;
+}
+
+// 处理一条完整的记录，返回写出的内容（删除时为空）
+static std::string scrubXmlRecord(std::string record, const ScrubMatcher& matcher, const ScrubRules& rules,
+                                  ScrubStats& stats) {
+    ++stats.records;
+    std::vector<XmlChild> children = xmlChildren(record);
+
+    size_t article = ScrubMatcher::npos;
+    for (const auto& child : children) {
+        if (std::find(std::begin(XML_LINK_TAGS), std::end(XML_LINK_TAGS), child.name) == std::end(XML_LINK_TAGS)) {
+            continue;
+        }
+        std::string_view content(record.data() + child.contentStart, child.contentEnd - child.contentStart);
+        for (const std::string& value : {xmlText(content), xmlAttribute(child.startTag, "href")}) {
+            std::string_view trimmed = value;
+            while (!trimmed.empty() && std::isspace((unsigned char)trimmed.front())) trimmed.remove_prefix(1);
+            while (!trimmed.empty() && std::isspace((unsigned char)trimmed.back())) trimmed.remove_suffix(1);
+            article = matcher.find(trimmed);
+            if (article != ScrubMatcher::npos) break;
+        }
+        if (article != ScrubMatcher::npos) break;
+    }
+    if (article == ScrubMatcher::npos) return record;
+
+    ++stats.matched;
+    if (rules.remove) {
+        ++stats.removed;
+        return "";
+    }
+    // 从后向前替换，前面子元素的位置不受影响
+    for (auto child = children.rbegin(); child != children.rend(); ++child) {
+        if (child->contentEnd == child->contentStart || !rules.replace) continue;
+        if (std::find(rules.fields.begin(), rules.fields.end(), child->name) == rules.fields.end()) continue;
+        std::string text = xmlText(std::string_view(record.data() + child->contentStart,
+                                                    child->contentEnd - child->contentStart));
+        record.replace(child->contentStart, child->contentEnd - child->contentStart,
+                       escapeXml(rules.replace(article, text)));
+        ++stats.fields;
+    }
+    return record;
+}
+
+bool scrubXmlStream(std::istream& in, std::ostream& out, const ScrubMatcher& matcher, const ScrubRules& rules,
+                    ScrubStats& stats, std::string& error) {
+    std::string buffer;
+    size_t begin = 0;  // buffer 中尚未处理的数据的起点
+    bool eof = false;
+    std::vector<char> chunk(XML_CHUNK_SIZE);
+
+    // 丢弃已处理的数据并读入下一块（读到末尾时设置 eof），下面的位置都相对 begin，因此不受影响
+    auto readMore = [&]() {
+        if (eof) return false;
+        buffer.erase(0, begin);
+        begin = 0;
+        in.read(chunk.data(), chunk.size());
+        std::streamsize count = in.gcount();
+        if (count <= 0) {
+            eof = true;
+            return false;
+        }
+        buffer.append(chunk.data(), (size_t)count);
+        return true;
+    };
+
+    std::string recordName;  // 当前记录的标签名，为空时不在记录中
+    size_t recordScan = 0;   // 记录内已扫描到的位置
+    while (true) {
+        std::string_view data(buffer.data() + begin, buffer.size() - begin);
+        if (recordName.empty()) {
+            // 记录之外：文本直接写出，标记完整后判断是否为记录的开始
+            size_t lt = data.find('<');
+            size_t text = lt == npos ? data.size() : lt;
+            out.write(data.data(), (std::streamsize)text);
+            begin += text;
+            if (lt == npos) {
+                if (!readMore()) break;
+                continue;
+            }
+            data.remove_prefix(text);
+            size_t end = data.size() >= XML_MARKUP_PREFIX || eof ? markupEnd(data, 0) : npos;
+            if (end == npos) {
+                if (!eof) {
+                    readMore();
+                    continue;
+                }
+                error = "XML 不完整: 标记未闭合";
+                return false;
+            }
+            std::string_view markup = data.substr(0, end);
+            if (isStartTag(markup) && !isSelfClosing(markup) &&
+                std::find(std::begin(XML_RECORD_TAGS), std::end(XML_RECORD_TAGS), tagName(markup)) !=
+                    std::end(XML_RECORD_TAGS)) {
+                recordName = std::string(tagName(markup));
+                recordScan = end;
+                continue;
+            }
+            out.write(markup.data(), (std::streamsize)end);
+            begin += end;
+            continue;
+        }
+
+        // 记录之内：查找同名的结束标签（记录元素不会嵌套）
+        size_t lt = data.find('<', recordScan);
+        size_t end = lt != npos && (data.size() - lt >= XML_MARKUP_PREFIX || eof) ? markupEnd(data, lt) : npos;
+        if (end == npos) {
+            if (lt == npos) recordScan = data.size();
+            if (!eof) {
+                readMore();
+                continue;
+            }
+            error = "XML 不完整: <" + recordName + "> 未闭合";
+            return false;
+        }
+        std::string_view markup = data.substr(lt, end - lt);
+        if (markup[1] == '/' && tagName(markup) == recordName) {
+            std::string record = scrubXmlRecord(std::string(data.substr(0, end)), matcher, rules, stats);
+            out.write(record.data(), (std::streamsize)record.size());
+            begin += end;
+            recordName.clear();
+            recordScan = 0;
+            continue;
+        }
+        recordScan = end;
+    }
+    if (!out) {
+        error = "写出失败";
+        return false;
+    }
+    return true;
+}
+
+std::string scrubFeedBasePath(std::istream& in) {
+    std::string buffer;
+    std::vector<char> chunk(XML_CHUNK_SIZE);
+    auto readMore = [&]() {
+        if (buffer.size() >= FEED_HEADER_LIMIT) return false;
+        in.read(chunk.data(), chunk.size());
+        std::streamsize count = in.gcount();
+        if (count <= 0) return false;
+        buffer.append(chunk.data(), (size_t)count);
+        return true;
+    };
+
+    for (size_t pos = 0;;) {
+        size_t lt = buffer.find('<', pos);
+        size_t end = lt == npos ? npos : markupEnd(buffer, lt);
+        if (end == npos) {
+            if (!readMore()) return "";
+            continue;
+        }
+        std::string_view markup(buffer.data() + lt, end - lt);
+        pos = end;
+        if (!isStartTag(markup)) continue;
+        std::string_view name = tagName(markup);
+        // 到达第一条记录仍没有频道链接
+        if (std::find(std::begin(XML_RECORD_TAGS), std::end(XML_RECORD_TAGS), name) != std::end(XML_RECORD_TAGS)) {
+            return "";
+        }
+        if (name != "link") continue;
+        std::string href = xmlAttribute(markup, "href");
+        if (!href.empty()) {
+            std::string rel = xmlAttribute(markup, "rel");
+            if (rel.empty() || rel == "alternate") return normalizeUrlPath(href);
+            continue;
+        }
+        if (isSelfClosing(markup)) continue;
+        size_t close = buffer.find("</", end);
+        if (close == npos) {
+            // 链接文本不完整：读入更多内容后重新解析这个标签
+            pos = lt;
+            if (!readMore()) return "";
+            continue;
+        }
+        std::string text = xmlText(std::string_view(buffer.data() + end, close - end));
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) continue;
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return normalizeUrlPath(std::string_view(text).substr(first, last - first + 1));
+    }
+}
+
+// ---------------------------------------------------------------- JSON
+
+/**
+ * JsonScrubber：SAX 处理器
+ *
+ * 记录之外的值直接写出（数字按原文写出）；数组中的对象收集为一个 ordered_json（保持键的顺序），
+ * 对象结束时整体判断、改写并写出。
+ */
+class JsonScrubber : public nlohmann::json_sax<nlohmann::json> {
+public:
+    JsonScrubber(std::ostream& out, const ScrubMatcher& matcher, const ScrubRules& rules, ScrubStats& stats)
+        : out_(out), matcher_(matcher), rules_(rules), stats_(stats) {}
+
+    bool null() override { return scalar(nullptr, "null"); }
+    bool boolean(bool val) override { return scalar(val, val ? "true" : "false"); }
+    bool number_integer(number_integer_t val) override { return scalar(val, std::to_string(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return scalar(val, std::to_string(val)); }
+    bool number_float(number_float_t val, const string_t& s) override { return scalar(val, s); }
+    bool string(string_t& val) override {
+        if (capturing()) return capture(std::move(val));
+        return scalar(nullptr, nlohmann::json(val).dump());
+    }
+    bool binary(binary_t&) override { return false; }  // JSON 文本中不会出现
+
+    bool start_object(std::size_t) override {
+        if (capturing() || (!levels_.empty() && levels_.back().array)) {
+            // 数组中的对象是一条记录
+            refs_.push_back(capture(nlohmann::ordered_json::object()));
+            return true;
+        }
+        beforeValue();
+        out_ << '{';
+        levels_.push_back({false, 0});
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (capturing()) {
+            key_ = std::move(val);
+            return true;
+        }
+        if (levels_.back().count++ > 0) out_ << ',';
+        out_ << nlohmann::json(val).dump() << ':';
+        return true;
+    }
+
+    bool end_object() override {
+        if (capturing()) {
+            refs_.pop_back();
+            if (refs_.empty()) writeRecord();
+            return true;
+        }
+        out_ << '}';
+        levels_.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (capturing()) {
+            refs_.push_back(capture(nlohmann::ordered_json::array()));
+            return true;
+        }
+        beforeValue();
+        out_ << '[';
+        levels_.push_back({true, 0});
+        return true;
+    }
+
+    bool end_array() override {
+        if (capturing()) {
+            refs_.pop_back();
+            return true;
+        }
+        out_ << ']';
+        levels_.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error_ = ex.what();
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    struct Level {
+        bool array = false;
+        size_t count = 0;  ///< 已写出的元素或键值对数
+    };
+
+    bool capturing() const { return !refs_.empty(); }
+
+    // 记录之外的值写出前补上数组元素间的逗号（对象的逗号在 key 中写出）
+    void beforeValue() {
+        if (!levels_.empty() && levels_.back().array && levels_.back().count++ > 0) out_ << ',';
+    }
+
+    template <typename T>
+    bool scalar(T&& val, const std::string& text) {
+        if (capturing()) return capture(std::forward<T>(val));
+        beforeValue();
+        out_ << text;
+        return true;
+    }
+
+    // 把值加入正在收集的记录，返回新值的地址
+    template <typename T>
+    nlohmann::ordered_json* capture(T&& val) {
+        if (refs_.empty()) {
+            record_ = nlohmann::ordered_json(std::forward<T>(val));
+            return &record_;
+        }
+        nlohmann::ordered_json& parent = *refs_.back();
+        if (parent.is_array()) {
+            parent.push_back(std::forward<T>(val));
+            return &parent.back();
+        }
+        nlohmann::ordered_json& slot = parent[key_];
+        slot = std::forward<T>(val);
+        return &slot;
+    }
+
+    void writeRecord() {
+        ++stats_.records;
+        // 只比较链接与ID字段（与 XML_LINK_TAGS 对应）：标题等字段可能恰好与某篇文章的路径相同
+        size_t article = ScrubMatcher::npos;
+        for (const auto& key : rules_.linkKeys) {
+            auto it = record_.find(key);
+            if (it == record_.end() || !it->is_string()) continue;
+            article = matcher_.find(it->get_ref<const std::string&>());
+            if (article != ScrubMatcher::npos) break;
+        }
+        if (article != ScrubMatcher::npos) {
+            ++stats_.matched;
+            if (rules_.remove) {
+                ++stats_.removed;
+                return;
+            }
+            for (const auto& field : rules_.fields) {
+                auto it = record_.find(field);
+                if (it == record_.end() || !it->is_string() || !rules_.replace) continue;
+                *it = rules_.replace(article, it->get<std::string>());
+                ++stats_.fields;
+            }
+        }
+        beforeValue();
+        out_ << record_.dump();
+    }
+
+    std::ostream& out_;
+    const ScrubMatcher& matcher_;
+    const ScrubRules& rules_;
+    ScrubStats& stats_;
+    std::vector<Level> levels_;               ///< 记录之外已打开的容器
+    nlohmann::ordered_json record_;           ///< 正在收集的记录
+    std::vector<nlohmann::ordered_json*> refs_;  ///< 记录中已打开的容器
+    std::string key_;                         ///< 记录中下一个值的键
+    std::string error_;
+};
+
+bool scrubJsonStream(std::istream& in, std::ostream& out, const ScrubMatcher& matcher, const ScrubRules& rules,
+                     ScrubStats& stats, std::string& error) {
+    JsonScrubber scrubber(out, matcher, rules, stats);
+    if (!nlohmann::json::sax_parse(in, &scrubber)) {
+        error = scrubber.error().empty() ? "JSON 解析失败" : scrubber.error();
+        return false;
+    }
+    if (!out) {
+        error = "写出失败";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,125 @@
+﻿#pragma once
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "encryptConfig.h"
+
+/**
+ * 订阅源、站点地图与搜索索引的流式清理（scrub）
+ *
+ * 站点生成器输出的 index.xml（RSS/Atom）、sitemap.xml 与搜索索引JSON中仍有加密文章的明文。
+ * 这里按记录流式处理：XML 中的 <item>/<entry>/<url> 元素、JSON 中数组里的对象。
+ * 记录之外的内容边读边写，每次只在内存中保留一条记录，按其中的链接或 uniqueID
+ * 判断是否属于加密文章，属于时删除整条记录或改写指定字段。内存占用只与最大的单条记录有关，
+ * 与文件大小无关。
+ */
+
+/**
+ * encrypt 操作写回的字段值的前缀，其后为与 __ENCRYPT_DATA__ 中加密块相同格式的 base64 数据
+ * （可用注入页面的 encrypt(base64, password) 解密）。已带此前缀的值不会被再次加密。
+ */
+extern const std::string SCRUB_ENCRYPTED_PREFIX;
+
+/**
+ * ScrubMatcher：按链接或 uniqueID 查找加密文章
+ */
+class ScrubMatcher {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * 构造函数
+     * @param articles 加密文章列表（按 filePath 与 uniqueID 建立索引）
+     * @param basePath 站点部署的子路径（如 /blog），为空表示部署在根路径
+     */
+    explicit ScrubMatcher(const std::vector<ArticleItem>& articles, const std::string& basePath = "");
+
+    /**
+     * 查找值对应的文章
+     *
+     * 值可以是 uniqueID、完整URL（忽略协议、主机、查询与片段）或站内路径。路径百分号解码后
+     * 去掉末尾的 index.html 与首尾的 '/' 再与文章路径整体比较；设置了 basePath 时，以它开头的路径
+     * （如 /blog/posts/a/）去掉这一前缀后再比较一次。不会去掉其他的路径段：文章 about/index.html
+     * 不匹配 /posts/about/ 或 /tags/about/。含空白或过长的值直接视为不匹配。
+     *
+     * @param value 记录中的字段值
+     * @return 文章在列表中的下标，未找到返回 npos
+     */
+    size_t find(std::string_view value) const;
+
+private:
+    std::unordered_map<std::string, size_t> paths_;  ///< 规范化路径 -> 文章下标
+    std::unordered_map<std::string, size_t> ids_;    ///< uniqueID -> 文章下标
+    std::string basePath_;                           ///< 规范化的站点子路径，为空表示根路径
+};
+
+/**
+ * 从订阅源的频道链接推断站点部署的子路径
+ *
+ * 读取第一条记录之前的内容，取 RSS <channel> 的 <link> 或 Atom <feed> 中 rel 为空或 alternate 的
+ * <link href>，返回其规范化的路径（https://example.com/blog/ 得到 blog）。站点地图没有频道链接。
+ *
+ * @param in 订阅源输入
+ * @return 子路径，部署在根路径或找不到频道链接时返回空字符串
+ */
+std::string scrubFeedBasePath(std::istream& in);
+
+/**
+ * 对属于加密文章的记录执行的操作
+ */
+struct ScrubRules {
+    bool remove = false;              ///< 删除整条记录
+    std::vector<std::string> fields;  ///< 改写的字段：XML 记录的子元素名（如 content:encoded）或 JSON 对象的键
+    std::vector<std::string> linkKeys;  ///< JSON 记录中与文章比较的键（链接或ID），XML 使用固定的链接元素
+    /// 字段的新内容：参数为文章下标与字段原文（XML 已解码实体与 CDATA），返回值按所在格式转义后写回
+    std::function<std::string(size_t, const std::string&)> replace;
+};
+
+/**
+ * 单个文件的清理统计
+ */
+struct ScrubStats {
+    size_t records = 0;  ///< 读到的记录数
+    size_t matched = 0;  ///< 属于加密文章的记录数
+    size_t removed = 0;  ///< 删除的记录数
+    size_t fields = 0;   ///< 改写的字段数
+};
+
+/**
+ * 流式清理 XML（RSS/Atom 订阅源、站点地图）
+ *
+ * 记录之外的字节原样写出；保留的记录只替换被改写字段的内容，其余字节不变。
+ *
+ * @param in 输入
+ * @param out 输出
+ * @param matcher 文章索引
+ * @param rules 对匹配记录的操作
+ * @param stats 统计
+ * @param error 失败原因
+ * @return 成功返回 true；失败时 out 中的内容不完整，不应使用
+ */
+bool scrubXmlStream(std::istream& in, std::ostream& out, const ScrubMatcher& matcher, const ScrubRules& rules,
+                    ScrubStats& stats, std::string& error);
+
+/**
+ * 流式清理 JSON（搜索索引）
+ *
+ * 使用 SAX 解析，记录（数组中的对象）之外的值边读边写；记录按其顶层字符串字段匹配文章，
+ * 只改写顶层的字符串字段。输出为紧凑格式（不保留原有的缩进），记录中的浮点数可能改写为等价的形式。
+ *
+ * @param in 输入
+ * @param out 输出
+ * @param matcher 文章索引
+ * @param rules 对匹配记录的操作
+ * @param stats 统计
+ * @param error 失败原因
+ * @return 成功返回 true；失败时 out 中的内容不完整，不应使用
+ */
+bool scrubJsonStream(std::istream& in, std::ostream& out, const ScrubMatcher& matcher, const ScrubRules& rules,
+                     ScrubStats& stats, std::string& error);
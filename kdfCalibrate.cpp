@@ -0,0 +1,112 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "aceEncrypt.h"
+#include "encryptCore.h"
+#include "kdfCalibrate.h"
+#include "tool.h"
+
+using namespace std;
+
+// 测量的最短时长，太短时计时误差较大
+static const double MIN_MEASURE_SECONDS = 0.5;
+
+KdfBenchmark measureKdf(double targetMs) {
+    KdfBenchmark result;
+    std::string salt(16, '\x5a');
+    // 先用较少的迭代次数预热，再逐步加倍直到测量时长足够
+    deriveKeyFromPassword("calibrate", salt, MIN_KDF_ITERATIONS);
+    unsigned int iterations = DEFAULT_KDF_ITERATIONS;
+    double seconds = 0;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        deriveKeyFromPassword("calibrate", salt, iterations);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= MIN_MEASURE_SECONDS || iterations >= MAX_KDF_ITERATIONS) break;
+        iterations = std::min(MAX_KDF_ITERATIONS, iterations * 2);
+    }
+    if (seconds <= 0) seconds = 1e-9;
+    result.iterationsPerSecond = iterations / seconds;
+
+    double target = result.iterationsPerSecond * targetMs / 1000.0;
+    target = std::round(target / 1000.0) * 1000.0;
+    target = std::max<double>(MIN_KDF_ITERATIONS, std::min<double>(MAX_KDF_ITERATIONS, target));
+    result.recommended = (unsigned int)target;
+    return result;
+}
+
+KdfWorkload estimateKdfWorkload(const EncryptConfig& config) {
+    KdfWorkload workload;
+    for (const auto& article : config.articles) {
+        // 与 encryptHtml 相同的去重规则：主密码在前，额外密码去掉空值与重复项
+        std::vector<std::string> passwords{articleDefaultPassword(config, article)};
+        for (const auto& password : articleExtraPasswords(config, article)) {
+            if (!password.empty() && std::find(passwords.begin(), passwords.end(), password) == passwords.end()) {
+                passwords.push_back(password);
+            }
+        }
+        const auto& rules = articleRules(config, article);
+        size_t derivations = passwords.size();
+        for (const auto& rule : rules) {
+            if (!rule.password.empty()) derivations += passwords.size();
+        }
+        unsigned int iterations = articleKdfIterations(config, article);
+
+        ++workload.articles;
+        workload.rules += rules.size();
+        workload.derivations += derivations;
+        workload.iterations += (double)derivations * iterations;
+        workload.maxPagePasswords = std::max(workload.maxPagePasswords, passwords.size());
+        workload.maxPageIterations = std::max(workload.maxPageIterations, iterations);
+    }
+    return workload;
+}
+
+// 格式化耗时：不足1秒时显示毫秒
+static std::string formatSeconds(double seconds) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(seconds < 1 ? 0 : 1);
+    if (seconds < 1) {
+        out << seconds * 1000 << " ms";
+    } else {
+        out << seconds << " s";
+    }
+    return out.str();
+}
+
+void runKdfCalibration(double targetMs, const EncryptConfig* config, size_t concurrency) {
+    cout << "正在测量 PBKDF2-HMAC-SHA256 速度..." << endl;
+    KdfBenchmark bench = measureKdf(targetMs);
+    double rate = bench.iterationsPerSecond;
+    cout << "本机单线程: " << (size_t)rate << " 次迭代/s" << endl;
+    cout << "目标单密码派生耗时 " << targetMs << " ms，推荐 kdfIterations: " << bench.recommended
+         << "（当前默认 " << DEFAULT_KDF_ITERATIONS << "，本机耗时 " << formatSeconds(DEFAULT_KDF_ITERATIONS / rate)
+         << "）" << endl;
+    cout << "提示: 读者设备（尤其是手机）通常比构建机器慢，请按最慢的目标设备留出余量" << endl;
+    logToFile("KDF校准: " + std::to_string((size_t)rate) + " 次迭代/s，推荐 " + std::to_string(bench.recommended),
+              LogLevel::INFO);
+
+    if (!config) return;
+    KdfWorkload workload = estimateKdfWorkload(*config);
+    if (workload.articles == 0) {
+        cout << "配置中没有文章，无法估算构建耗时" << endl;
+        return;
+    }
+    // 推荐值下的工作量：按当前配置的总迭代次数等比例换算
+    double currentAverage = workload.iterations / std::max<size_t>(1, workload.derivations);
+    double recommendedTotal = (double)workload.derivations * bench.recommended;
+    size_t threads = std::max<size_t>(1, concurrency);
+
+    cout << "配置: 文章 " << workload.articles << " 篇, 加密规则 " << workload.rules
+         << " 条, 构建时派生 " << workload.derivations << " 次（平均 " << (size_t)currentAverage << " 次迭代）" << endl;
+    cout << "构建派生耗时（" << threads << " 线程）: 当前配置 " << formatSeconds(workload.iterations / rate / threads)
+         << ", 推荐值 " << formatSeconds(recommendedTotal / rate / threads) << endl;
+    cout << "读者解密一个页面（最多 " << workload.maxPagePasswords << " 个密码包装）: 当前配置最多 "
+         << formatSeconds((double)workload.maxPagePasswords * workload.maxPageIterations / rate)
+         << ", 推荐值最多 " << formatSeconds((double)workload.maxPagePasswords * bench.recommended / rate)
+         << "（本机速度）" << endl;
+}
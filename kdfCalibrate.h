@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <cstddef>
+
+#include "encryptConfig.h"
+
+/**
+ * PBKDF2 迭代次数校准（--calibrate-kdf）
+ *
+ * 在当前机器上测量 PKCS5_PBKDF2_HMAC<SHA256> 的速度，按目标的单密码派生耗时推荐迭代次数，
+ * 并按配置中的文章、规则与密码数量估算构建时的派生总耗时和读者解密一个页面的派生耗时。
+ */
+
+/**
+ * 单线程 PBKDF2-HMAC-SHA256 的测量结果
+ */
+struct KdfBenchmark {
+    double iterationsPerSecond = 0;  ///< 每秒迭代次数
+    unsigned int recommended = 0;    ///< 达到目标耗时的迭代次数（取整到1000并限制在允许范围内）
+};
+
+/**
+ * 测量当前机器的 PBKDF2 速度
+ * @param targetMs 单个密码派生的目标耗时（毫秒）
+ * @return 测量结果
+ */
+KdfBenchmark measureKdf(double targetMs);
+
+/**
+ * 按配置估算的密钥派生次数
+ */
+struct KdfWorkload {
+    size_t articles = 0;           ///< 文章数
+    size_t rules = 0;              ///< 所有文章的加密规则数之和（每条规则至少一个加密块）
+    size_t derivations = 0;        ///< 构建时的派生次数（每篇文章每组密码每个密码一次）
+    double iterations = 0;         ///< 构建时的总迭代次数（按每篇文章的迭代次数加权）
+    size_t maxPagePasswords = 0;   ///< 单个加密块最多的密码数（读者最多派生的次数）
+    unsigned int maxPageIterations = 0;  ///< 文章中最大的迭代次数
+};
+
+/**
+ * 按配置估算构建时的密钥派生工作量
+ *
+ * 加密时同一文章中密码相同的块共用一次派生，因此派生次数只取决于每篇文章的密码组合；
+ * 密码来自页面元素的规则按一组额外的密码计（页面中有多个不同密码时实际更多）。
+ */
+KdfWorkload estimateKdfWorkload(const EncryptConfig& config);
+
+/**
+ * 执行校准并输出推荐值与耗时估算
+ * @param targetMs 单个密码派生的目标耗时（毫秒）
+ * @param config 已加载的配置，为 nullptr 时只输出测量结果
+ * @param concurrency 构建时的并发线程数
+ */
+void runKdfCalibration(double targetMs, const EncryptConfig* config, size_t concurrency);
@@ -1,27 +1,108 @@
 ﻿#include <fstream>
 #include <iostream>
 #include <filesystem>
-#include "aceEncrypt.h"
-#include "praseHtml.h"
+#include <chrono>
 #include "tool.h"
 #include "encryptConfig.h"
+#include "articleShard.h"
+#include "encryptDaemon.h"
+#include "kdfCalibrate.h"
+#include "siteJob.h"
 
 using namespace std;
 
-const std::string ENCRYPT_JS = R"(
-<script>
-/**
-* 解密函数
-* @param {*} base64Data base64编码的加密数据
-* @param {*} password 解密密码
-* @returns {Promise<string>} 解密后的明文数据
-*/
-async function encrypt(base64Data,password){if(!base64Data||!password){throw new Error("请填写加密数据和密码");}const encryptedBytes=base64ToArrayBuffer(base64Data);if(encryptedBytes.byteLength<32){throw new Error("加密数据长度不足，无法解密");}const salt=encryptedBytes.slice(0,16);const iv=encryptedBytes.slice(16,32);const ciphertext=encryptedBytes.slice(32);const key=await deriveKeyFromPassword(password,salt);const decrypted=await decryptData(ciphertext,key,iv);return decrypted}async function deriveKeyFromPassword(password,salt){const passwordBuffer=new TextEncoder().encode(password);const passwordKey=await window.crypto.subtle.importKey("raw",passwordBuffer,{name:"PBKDF2"},false,["deriveBits","deriveKey"]);return await window.crypto.subtle.deriveKey({name:"PBKDF2",salt:salt,iterations:10000,hash:"SHA-256",},passwordKey,{name:"AES-CBC",length:256},false,["decrypt"])}async function decryptData(ciphertext,key,iv){try{const decryptedBuffer=await window.crypto.subtle.decrypt({name:"AES-CBC",iv:iv,},key,ciphertext);return new TextDecoder().decode(decryptedBuffer)}catch(error){throw new Error("解密失败: "+error.message);}}function base64ToArrayBuffer(base64){const binaryString=atob(base64);const bytes=new Uint8Array(binaryString.length);for(let i=0;i<binaryString.length;i++){bytes[i]=binaryString.charCodeAt(i)}return bytes.buffer}
-</script>
-)";
-
-EncryptConfig config;  // 全局加密配置对象
-fs::path jsonFilePath, rootDir;  // 配置文件路径、根目录
+// 命令行选项
+struct CliOptions {
+    IoBackend ioBackend = IoBackend::AUTO;  // 批量文件读写后端
+    size_t jobs = 0;  // 并发线程数，0 表示使用硬件线程数
+    bool verifyMode = false;  // --verify：只校验已加密页面，不修改文件
+    bool restoreMode = false;  // --restore：把已加密页面解密还原为明文
+    bool planMode = false;  // --plan：只匹配规则并估算加密开销，输出JSON报告，不修改文件
+    bool keepConfig = false;  // --keep-config：处理完成后不删除配置文件
+    ShardSpec shard;  // --shard i/n：只处理属于当前分片的文章
+    size_t maxMemory = 0;  // --max-memory：同时处理的文章的内存预算（字节），0 表示不限制
+    std::string daemonSocket;  // --daemon：守护进程监听的套接字路径
+    PrecompressOptions precompress;  // --precompress：写出页面时同时生成 .gz/.br
+    double calibrateKdfMs = 0;  // --calibrate-kdf：目标单密码派生耗时（毫秒），0 表示不校准
+};
+
+// --calibrate-kdf 未指定目标耗时时使用的默认值（毫秒）
+static const double DEFAULT_KDF_TARGET_MS = 250;
+
+// 解析以 -- 开头的选项，其余参数按原顺序保留在 args 中
+bool parseOptions(int argc, char* argv[], CliOptions& options, std::vector<char*>& args) {
+    args.push_back(argv[0]);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--io=", 0) == 0) {
+            if (!parseIoBackend(arg.substr(5), options.ioBackend)) {
+                cerr << "错误: 未知的IO后端 " << arg.substr(5) << "，可选 auto|stream|uring" << endl;
+                return false;
+            }
+        } else if (arg.rfind("--jobs=", 0) == 0 || arg == "--jobs" || arg == "-j") {
+            std::string value = arg.rfind("--jobs=", 0) == 0 ? arg.substr(7) : (i + 1 < argc ? argv[++i] : "");
+            try {
+                options.jobs = std::stoul(value);
+            } catch (...) {
+                cerr << "错误: --jobs 需要一个非负整数" << endl;
+                return false;
+            }
+        } else if (arg == "--verify") {
+            options.verifyMode = true;
+        } else if (arg == "--restore") {
+            options.restoreMode = true;
+        } else if (arg == "--plan") {
+            options.planMode = true;
+        } else if (arg == "--keep-config") {
+            options.keepConfig = true;
+        } else if (arg.rfind("--shard=", 0) == 0 || arg == "--shard") {
+            std::string value = arg == "--shard" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(8);
+            if (!parseShardSpec(value, options.shard)) {
+                cerr << "错误: --shard 格式应为 i/n，且 0 <= i < n" << endl;
+                return false;
+            }
+        } else if (arg == "--shard-balance") {
+            options.shard.balanceBySize = true;
+        } else if (arg.rfind("--max-memory=", 0) == 0 || arg == "--max-memory") {
+            std::string value = arg == "--max-memory" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(13);
+            if (!parseMemorySize(value, options.maxMemory)) {
+                cerr << "错误: --max-memory 格式应为数字加可选的 K/M/G 后缀，如 2G" << endl;
+                return false;
+            }
+        } else if (arg.rfind("--daemon=", 0) == 0 || arg == "--daemon") {
+            options.daemonSocket = arg == "--daemon" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(9);
+            if (options.daemonSocket.empty()) {
+                cerr << "错误: --daemon 需要套接字路径" << endl;
+                return false;
+            }
+        } else if (arg.rfind("--precompress=", 0) == 0 || arg == "--precompress") {
+            std::string value = arg == "--precompress" ? "all" : arg.substr(14);
+            if (!parsePrecompress(value, options.precompress)) {
+                cerr << "错误: --precompress 可选 gz、br、gz,br 或 all" << endl;
+                return false;
+            }
+        } else if (arg.rfind("--calibrate-kdf=", 0) == 0 || arg == "--calibrate-kdf") {
+            options.calibrateKdfMs = DEFAULT_KDF_TARGET_MS;
+            if (arg != "--calibrate-kdf") {
+                try {
+                    options.calibrateKdfMs = std::stod(arg.substr(16));
+                } catch (...) {
+                    options.calibrateKdfMs = 0;
+                }
+                if (!(options.calibrateKdfMs > 0)) {
+                    cerr << "错误: --calibrate-kdf 需要一个正数（目标毫秒数）" << endl;
+                    return false;
+                }
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            cerr << "错误: 未知选项 " << arg << endl;
+            return false;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    return true;
+}
 
 // 解析命令行参数，确定配置文件路径和根目录
 bool parseInputPath(int argc, char* argv[], fs::path& jsonFilePath, fs::path& rootDir) {
@@ -47,168 +128,128 @@ bool parseInputPath(int argc, char* argv[], fs::path& jsonFilePath, fs::path& ro
     }
     cerr << "错误: 提供的路径只能是文件夹或*.json文件" << endl;
     logToFile("错误: 提供的路径只能是文件夹或*.json文件", LogLevel::ERROR);
-    cerr << "用法: " << argv[0] << " [文件夹|json文件]" << endl;
+    cerr << "用法: " << argv[0] << " [--io=auto|stream|uring] [--jobs N] [--verify|--restore|--plan] [--shard i/n [--shard-balance]] [--max-memory SIZE] [--precompress[=gz,br]] [--keep-config] [文件夹|json文件]" << endl;
+    cerr << "      " << argv[0] << " --calibrate-kdf[=目标毫秒] [--jobs N] [文件夹|json文件]" << endl;
+    cerr << "      " << argv[0] << " --daemon 套接字路径 [--io=...] [--jobs N] [--max-memory SIZE] [--precompress[=gz,br]]" << endl;
     return false;
 }
 
-string processNode(string defaultPassword,
-                const std::shared_ptr<LexborNode> &node,
-                const EncryptedItem &item,
-                std::shared_ptr<LexborNode> docRoot, 
-                nlohmann::json &result) {
-    
-    string password, encryptedBase64;
-    if (item.password.empty()) {
-        password = defaultPassword;
-    } else {
-        password = node->querySelector(item.password)->getContent();
-        password = trim(password);
-        if (password.empty()) {
-            password = defaultPassword;
-        }
-    }
-    string content = node->getHtml();
-    if (!content.empty()) {
-        string encryptedContent = AesEncrypt(content, password);
-        encryptedBase64 = base64Encode(encryptedContent);
-        logToFile("加密内容: " + item.name + ", 内容(Base64前100): " + encryptedBase64.substr(0, 100), LogLevel::DEBUG);
-    } else {
-        encryptedBase64 = "";
-        logToFile("内容为空无法加密: " + item.name + ", 内容: " + content.substr(0, 100), LogLevel::DEBUG);
-    }
-
-    if (item.replace && item.replace->innerHTML) {
-        // 替换节点内容
-        node->setInnerHtml(item.replace->content);
-        logToFile("InnerHtml替换: " + item.name + ", 内容: " + item.replace->content.substr(0, 100), LogLevel::DEBUG);
-    } else if (item.replace) {
-        // 替换节点外部HTML
-        node->setOuterHtml(item.replace->content);
-        logToFile("OuterHtml替换: " + item.name + ", 内容: " + item.replace->content.substr(0, 100), LogLevel::DEBUG);
-    }
-
-    return encryptedBase64;
-}
+int main(int argc, char *argv[]) {
+    logToFile("##### Hello reimuEncrypt #####", LogLevel::INFO);
 
-// 处理单篇文章
-void processArticle(
-    const ArticleItem &article
-) {
-    // 定义变量保存文章加密结果
-    nlohmann::json result;
+    CliOptions options;
+    std::vector<char*> args;
+    if (!parseOptions(argc, argv, options, args)) return 1;
 
-    fs::path filePath = rootDir / fs::path(article.filePath);
+    // --plan 的JSON报告独占标准输出，其余提示信息改为输出到标准错误
+    std::streambuf* reportBuf = cout.rdbuf();
+    if (options.planMode) cout.rdbuf(cerr.rdbuf());
 
-    // 加载文章
-    auto doc = LexborDocument::fromFile(filePath.string());
-    if (!doc) {
-        std::cout << "打开文件失败: " << filePath.string() << std::endl;
-        return;
+    if (!options.daemonSocket.empty()) {
+        DaemonOptions daemonOptions;
+        daemonOptions.socketPath = options.daemonSocket;
+        daemonOptions.ioBackend = options.ioBackend;
+        daemonOptions.jobs = options.jobs;
+        daemonOptions.maxMemory = options.maxMemory;
+        daemonOptions.precompress = options.precompress;
+        return runDaemon(daemonOptions);
     }
-    auto docRoot = doc->root();
 
-    // 根据配置选取加密配置（整篇/局部）
-    std::vector<EncryptedItem> encrypt;
-    if (article.all) {
-        encrypt = config.encryptedAll;
-    } else {
-        encrypt = config.encryptedPartial;
-    }
+    SiteJob job;
+    job.ioBackend = options.ioBackend;
+    job.precompress = options.precompress;
+    if (!parseInputPath((int)args.size(), args.data(), job.jsonFilePath, job.rootDir)) return 1;
 
-    for (const auto &item : encrypt) {
-        cout << "处理加密配置: name=" << item.name
-             << ", selector=" << item.selector
-             << ", replace=" << (item.replace ? "true" : "false")
-             << ", selectAll=" << (item.selectAll ? "true" : "false")
-             << ", password=" << item.password
-             << endl;
-        logToFile("处理加密配置: name=" + item.name +
-                  ", selector=" + item.selector +
-                  ", replace=" + (item.replace ? "true" : "false") +
-                  ", selectAll=" + (item.selectAll ? "true" : "false") +
-                  ", password=" + item.password, LogLevel::DEBUG);
-        
-        // 设置默认密码
-        string defaultPassword = article.password;
-        if (article.password.empty()) {
-            defaultPassword = config.defaultPassword;
-        }
+    auto configOpt = loadEncryptConfig(job.jsonFilePath.string());
 
-        if (item.selectAll){
-            std::vector<std::shared_ptr<LexborNode>> nodes = docRoot->querySelectorAll(item.selector);
-            for (const std::shared_ptr<LexborNode> &node : nodes) {
-                result[item.name].push_back(processNode(defaultPassword, node, item, docRoot, result));
-            }
-        } else {
-            std::shared_ptr<LexborNode> node = docRoot->querySelector(item.selector);
-            result[item.name] = processNode(defaultPassword, node, item, docRoot, result);
-        }
+    if (options.calibrateKdfMs > 0) {
+        // 校准不修改任何文件，没有配置时只输出测量结果
+        runKdfCalibration(options.calibrateKdfMs, configOpt ? &*configOpt : nullptr,
+                          ThreadPool::defaultConcurrency(options.jobs));
+        logToFile("reimuEncrypt calibrate-kdf exit", LogLevel::INFO);
+        return 0;
     }
 
-    // 写入加密数据到文件
-    auto headNode = docRoot->querySelector("head");
-    if (headNode) {
-        headNode->appendHtml("<script>var __ENCRYPT_DATA__ = " + result.dump() + ";</script>");
-        headNode->appendHtml(ENCRYPT_JS);
-    } else {
-        cerr << "未找到<head>节点，无法写入加密数据。" << endl;
-        logToFile("未找到<head>节点，无法写入加密数据。", LogLevel::ERROR);
-        return;
-    }
-    // 写出文件
-    if (!writeStringToFile(filePath.string(), docRoot->getHtml())) {
-        cerr << "写入文件失败: " << filePath.string() << endl;
-        logToFile("写入文件失败: " + filePath.string(), LogLevel::ERROR);
+    if (configOpt) {
+        job.config = *configOpt;
     } else {
-        cout << "已写入: " << filePath.string() << endl;
-        logToFile("已写入: " + filePath.string(), LogLevel::INFO);
+        cerr << "读取加密配置失败，请检查配置文件格式。" << endl;
+        logToFile("读取加密配置失败，请检查配置文件格式。", LogLevel::ERROR);
+        return 1;
     }
-}
 
-/**
- * 删除加密配置文件
- */
-bool removeEncryptConfigFile(fs::path jsonFilePath) {
-    if (!fs::exists(jsonFilePath)) {
-        cerr << "配置文件不存在: " << jsonFilePath.string() << endl;
-        logToFile("配置文件不存在: " + jsonFilePath.string(), LogLevel::WARN);
-        return false;
-    }
-    try {
-        fs::remove(jsonFilePath);
-        cout << "已删除加密配置文件: " << jsonFilePath.string() << endl;
-        logToFile("已删除加密配置文件: " + jsonFilePath.string(), LogLevel::INFO);
-        return true;
-    } catch (const std::exception &e) {
-        cerr << "删除配置文件失败: " << e.what() << endl;
-        logToFile(std::string("删除配置文件失败: ") + e.what(), LogLevel::ERROR);
-        return false;
-    }
-}
+    cout << "当前使用的JSON配置文件: " << job.jsonFilePath.string() << endl;
+    logToFile(std::string("文件读写后端: ") + ioBackendName(resolveIoBackend(job.ioBackend)), LogLevel::INFO);
 
-int main(int argc, char *argv[]) {
-    logToFile("##### Hello reimuEncrypt #####", LogLevel::INFO);
+    // 主线程也参与执行任务，因此工作线程数为并发数减一
+    size_t concurrency = ThreadPool::defaultConcurrency(options.jobs);
+    ThreadPool pool(concurrency - 1);
+    logToFile("并发线程数: " + std::to_string(concurrency), LogLevel::INFO);
 
-    if (!parseInputPath(argc, argv, jsonFilePath, rootDir)) return 1;
+    // 分片：只保留属于当前分片的文章
+    const ShardSpec &shard = options.shard;
+    std::vector<ArticleItem> articles = job.config.articles;
+    if (shard.enabled()) {
+        articles = selectShard(job.config.articles, shard, job.rootDir);
+        cout << "分片 " << shard.index << "/" << shard.count << ": 处理 " << articles.size()
+             << "/" << job.config.articles.size() << " 篇文章" << endl;
+        logToFile("分片 " + std::to_string(shard.index) + "/" + std::to_string(shard.count) + ": 处理 " +
+                  std::to_string(articles.size()) + "/" + std::to_string(job.config.articles.size()) + " 篇文章",
+                  LogLevel::INFO);
+    }
 
-    auto configOpt = loadEncryptConfig(jsonFilePath.string());
+    if (options.verifyMode) {
+        // 校验模式不修改任何文件，也不删除配置文件
+        KeyCache cache;
+        bool ok = verifyArticles(job, articles, pool, cache);
+        logToFile("reimuEncrypt verify exit", LogLevel::INFO);
+        return ok ? 0 : 2;
+    }
 
-    if (configOpt) {
-        config = *configOpt;
-    } else {
-        cerr << "读取加密配置失败，请检查配置文件格式。" << endl;
-        logToFile("读取加密配置失败，请检查配置文件格式。", LogLevel::ERROR);
-        return 1;
+    if (options.planMode) {
+        // 计划模式不加密、不写出任何文件，也不删除配置文件
+        nlohmann::json report = planArticles(job, articles, pool);
+        cout.rdbuf(reportBuf);
+        cout << report.dump(2) << endl;
+        logToFile("reimuEncrypt plan exit", LogLevel::INFO);
+        return report["summary"]["failed"].get<size_t>() == 0 ? 0 : 2;
     }
 
-    cout << "当前使用的JSON配置文件: " << jsonFilePath.string() << endl;
+    if (options.restoreMode) {
+        // 恢复模式改写页面但保留配置文件，以便换密码后重新加密
+        KeyCache cache;
+        size_t failed = restoreArticles(job, articles, pool, cache);
+        logToFile("reimuEncrypt restore exit", LogLevel::INFO);
+        return failed == 0 ? 0 : 2;
+    }
 
-    // 循环处理Articles
-    for (const auto &article : config.articles) {
-        processArticle(article);
+    // 分批处理Articles
+    if (options.maxMemory > 0) {
+        logToFile("内存预算: " + formatMemorySize(options.maxMemory), LogLevel::INFO);
     }
+    MemoryGovernor governor(options.maxMemory);
+    processArticles(job, articles, pool, governor);
+    // 订阅源与搜索索引覆盖全站，多个分片时只由第 0 个分片清理
+    if (job.config.scrub && (!shard.enabled() || shard.index == 0)) {
+        scrubSiteFiles(job, pool);
+    }
+    cout << "峰值RSS: " << formatMemorySize(peakRssBytes()) << endl;
+    logToFile("峰值RSS: " + formatMemorySize(peakRssBytes()), LogLevel::INFO);
 
-    removeEncryptConfigFile(jsonFilePath);
+    const fs::path &jsonFilePath = job.jsonFilePath;
+    if (options.keepConfig) {
+        logToFile("--keep-config: 保留配置文件 " + jsonFilePath.string(), LogLevel::INFO);
+    } else if (shard.enabled()) {
+        // 多个分片共享同一份配置，只有最后完成的分片删除它
+        if (markShardDone(jsonFilePath, shard)) {
+            removeEncryptConfigFile(jsonFilePath);
+        } else {
+            cout << "其他分片尚未完成，保留配置文件: " << jsonFilePath.string() << endl;
+            logToFile("其他分片尚未完成，保留配置文件: " + jsonFilePath.string(), LogLevel::INFO);
+        }
+    } else {
+        removeEncryptConfigFile(jsonFilePath);
+    }
 
     logToFile("reimuEncrypt success exit", LogLevel::INFO);
 
@@ -0,0 +1,68 @@
+﻿#include "memoryGovernor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+// 峰值内存与文件大小的比例：Lexbor DOM 约为源文件的 4~6 倍，
+// 另有节点快照、密文、base64 和序列化结果各约 1 倍
+static const size_t ESTIMATE_FACTOR = 10;
+// 每篇文章的固定开销（DOM 内存池、选择器引擎、脚本字符串等）
+static const size_t ESTIMATE_BASE = 256 * 1024;
+
+MemoryGovernor::MemoryGovernor(size_t budgetBytes) : budget_(budgetBytes) {}
+
+size_t MemoryGovernor::estimate(size_t fileSize) {
+    return fileSize * ESTIMATE_FACTOR + ESTIMATE_BASE;
+}
+
+bool MemoryGovernor::tryAcquire(size_t bytes, size_t held) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (budget_ == 0 || reserved_ <= held || reserved_ + bytes <= budget_) {
+        reserved_ += bytes;
+        return true;
+    }
+    return false;
+}
+
+void MemoryGovernor::release(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_ -= std::min(bytes, reserved_);
+}
+
+size_t MemoryGovernor::reserved() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserved_;
+}
+
+bool parseMemorySize(const std::string& value, size_t& bytes) {
+    if (value.empty()) return false;
+    const char* begin = value.c_str();
+    char* end = nullptr;
+    double number = std::strtod(begin, &end);
+    if (end == begin || number < 0) return false;
+
+    std::string suffix;
+    for (const char* p = end; *p; ++p) {
+        suffix += (char)std::toupper((unsigned char)*p);
+    }
+    if (suffix.size() > 1 && suffix.back() == 'B') suffix.pop_back();
+    if (suffix.size() > 1 && suffix.back() == 'I') suffix.pop_back();
+
+    double multiplier;
+    if (suffix.empty() || suffix == "B") multiplier = 1;
+    else if (suffix == "K") multiplier = 1024.0;
+    else if (suffix == "M") multiplier = 1024.0 * 1024;
+    else if (suffix == "G") multiplier = 1024.0 * 1024 * 1024;
+    else return false;
+
+    bytes = (size_t)(number * multiplier);
+    return true;
+}
+
+std::string formatMemorySize(size_t bytes) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f MB", bytes / (1024.0 * 1024.0));
+    return buf;
+}
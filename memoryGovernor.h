@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+/**
+ * MemoryGovernor：按内存预算控制同时处理的文章数量
+ *
+ * 每篇文章的峰值内存按文件大小估算（Lexbor DOM、getHtml 快照和
+ * base64 密文同时存在），只有在已预约内存加上新文章的估算值不超过预算时
+ * 才允许开始处理。单篇文章的估算值超过整个预算时，等其他文章全部释放后
+ * 单独处理，而不是永远等待。预约失败时由调用方决定如何腾出预算
+ * （等待已提交的文章完成或写出结果）。
+ */
+class MemoryGovernor {
+public:
+    /**
+     * 构造函数
+     * @param budgetBytes 内存预算（字节），0 表示不限制
+     */
+    explicit MemoryGovernor(size_t budgetBytes);
+
+    /**
+     * 估算处理一篇文章的峰值内存
+     * @param fileSize HTML 文件大小（字节）
+     * @return 估算的字节数
+     */
+    static size_t estimate(size_t fileSize);
+
+    /**
+     * 尝试预约内存
+     *
+     * 不限制预算、预算足够或除调用方自己持有的预约外没有任何预约（超大文章单独处理）时预约成功。
+     *
+     * @param bytes 预约的字节数
+     * @param held 调用方已经持有、且不会因等待而释放的预约字节数
+     * @return 预约成功返回 true
+     */
+    bool tryAcquire(size_t bytes, size_t held = 0);
+
+    /**
+     * 释放之前预约的内存（可以分多次释放）
+     */
+    void release(size_t bytes);
+
+    /**
+     * 当前已预约的字节数
+     */
+    size_t reserved() const;
+
+    size_t budget() const { return budget_; }
+
+private:
+    size_t budget_;
+    size_t reserved_ = 0;
+    mutable std::mutex mutex_;
+};
+
+/**
+ * 解析内存大小，支持 K/M/G 后缀（1024进制，可带 B/iB），如 "2G"、"512M"、"1.5GiB"
+ * @param value 输入字符串
+ * @param bytes 输出字节数
+ * @return 格式正确时返回 true
+ */
+bool parseMemorySize(const std::string& value, size_t& bytes);
+
+/**
+ * 将字节数格式化为便于阅读的字符串，如 "12.3 MB"
+ */
+std::string formatMemorySize(size_t bytes);
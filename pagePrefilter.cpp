@@ -0,0 +1,259 @@
+﻿#include "pagePrefilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define REIMU_PREFILTER_SSE2 1
+#endif
+
+#ifdef __GNUC__
+#define REIMU_CTZ(x) __builtin_ctz(x)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+static inline unsigned reimuCtz(unsigned x) {
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return index;
+}
+#define REIMU_CTZ(x) reimuCtz(x)
+#endif
+
+// 与 encryptCore 写入、encryptVerify 查找的前缀一致
+static const std::string_view ENCRYPT_MARKER = "<script>var __ENCRYPT_DATA__ = ";
+
+static inline unsigned char foldByte(unsigned char c, bool ignoreCase) {
+    return ignoreCase && c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+// 候选位置的完整比较（首尾字节已筛选过）
+static bool matchesAt(const char* p, std::string_view needle, bool ignoreCase) {
+    if (!ignoreCase) return std::memcmp(p, needle.data(), needle.size()) == 0;
+    for (size_t i = 0; i < needle.size(); ++i) {
+        if (foldByte(static_cast<unsigned char>(p[i]), true) != static_cast<unsigned char>(needle[i])) return false;
+    }
+    return true;
+}
+
+size_t findBytes(std::string_view haystack, std::string_view needle, bool ignoreCase) {
+    if (needle.empty()) return 0;
+    if (needle.size() > haystack.size()) return std::string_view::npos;
+
+    const char* data = haystack.data();
+    const size_t last = needle.size() - 1;
+    const size_t limit = haystack.size() - needle.size();  // 最后一个可能的起始位置
+    size_t pos = 0;
+
+#ifdef REIMU_PREFILTER_SSE2
+    // 同时比较16个候选位置的首字节和尾字节，两者都相等的位置再完整比较；
+    // 忽略大小写时把字节的 0x20 位置1后比较（会多出少量候选，由完整比较排除）
+    const char fold = ignoreCase ? 0x20 : 0;
+    const __m128i foldMask = _mm_set1_epi8(fold);
+    const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0] | fold));
+    const __m128i lastByte = _mm_set1_epi8(static_cast<char>(needle[last] | fold));
+    for (; pos + 16 <= limit + 1; pos += 16) {
+        __m128i blockFirst = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), foldMask);
+        __m128i blockLast = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + last)), foldMask);
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(lastByte, blockLast))));
+        while (mask) {
+            unsigned bit = REIMU_CTZ(mask);
+            if (matchesAt(data + pos + bit, needle, ignoreCase)) return pos + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // 剩余部分（或无SIMD时的全部内容）：用 memchr 定位首字节
+    if (!ignoreCase) {
+        while (pos <= limit) {
+            const void* hit = std::memchr(data + pos, needle[0], limit - pos + 1);
+            if (!hit) return std::string_view::npos;
+            pos = static_cast<const char*>(hit) - data;
+            if (matchesAt(data + pos, needle, false)) return pos;
+            ++pos;
+        }
+        return std::string_view::npos;
+    }
+    for (; pos <= limit; ++pos) {
+        if (matchesAt(data + pos, needle, true)) return pos;
+    }
+    return std::string_view::npos;
+}
+
+bool hasEncryptMarker(std::string_view html) {
+    return findBytes(html, ENCRYPT_MARKER) != std::string_view::npos;
+}
+
+// 解析器会在源码中没有对应标签时自动补全的元素，不能要求 "<tag" 出现在源码中
+static const char* const IMPLIED_TAGS[] = {"html", "head", "body", "tbody", "colgroup"};
+
+static bool isIdentChar(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '-' || u == '_' || u >= 0x80;
+}
+
+// 按顶层逗号拆分选择器列表（忽略括号、方括号和引号内的逗号）
+static std::vector<std::string_view> splitSelectorList(std::string_view selector) {
+    std::vector<std::string_view> groups;
+    int depth = 0;
+    char quote = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < selector.size(); ++i) {
+        char c = selector[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '(' || c == '[') {
+            ++depth;
+        } else if (c == ')' || c == ']') {
+            --depth;
+        } else if (c == ',' && depth == 0) {
+            groups.push_back(selector.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    groups.push_back(selector.substr(start));
+    return groups;
+}
+
+/**
+ * 从一个复合选择器列表项中取出必须出现在源码中的字面量
+ *
+ * 只看最右侧的复合选择器（被选中的节点本身），跳过伪类参数和属性选择器的内容；
+ * 优先使用 id，其次最长的 class，最后是标签名。
+ * @return 取不到字面量时返回 false
+ */
+static bool requiredToken(std::string_view group, std::string& token, bool& ignoreCase) {
+    if (group.find('\\') != std::string_view::npos || group.find('|') != std::string_view::npos) {
+        return false;  // 转义与命名空间：字面量可能与源码不一致
+    }
+
+    // 去掉首尾空白
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'; };
+    while (!group.empty() && isSpace(group.front())) group.remove_prefix(1);
+    while (!group.empty() && isSpace(group.back())) group.remove_suffix(1);
+    if (group.empty()) return false;
+
+    // 找到最右侧复合选择器的起点（顶层的空白或组合符之后）
+    int depth = 0;
+    char quote = 0;
+    size_t compound = 0;
+    for (size_t i = 0; i < group.size(); ++i) {
+        char c = group[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '(' || c == '[') {
+            ++depth;
+        } else if (c == ')' || c == ']') {
+            --depth;
+        } else if (depth == 0 && (isSpace(c) || c == '>' || c == '+' || c == '~')) {
+            compound = i + 1;
+        }
+    }
+    std::string_view rest = group.substr(compound);
+
+    std::string id, cls, tag;
+    size_t i = 0;
+    auto readIdent = [&](size_t from) {
+        size_t end = from;
+        while (end < rest.size() && isIdentChar(rest[end])) ++end;
+        return end;
+    };
+    if (i < rest.size() && isIdentChar(rest[i])) {
+        size_t end = readIdent(i);
+        tag.assign(rest.substr(i, end - i));
+        i = end;
+    }
+    while (i < rest.size()) {
+        char c = rest[i];
+        if (c == '#' || c == '.') {
+            size_t end = readIdent(i + 1);
+            std::string name(rest.substr(i + 1, end - i - 1));
+            if (c == '#') {
+                id = name;
+            } else if (name.size() > cls.size()) {
+                cls = name;
+            }
+            i = end;
+        } else if (c == '[' || c == '(') {
+            // 跳过属性选择器与伪类参数
+            char close = c == '[' ? ']' : ')';
+            int nested = 1;
+            char inQuote = 0;
+            ++i;
+            while (i < rest.size() && nested > 0) {
+                char d = rest[i++];
+                if (inQuote) {
+                    if (d == inQuote) inQuote = 0;
+                } else if (d == '"' || d == '\'') {
+                    inQuote = d;
+                } else if (d == c) {
+                    ++nested;
+                } else if (d == close) {
+                    --nested;
+                }
+            }
+        } else if (c == ':') {
+            // 伪类/伪元素名不会出现在源码中
+            while (i < rest.size() && rest[i] == ':') ++i;
+            i = readIdent(i);
+        } else {
+            ++i;
+        }
+    }
+
+    if (!id.empty()) {
+        token = id;
+        ignoreCase = false;
+    } else if (!cls.empty()) {
+        token = cls;
+        ignoreCase = false;
+    } else if (!tag.empty()) {
+        std::transform(tag.begin(), tag.end(), tag.begin(),
+                       [](unsigned char ch) { return static_cast<char>(ch >= 'A' && ch <= 'Z' ? ch | 0x20 : ch); });
+        for (const char* implied : IMPLIED_TAGS) {
+            if (tag == implied) return false;
+        }
+        token = "<" + tag;
+        ignoreCase = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PagePrefilter::PagePrefilter(const std::vector<EncryptedItem>& rules) {
+    for (const auto& rule : rules) {
+        for (std::string_view group : splitSelectorList(rule.selector)) {
+            Token token;
+            if (!requiredToken(group, token.text, token.ignoreCase)) {
+                alwaysProcess_ = true;
+                continue;
+            }
+            bool duplicate = std::any_of(tokens_.begin(), tokens_.end(), [&](const Token& t) {
+                return t.text == token.text && t.ignoreCase == token.ignoreCase;
+            });
+            if (!duplicate) tokens_.push_back(std::move(token));
+        }
+    }
+}
+
+PrefilterResult PagePrefilter::check(std::string_view html) const {
+    if (hasEncryptMarker(html)) {
+        return PrefilterResult::ALREADY_ENCRYPTED;
+    }
+    if (alwaysProcess_) {
+        return PrefilterResult::PROCESS;
+    }
+    for (const auto& token : tokens_) {
+        if (findBytes(html, token.text, token.ignoreCase) != std::string_view::npos) {
+            return PrefilterResult::PROCESS;
+        }
+    }
+    return PrefilterResult::NO_TARGET;
+}
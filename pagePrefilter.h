@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "encryptConfig.h"
+
+/**
+ * 在原始字节中查找子串（SSE2 可用时按16字节一组比较首尾字节筛选候选位置）
+ * @param haystack 被查找的内容
+ * @param needle 要查找的子串，为空时返回 0
+ * @param ignoreCase 是否忽略ASCII大小写（needle 须为小写）
+ * @return 首次出现的位置，未找到返回 std::string_view::npos
+ */
+size_t findBytes(std::string_view haystack, std::string_view needle, bool ignoreCase = false);
+
+/**
+ * 页面是否已经包含本工具写入的 __ENCRYPT_DATA__ 数据（重复运行时已加密的页面）
+ */
+bool hasEncryptMarker(std::string_view html);
+
+/**
+ * 预筛选结果
+ */
+enum class PrefilterResult {
+    PROCESS,            ///< 需要解析并加密
+    ALREADY_ENCRYPTED,  ///< 页面已加密，跳过
+    NO_TARGET,          ///< 页面中不存在任何规则的目标，跳过
+};
+
+/**
+ * PagePrefilter：构建DOM之前按原始字节筛掉无需处理的页面
+ *
+ * 从每条规则的选择器中取出必须在源码中出现的字面量（最右侧复合选择器的
+ * id、class 或标签名），页面中一个都没有出现时说明没有节点能被选中。
+ * 无法确定字面量的选择器（如 *、属性选择器、含转义的选择器）以及只有解析器会自动补全的
+ * 标签名（html、head、body、tbody、colgroup）的选择器会让所有页面都进入解析，
+ * 因此筛选只会漏掉"可以跳过"的页面，不会跳过需要加密的页面。
+ */
+class PagePrefilter {
+public:
+    /**
+     * 构造函数
+     * @param rules 加密规则
+     */
+    explicit PagePrefilter(const std::vector<EncryptedItem>& rules);
+
+    /**
+     * 检查一个页面
+     * @param html 页面原始内容
+     * @return 预筛选结果
+     */
+    PrefilterResult check(std::string_view html) const;
+
+private:
+    struct Token {
+        std::string text;
+        bool ignoreCase = false;  ///< 标签名按 "<tag" 忽略大小写查找
+    };
+    std::vector<Token> tokens_;
+    bool alwaysProcess_ = false;  ///< 存在无法提取字面量的选择器
+};
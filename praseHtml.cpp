@@ -44,98 +44,100 @@ LexborNode::LexborNode(lxb_html_document_t* doc, lxb_dom_node_t* node)
     : document_(doc), node_(node) {}
 LexborNode::~LexborNode() {}
 
-std::shared_ptr<LexborNode> LexborNode::querySelector(const std::string& selector) {
-    // 只返回第一个匹配
-    lxb_status_t status;
-    lxb_css_parser_t* parser = lxb_css_parser_create();
-    lxb_css_parser_init(parser, nullptr);
-    lxb_css_selectors_t* css_selectors = lxb_css_selectors_create();
-    lxb_css_selectors_init(css_selectors);
-    lxb_css_parser_selectors_set(parser, css_selectors);
-    lxb_selectors_t* selectors = lxb_selectors_create();
-    lxb_selectors_init(selectors);
-
-    lxb_css_selector_list_t* list = lxb_css_selectors_parse(
-        parser, (const lxb_char_t*)selector.c_str(), selector.length());
-    if (!list) {
-        lxb_selectors_destroy(selectors, true);
-        lxb_css_selectors_destroy(css_selectors, true);
-        lxb_css_parser_destroy(parser, true);
-        return nullptr;
+/**
+ * 每个线程一份的CSS选择器引擎
+ *
+ * 解析器、选择器匹配器在线程内复用，编译后的选择器列表按字符串缓存，
+ * 常驻线程（线程池工作线程、守护进程）处理后续文档时无需重新编译。
+ */
+class SelectorEngine {
+public:
+    SelectorEngine() {
+        parser_ = lxb_css_parser_create();
+        lxb_css_parser_init(parser_, nullptr);
+        cssSelectors_ = lxb_css_selectors_create();
+        lxb_css_selectors_init(cssSelectors_);
+        lxb_css_parser_selectors_set(parser_, cssSelectors_);
+        selectors_ = lxb_selectors_create();
+        lxb_selectors_init(selectors_);
     }
 
-    lxb_dom_collection_t* collection = lxb_dom_collection_create(lxb_dom_interface_document(document_));
-    lxb_dom_collection_init(collection, 16);
+    ~SelectorEngine() {
+        lxb_selectors_destroy(selectors_, true);
+        lxb_css_selectors_destroy(cssSelectors_, true);
+        lxb_css_parser_destroy(parser_, true);
+    }
 
-    struct CollectNodes {
-        static lxb_status_t callback(lxb_dom_node_t *node, lxb_css_selector_specificity_t, void *ctx) {
-            lxb_dom_collection_t *collection = (lxb_dom_collection_t *)ctx;
-            lxb_dom_collection_append(collection, node);
-            return LXB_STATUS_OK;
-        }
-    };
+    SelectorEngine(const SelectorEngine&) = delete;
+    SelectorEngine& operator=(const SelectorEngine&) = delete;
 
-    status = lxb_selectors_find(selectors, node_, list, CollectNodes::callback, collection);
+    // 查找匹配节点，limit 为 0 时返回全部
+    std::vector<lxb_dom_node_t*> find(lxb_dom_node_t* root, const std::string& selector, size_t limit) {
+        std::vector<lxb_dom_node_t*> nodes;
+        lxb_css_selector_list_t* list = compile(selector);
+        if (!list) return nodes;
 
-    std::shared_ptr<LexborNode> result = nullptr;
-    if (lxb_dom_collection_length(collection) > 0) {
-        lxb_dom_node_t* child = lxb_dom_collection_node(collection, 0);
-        result = std::make_shared<LexborNode>(document_, child);
-    }
+        struct Collector {
+            std::vector<lxb_dom_node_t*>* nodes;
+            size_t limit;
+        } collector{&nodes, limit};
 
-    lxb_dom_collection_destroy(collection, true);
-    lxb_selectors_destroy(selectors, true);
-    lxb_css_selectors_destroy(css_selectors, true);
-    lxb_css_parser_destroy(parser, true);
-    return result;
-}
+        struct CollectNodes {
+            static lxb_status_t callback(lxb_dom_node_t *node, lxb_css_selector_specificity_t, void *ctx) {
+                Collector *collector = (Collector *)ctx;
+                collector->nodes->push_back(node);
+                if (collector->limit && collector->nodes->size() >= collector->limit) {
+                    return LXB_STATUS_STOP;
+                }
+                return LXB_STATUS_OK;
+            }
+        };
 
-std::vector<std::shared_ptr<LexborNode>> LexborNode::querySelectorAll(const std::string& selector) {
-    std::vector<std::shared_ptr<LexborNode>> results;
-    lxb_status_t status;
-    lxb_css_parser_t* parser = lxb_css_parser_create();
-    lxb_css_parser_init(parser, nullptr);
-    lxb_css_selectors_t* css_selectors = lxb_css_selectors_create();
-    lxb_css_selectors_init(css_selectors);
-    lxb_css_parser_selectors_set(parser, css_selectors);
-    lxb_selectors_t* selectors = lxb_selectors_create();
-    lxb_selectors_init(selectors);
-
-    lxb_css_selector_list_t* list = lxb_css_selectors_parse(
-        parser, (const lxb_char_t*)selector.c_str(), selector.length());
-    if (!list) {
-        lxb_selectors_destroy(selectors, true);
-        lxb_css_selectors_destroy(css_selectors, true);
-        lxb_css_parser_destroy(parser, true);
-        return results;
+        lxb_selectors_find(selectors_, root, list, CollectNodes::callback, &collector);
+        return nodes;
     }
 
-    lxb_dom_collection_t* collection = lxb_dom_collection_create(lxb_dom_interface_document(document_));
-    lxb_dom_collection_init(collection, 16);
+private:
+    // 编译后的选择器列表缓存上限，超过后不再缓存新的选择器
+    static const size_t MAX_CACHED_SELECTORS = 1024;
 
-    struct CollectNodes {
-        static lxb_status_t callback(lxb_dom_node_t *node, lxb_css_selector_specificity_t, void *ctx) {
-            lxb_dom_collection_t *collection = (lxb_dom_collection_t *)ctx;
-            lxb_dom_collection_append(collection, node);
-            return LXB_STATUS_OK;
+    lxb_css_selector_list_t* compile(const std::string& selector) {
+        auto it = compiled_.find(selector);
+        if (it != compiled_.end()) return it->second;
+        lxb_css_selector_list_t* list = lxb_css_selectors_parse(
+            parser_, (const lxb_char_t*)selector.c_str(), selector.length());
+        if (compiled_.size() < MAX_CACHED_SELECTORS) {
+            compiled_.emplace(selector, list);
         }
-    };
+        return list;
+    }
 
-    status = lxb_selectors_find(selectors, node_, list, CollectNodes::callback, collection);
+    lxb_css_parser_t* parser_;
+    lxb_css_selectors_t* cssSelectors_;
+    lxb_selectors_t* selectors_;
+    std::unordered_map<std::string, lxb_css_selector_list_t*> compiled_;
+};
 
-    for (size_t i = 0; i < lxb_dom_collection_length(collection); ++i) {
-        lxb_dom_node_t* child = lxb_dom_collection_node(collection, i);
-        results.push_back(std::make_shared<LexborNode>(document_, child));
-    }
+static SelectorEngine& selectorEngine() {
+    thread_local SelectorEngine engine;
+    return engine;
+}
 
-    lxb_dom_collection_destroy(collection, true);
-    lxb_selectors_destroy(selectors, true);
-    lxb_css_selectors_destroy(css_selectors, true);
-    lxb_css_parser_destroy(parser, true);
+std::shared_ptr<LexborNode> LexborNode::querySelector(const std::string& selector) {
+    // 只返回第一个匹配
+    std::vector<lxb_dom_node_t*> nodes = selectorEngine().find(node_, selector, 1);
+    if (nodes.empty()) return nullptr;
+    return std::make_shared<LexborNode>(document_, nodes[0]);
+}
+
+std::vector<std::shared_ptr<LexborNode>> LexborNode::querySelectorAll(const std::string& selector) {
+    std::vector<std::shared_ptr<LexborNode>> results;
+    for (lxb_dom_node_t* node : selectorEngine().find(node_, selector, 0)) {
+        results.push_back(std::make_shared<LexborNode>(document_, node));
+    }
     return results;
 }
 
-// 获取父节点
 std::shared_ptr<LexborNode> LexborNode::parent() {
     if (!node_ || !node_->parent) return nullptr;
     return std::make_shared<LexborNode>(document_, node_->parent);
@@ -212,6 +214,50 @@ void LexborNode::setOuterHtml(const std::string& html) {
     lxb_dom_node_remove(node_);
 }
 
+// 获取片段模板：键为上下文标签、命名空间与片段内容
+lxb_dom_node_t* LexborFragmentCache::get(lxb_html_document_t* doc, lxb_dom_node_t* context, const std::string& html) {
+    std::string key = std::to_string(context->local_name) + ":" + std::to_string(context->ns) + ":" + html;
+    auto it = fragments_.find(key);
+    if (it != fragments_.end()) return it->second;
+    lxb_dom_node_t* fragment = lxb_html_document_parse_fragment(
+        doc, (lxb_dom_element_t*)context, (const lxb_char_t*)html.c_str(), html.length());
+    fragments_.emplace(std::move(key), fragment);
+    return fragment;
+}
+
+// 设置innerHTML（使用片段模板）
+void LexborNode::setInnerHtml(const std::string& html, LexborFragmentCache& cache) {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return;
+    lxb_dom_node_t* fragment = nullptr;
+    if (!html.empty()) {
+        fragment = cache.get(document_, node_, html);
+        if (!fragment) return;
+    }
+    // 旧的子节点只从树中移除，内存随文档释放（其中可能还有其他规则持有的节点）
+    while (node_->first_child) {
+        lxb_dom_node_remove(node_->first_child);
+    }
+    if (!fragment) return;
+    for (lxb_dom_node_t* child = fragment->first_child; child; child = child->next) {
+        lxb_dom_node_t* copy = lxb_dom_node_clone(child, true);
+        if (copy) lxb_dom_node_insert_child(node_, copy);
+    }
+}
+
+// 设置outerHTML（使用片段模板）
+void LexborNode::setOuterHtml(const std::string& html, LexborFragmentCache& cache) {
+    if (!node_ || !node_->parent) return;
+    if (!html.empty()) {
+        lxb_dom_node_t* fragment = cache.get(document_, node_, html);
+        if (!fragment) return;
+        for (lxb_dom_node_t* child = fragment->first_child; child; child = child->next) {
+            lxb_dom_node_t* copy = lxb_dom_node_clone(child, true);
+            if (copy) lxb_dom_node_insert_before(node_, copy);
+        }
+    }
+    lxb_dom_node_remove(node_);
+}
+
 // 替换所有符合条件的子节点
 void LexborNode::replaceAll(const std::string& selector, const std::string& html) {
     auto nodes = this->querySelectorAll(selector);
@@ -288,3 +334,164 @@ void LexborNode::appendHtml(const std::string& html) {
     }
 }
 
+// 在子节点最后追加元素（属性与文本内容不经过解析）
+bool LexborNode::appendElement(const std::string& tag,
+                               const std::vector<std::pair<std::string, std::string>>& attrs,
+                               const std::string& text) {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return false;
+    lxb_dom_document_t* dom = lxb_dom_interface_document(document_);
+    lxb_dom_element_t* element = lxb_dom_document_create_element(
+        dom, (const lxb_char_t*)tag.c_str(), tag.length(), nullptr);
+    if (!element) return false;
+    for (const auto& attr : attrs) {
+        if (!lxb_dom_element_set_attribute(element,
+                (const lxb_char_t*)attr.first.c_str(), attr.first.length(),
+                (const lxb_char_t*)attr.second.c_str(), attr.second.length())) {
+            return false;
+        }
+    }
+    if (!text.empty()) {
+        lxb_dom_text_t* textNode = lxb_dom_document_create_text_node(
+            dom, (const lxb_char_t*)text.data(), text.size());
+        if (!textNode) return false;
+        lxb_dom_node_insert_child(lxb_dom_interface_node(element), lxb_dom_interface_node(textNode));
+    }
+    lxb_dom_node_insert_child(node_, lxb_dom_interface_node(element));
+    return true;
+}
+
+// 创建注释节点，插入位置由调用方决定
+static lxb_dom_node_t* createComment(lxb_html_document_t* document, const std::string& text) {
+    lxb_dom_comment_t* comment = lxb_dom_document_create_comment(
+        lxb_dom_interface_document(document), (const lxb_char_t*)text.data(), text.size());
+    return comment ? lxb_dom_interface_node(comment) : nullptr;
+}
+
+// 注释节点的内容
+static std::string commentText(lxb_dom_node_t* node) {
+    const lexbor_str_t& data = lxb_dom_interface_character_data(node)->data;
+    return data.data ? std::string((const char*)data.data, data.length) : std::string();
+}
+
+bool LexborNode::insertCommentBefore(const std::string& text) {
+    if (!node_ || !node_->parent) return false;
+    lxb_dom_node_t* comment = createComment(document_, text);
+    if (!comment) return false;
+    lxb_dom_node_insert_before(node_, comment);
+    return true;
+}
+
+bool LexborNode::insertCommentAfter(const std::string& text) {
+    if (!node_ || !node_->parent) return false;
+    lxb_dom_node_t* comment = createComment(document_, text);
+    if (!comment) return false;
+    lxb_dom_node_insert_after(node_, comment);
+    return true;
+}
+
+// 按文档顺序查找注释（非递归遍历，避免深层文档栈溢出）
+std::vector<std::pair<std::string, std::shared_ptr<LexborNode>>> LexborNode::findComments(const std::string& prefix) {
+    std::vector<std::pair<std::string, std::shared_ptr<LexborNode>>> result;
+    if (!node_) return result;
+    lxb_dom_node_t* node = node_->first_child;
+    while (node) {
+        if (node->type == LXB_DOM_NODE_TYPE_COMMENT) {
+            std::string text = commentText(node);
+            if (text.compare(0, prefix.size(), prefix) == 0) {
+                result.emplace_back(std::move(text), std::make_shared<LexborNode>(document_, node));
+            }
+        }
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+        while (node != node_ && !node->next) node = node->parent;
+        if (node == node_) break;
+        node = node->next;
+    }
+    return result;
+}
+
+bool LexborNode::replaceThroughComment(const std::string& endComment, const std::string& html) {
+    if (!node_ || !node_->parent || node_->parent->type != LXB_DOM_NODE_TYPE_ELEMENT) return false;
+    lxb_dom_node_t* end = node_->next;
+    while (end && !(end->type == LXB_DOM_NODE_TYPE_COMMENT && commentText(end) == endComment)) {
+        end = end->next;
+    }
+    if (!end) return false;
+    lxb_dom_node_t* fragment = lxb_html_document_parse_fragment(
+        document_, (lxb_dom_element_t*)node_->parent, (const lxb_char_t*)html.c_str(), html.length());
+    if (!fragment) return false;
+    lxb_dom_node_t* child = fragment->first_child;
+    while (child) {
+        lxb_dom_node_t* next = child->next;
+        lxb_dom_node_insert_before(node_, child);
+        child = next;
+    }
+    // 移除起止注释及其间的节点（内存随文档释放）
+    lxb_dom_node_t* node = node_;
+    while (node) {
+        lxb_dom_node_t* next = node == end ? nullptr : node->next;
+        lxb_dom_node_remove(node);
+        node = next;
+    }
+    return true;
+}
+
+std::shared_ptr<LexborNode> LexborNode::nextElementSibling() {
+    if (!node_) return nullptr;
+    for (lxb_dom_node_t* node = node_->next; node; node = node->next) {
+        if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) return std::make_shared<LexborNode>(document_, node);
+    }
+    return nullptr;
+}
+
+void LexborNode::remove() {
+    if (node_ && node_->parent) lxb_dom_node_remove(node_);
+}
+
+std::vector<std::shared_ptr<LexborNode>> LexborNode::elements() {
+    std::vector<std::shared_ptr<LexborNode>> result;
+    if (!node_) return result;
+    lxb_dom_node_t* node = node_;
+    while (node) {
+        if (node->type == LXB_DOM_NODE_TYPE_ELEMENT) result.push_back(std::make_shared<LexborNode>(document_, node));
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+        while (node != node_ && !node->next) node = node->parent;
+        if (node == node_) break;
+        node = node->next;
+    }
+    return result;
+}
+
+std::string LexborNode::tagName() {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return "";
+    size_t length = 0;
+    const lxb_char_t* name = lxb_dom_element_local_name(lxb_dom_interface_element(node_), &length);
+    return name ? std::string((const char*)name, length) : std::string();
+}
+
+std::optional<std::string> LexborNode::getAttribute(const std::string& name) {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return std::nullopt;
+    size_t length = 0;
+    const lxb_char_t* value = lxb_dom_element_get_attribute(
+        lxb_dom_interface_element(node_), (const lxb_char_t*)name.data(), name.size(), &length);
+    if (!value) return std::nullopt;
+    return std::string((const char*)value, length);
+}
+
+bool LexborNode::setAttribute(const std::string& name, const std::string& value) {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return false;
+    return lxb_dom_element_set_attribute(lxb_dom_interface_element(node_),
+                                         (const lxb_char_t*)name.data(), name.size(),
+                                         (const lxb_char_t*)value.data(), value.size()) != nullptr;
+}
+
+bool LexborNode::removeAttribute(const std::string& name) {
+    if (!node_ || node_->type != LXB_DOM_NODE_TYPE_ELEMENT) return false;
+    return lxb_dom_element_remove_attribute(lxb_dom_interface_element(node_),
+                                            (const lxb_char_t*)name.data(), name.size()) == LXB_STATUS_OK;
+}
@@ -5,6 +5,9 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 class LexborNode;
@@ -45,6 +48,28 @@ private:
     lxb_html_document_t* document_; ///< 底层Lexbor HTML文档指针
 };
 
+/**
+ * LexborFragmentCache：HTML片段模板缓存
+ *
+ * 同一文档中相同的片段内容在相同上下文（标签与命名空间）下只解析一次，
+ * 得到的模板子树保存在文档的内存池中，每次使用时深拷贝。
+ * 缓存只能用于同一个文档，且不能比文档存活更久。
+ */
+class LexborFragmentCache {
+public:
+    /**
+     * 获取片段模板，首次使用时解析
+     * @param doc     所属HTML文档指针
+     * @param context 解析片段时的上下文元素
+     * @param html    片段HTML内容
+     * @return 模板片段的根节点（其子节点为片段内容），解析失败返回nullptr
+     */
+    lxb_dom_node_t* get(lxb_html_document_t* doc, lxb_dom_node_t* context, const std::string& html);
+
+private:
+    std::unordered_map<std::string, lxb_dom_node_t*> fragments_;
+};
+
 /**
  * LexborNode：封装单个HTML节点的操作与遍历
  *
@@ -110,6 +135,20 @@ public:
      */
     void setOuterHtml(const std::string& html);
 
+    /**
+     * 设置节点的innerHTML，片段从缓存的模板深拷贝，不重复解析
+     * @param html 新的HTML内容
+     * @param cache 当前文档的片段模板缓存
+     */
+    void setInnerHtml(const std::string& html, LexborFragmentCache& cache);
+
+    /**
+     * 设置节点的outerHTML，片段从缓存的模板深拷贝，不重复解析
+     * @param html 新的HTML内容
+     * @param cache 当前文档的片段模板缓存
+     */
+    void setOuterHtml(const std::string& html, LexborFragmentCache& cache);
+
     /**
      * 批量替换所有匹配selector的子节点
      * @param selector CSS选择器
@@ -141,6 +180,88 @@ public:
      */
     void appendHtml(const std::string& html);
 
+    /**
+     * 在子节点最后追加一个元素，属性与文本内容直接写入文档，不经过HTML片段解析
+     * @param tag 标签名（小写）
+     * @param attrs 属性名与属性值
+     * @param text 元素的文本内容，作为单个文本节点写入（用于<script>/<style>时
+     *             调用方需保证不包含对应的结束标签）
+     * @return 是否追加成功
+     */
+    bool appendElement(const std::string& tag,
+                       const std::vector<std::pair<std::string, std::string>>& attrs,
+                       const std::string& text);
+
+    /**
+     * 在当前节点前插入注释节点，注释内容直接写入文档，不经过HTML片段解析
+     * @param text 注释内容（调用方需保证不包含 "--"）
+     * @return 是否插入成功
+     */
+    bool insertCommentBefore(const std::string& text);
+
+    /**
+     * 在当前节点后插入注释节点
+     * @param text 注释内容（调用方需保证不包含 "--"）
+     * @return 是否插入成功
+     */
+    bool insertCommentAfter(const std::string& text);
+
+    /**
+     * 按文档顺序查找子树中内容以 prefix 开头的注释节点
+     * @param prefix 注释内容前缀
+     * @return 注释内容与注释节点
+     */
+    std::vector<std::pair<std::string, std::shared_ptr<LexborNode>>> findComments(const std::string& prefix);
+
+    /**
+     * 用HTML片段替换从当前节点起、到其后第一个内容为 endComment 的兄弟注释节点为止（含两端）的所有节点
+     * 片段以父元素为上下文解析。
+     * @param endComment 结束注释的内容
+     * @param html 新的HTML内容
+     * @return 找到结束注释并完成替换时返回 true，否则不修改文档
+     */
+    bool replaceThroughComment(const std::string& endComment, const std::string& html);
+
+    /**
+     * 下一个兄弟元素节点（跳过文本与注释）
+     * @return 兄弟元素，没有时返回nullptr
+     */
+    std::shared_ptr<LexborNode> nextElementSibling();
+
+    /**
+     * 将当前节点从文档中移除
+     */
+    void remove();
+
+    /**
+     * 当前节点（为元素时）及其所有后代元素，按文档顺序
+     */
+    std::vector<std::shared_ptr<LexborNode>> elements();
+
+    /**
+     * 元素的标签名（HTML元素为小写），非元素节点返回空字符串
+     */
+    std::string tagName();
+
+    /**
+     * 读取属性
+     * @param name 属性名
+     * @return 属性值，元素没有该属性时返回std::nullopt
+     */
+    std::optional<std::string> getAttribute(const std::string& name);
+
+    /**
+     * 设置属性（已存在时覆盖）
+     * @return 是否设置成功
+     */
+    bool setAttribute(const std::string& name, const std::string& value);
+
+    /**
+     * 删除属性
+     * @return 是否删除成功（属性不存在时也返回 true）
+     */
+    bool removeAttribute(const std::string& name);
+
     /**
      * 获取底层原始节点指针
      * @return lxb_dom_node_t* 指针
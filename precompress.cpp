@@ -0,0 +1,170 @@
+﻿#include "precompress.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "tool.h"
+
+#ifdef REIMU_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef REIMU_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+using namespace std;
+
+bool gzipAvailable() {
+#ifdef REIMU_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool brotliAvailable() {
+#ifdef REIMU_HAVE_BROTLI
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool parsePrecompress(const std::string& value, PrecompressOptions& options) {
+    options = PrecompressOptions();
+    std::stringstream ss(value);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        if (name == "gz" || name == "gzip") {
+            options.gzip = true;
+        } else if (name == "br" || name == "brotli") {
+            options.brotli = true;
+        } else if (name == "all") {
+            options.gzip = gzipAvailable();
+            options.brotli = brotliAvailable();
+            if (!options.enabled()) {
+                cerr << "警告: 当前构建不支持任何预压缩格式（未找到 zlib 与 libbrotlienc）" << endl;
+                logToFile("当前构建不支持任何预压缩格式", LogLevel::WARN);
+            }
+            continue;
+        } else {
+            return false;
+        }
+    }
+    if (options.gzip && !gzipAvailable()) {
+        cerr << "警告: 当前构建不支持 gzip（未找到 zlib），不生成 .gz" << endl;
+        logToFile("当前构建不支持 gzip，不生成 .gz", LogLevel::WARN);
+        options.gzip = false;
+    }
+    if (options.brotli && !brotliAvailable()) {
+        cerr << "警告: 当前构建不支持 brotli（未找到 libbrotlienc），不生成 .br" << endl;
+        logToFile("当前构建不支持 brotli，不生成 .br", LogLevel::WARN);
+        options.brotli = false;
+    }
+    return true;
+}
+
+static size_t totalSize(const std::vector<std::string_view>& parts) {
+    size_t size = 0;
+    for (const auto& part : parts) size += part.size();
+    return size;
+}
+
+std::optional<std::string> gzipCompress(const std::vector<std::string_view>& parts) {
+#ifdef REIMU_HAVE_ZLIB
+    z_stream zs{};
+    // windowBits + 16：输出 gzip 格式的头部与尾部
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::nullopt;
+    }
+    std::string out(deflateBound(&zs, static_cast<uLong>(totalSize(parts))), '\0');
+    size_t produced = 0;
+    int status = Z_OK;
+    // 依次送入每段输入，最后一段使用 Z_FINISH 结束压缩流
+    for (size_t i = 0; i < std::max<size_t>(parts.size(), 1); ++i) {
+        bool last = i + 1 >= parts.size();
+        if (i < parts.size()) {
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(parts[i].data()));
+            zs.avail_in = static_cast<uInt>(parts[i].size());
+        }
+        do {
+            if (produced == out.size()) out.resize(out.size() * 2 + 64);
+            zs.next_out = reinterpret_cast<Bytef*>(&out[produced]);
+            zs.avail_out = static_cast<uInt>(out.size() - produced);
+            status = deflate(&zs, last ? Z_FINISH : Z_NO_FLUSH);
+            produced = out.size() - zs.avail_out;
+            if (status == Z_STREAM_ERROR) {
+                deflateEnd(&zs);
+                return std::nullopt;
+            }
+        } while (zs.avail_out == 0 || (last && status != Z_STREAM_END));
+    }
+    deflateEnd(&zs);
+    out.resize(produced);
+    return out;
+#else
+    (void)parts;
+    return std::nullopt;
+#endif
+}
+
+std::optional<std::string> brotliCompress(const std::vector<std::string_view>& parts) {
+#ifdef REIMU_HAVE_BROTLI
+    BrotliEncoderState* state = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+    if (!state) return std::nullopt;
+    BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, BROTLI_MAX_QUALITY);
+    BrotliEncoderSetParameter(state, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+    size_t size = totalSize(parts);
+    BrotliEncoderSetParameter(state, BROTLI_PARAM_SIZE_HINT, static_cast<uint32_t>(std::min<size_t>(size, 1u << 30)));
+
+    std::string out;
+    bool ok = true;
+    for (size_t i = 0; ok && i < parts.size(); ++i) {
+        bool last = i + 1 == parts.size();
+        BrotliEncoderOperation op = last ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS;
+        size_t availIn = parts[i].size();
+        const uint8_t* nextIn = reinterpret_cast<const uint8_t*>(parts[i].data());
+        do {
+            size_t availOut = 0;
+            if (!BrotliEncoderCompressStream(state, op, &availIn, &nextIn, &availOut, nullptr, nullptr)) {
+                ok = false;
+                break;
+            }
+            size_t taken = 0;
+            const uint8_t* output = BrotliEncoderTakeOutput(state, &taken);
+            if (taken) out.append(reinterpret_cast<const char*>(output), taken);
+        } while (availIn > 0 || BrotliEncoderHasMoreOutput(state) || (last && !BrotliEncoderIsFinished(state)));
+    }
+    BrotliEncoderDestroyInstance(state);
+    if (!ok || parts.empty()) return std::nullopt;
+    return out;
+#else
+    (void)parts;
+    return std::nullopt;
+#endif
+}
+
+std::vector<std::pair<std::string, std::string>> compressedSiblings(const std::string& filePath,
+                                                                    const std::string& content,
+                                                                    const PrecompressOptions& options) {
+    // 与 writeStringToFile 写入的字节一致：UTF-8 BOM + 内容
+    static const std::string_view bom = "\xEF\xBB\xBF";
+    const std::vector<std::string_view> parts{bom, content};
+
+    std::vector<std::pair<std::string, std::string>> siblings;
+    if (options.gzip) {
+        if (auto gz = gzipCompress(parts)) {
+            siblings.emplace_back(filePath + ".gz", std::move(*gz));
+        } else {
+            logToFile("gzip压缩失败: " + filePath, LogLevel::ERROR);
+        }
+    }
+    if (options.brotli) {
+        if (auto br = brotliCompress(parts)) {
+            siblings.emplace_back(filePath + ".br", std::move(*br));
+        } else {
+            logToFile("brotli压缩失败: " + filePath, LogLevel::ERROR);
+        }
+    }
+    return siblings;
+}
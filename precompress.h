@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * 预压缩选项：为每个写出的页面同时生成 .gz / .br 兄弟文件
+ * （供 nginx gzip_static / brotli_static 直接使用）
+ */
+struct PrecompressOptions {
+    bool gzip = false;    ///< 生成 .gz（需要 zlib）
+    bool brotli = false;  ///< 生成 .br（需要 libbrotlienc）
+
+    bool enabled() const { return gzip || brotli; }
+};
+
+/**
+ * 解析预压缩格式列表：gz、br、gz,br；all 表示所有可用格式
+ *
+ * 请求的格式在当前构建中不可用时给出警告并忽略。
+ *
+ * @param value 格式列表
+ * @param options 解析结果
+ * @return 格式名称合法时返回 true
+ */
+bool parsePrecompress(const std::string& value, PrecompressOptions& options);
+
+/**
+ * 当前构建是否支持 gzip / brotli
+ */
+bool gzipAvailable();
+bool brotliAvailable();
+
+/**
+ * gzip 压缩（最高压缩级别）。parts 依次拼接后作为输入，避免为拼接复制内容
+ * @return 压缩结果，不支持或失败时返回 std::nullopt
+ */
+std::optional<std::string> gzipCompress(const std::vector<std::string_view>& parts);
+
+/**
+ * brotli 压缩（质量11，文本模式）
+ * @return 压缩结果，不支持或失败时返回 std::nullopt
+ */
+std::optional<std::string> brotliCompress(const std::vector<std::string_view>& parts);
+
+/**
+ * 为即将写出的页面生成压缩兄弟文件
+ *
+ * 压缩的内容与 writeStringToFile 写入磁盘的字节完全一致（UTF-8 BOM + 内容），
+ * 兄弟文件本身不带 BOM，应使用 writeFilesBatch(..., false) 写出。
+ *
+ * @param filePath 页面路径
+ * @param content 页面内容（不含 BOM）
+ * @param options 预压缩选项
+ * @return (filePath.gz / filePath.br, 压缩数据) 列表，压缩失败的格式会被跳过
+ */
+std::vector<std::pair<std::string, std::string>> compressedSiblings(const std::string& filePath,
+                                                                    const std::string& content,
+                                                                    const PrecompressOptions& options);
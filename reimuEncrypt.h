@@ -0,0 +1,72 @@
+﻿/*
+ * reimuEncrypt C ABI
+ *
+ * 供其他语言/进程内调用的稳定C接口。所有字符串均为UTF-8，
+ * 函数可以在多个线程中同时调用。
+ */
+#pragma once
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(REIMU_SHARED)
+#  ifdef REIMU_BUILDING_LIBRARY
+#    define REIMU_API __declspec(dllexport)
+#  else
+#    define REIMU_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define REIMU_API __attribute__((visibility("default")))
+#else
+#  define REIMU_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** C ABI 版本号，接口发生不兼容变化时递增 */
+#define REIMU_ABI_VERSION 1
+
+/** 返回状态码 */
+typedef enum reimu_status {
+    REIMU_OK = 0,                  /**< 成功 */
+    REIMU_ERR_INVALID_ARGUMENT = 1,/**< 参数为空等非法输入 */
+    REIMU_ERR_INVALID_RULES = 2,   /**< 规则JSON无法解析 */
+    REIMU_ERR_ENCRYPT = 3,         /**< 加密失败（如HTML为空或缺少<head>节点） */
+    REIMU_ERR_INTERNAL = 4         /**< 内部异常 */
+} reimu_status;
+
+/**
+ * 获取库的 ABI 版本号（REIMU_ABI_VERSION）
+ */
+REIMU_API int reimu_abi_version(void);
+
+/**
+ * 按规则加密一段HTML
+ *
+ * @param html HTML内容
+ * @param html_len HTML长度（字节）
+ * @param rules_json 规则JSON数组，格式与 encrypt.json 中 encrypted-all 相同
+ * @param rules_len 规则JSON长度（字节）
+ * @param default_password 默认密码（以\0结尾）
+ * @param out 输出：加密后的HTML，需使用 reimu_free 释放
+ * @param out_len 输出：加密后HTML的长度（字节，不含结尾\0）
+ * @return 状态码，失败时 *out 为 NULL
+ */
+REIMU_API reimu_status reimu_encrypt_html(const char* html, size_t html_len,
+                                          const char* rules_json, size_t rules_len,
+                                          const char* default_password,
+                                          char** out, size_t* out_len);
+
+/**
+ * 释放由本库分配的内存
+ */
+REIMU_API void reimu_free(char* ptr);
+
+/**
+ * 设置日志文件路径，传入 NULL 或空字符串关闭日志（默认写入当前目录 log.txt）
+ */
+REIMU_API void reimu_set_log_file(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+﻿#include <cstdlib>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+#include "reimuEncrypt.h"
+#include "encryptCore.h"
+#include "tool.h"
+
+int reimu_abi_version(void) {
+    return REIMU_ABI_VERSION;
+}
+
+reimu_status reimu_encrypt_html(const char* html, size_t html_len,
+                                const char* rules_json, size_t rules_len,
+                                const char* default_password,
+                                char** out, size_t* out_len) {
+    if (!out || !out_len) return REIMU_ERR_INVALID_ARGUMENT;
+    *out = nullptr;
+    *out_len = 0;
+    if (!html || !rules_json) return REIMU_ERR_INVALID_ARGUMENT;
+
+    // 异常不能跨越C ABI边界，全部在这里转换为状态码
+    try {
+        std::vector<EncryptedItem> rules;
+        nlohmann::json j = nlohmann::json::parse(rules_json, rules_json + rules_len, nullptr, false);
+        if (j.is_discarded() || !j.is_array()) return REIMU_ERR_INVALID_RULES;
+        for (const auto& item : j) {
+            rules.push_back(EncryptedItem::fromJson(item));
+        }
+
+        auto result = encryptHtml(std::string(html, html_len), rules,
+                                  default_password ? default_password : "");
+        if (!result) return REIMU_ERR_ENCRYPT;
+
+        char* buffer = static_cast<char*>(std::malloc(result->size() + 1));
+        if (!buffer) return REIMU_ERR_INTERNAL;
+        std::memcpy(buffer, result->data(), result->size());
+        buffer[result->size()] = '\0';
+        *out = buffer;
+        *out_len = result->size();
+        return REIMU_OK;
+    } catch (const nlohmann::json::exception&) {
+        return REIMU_ERR_INVALID_RULES;
+    } catch (...) {
+        return REIMU_ERR_INTERNAL;
+    }
+}
+
+void reimu_free(char* ptr) {
+    std::free(ptr);
+}
+
+void reimu_set_log_file(const char* path) {
+    setLogFile(path ? path : "");
+}
@@ -0,0 +1,759 @@
+﻿#include "siteJob.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "tool.h"
+#include "assetEncrypt.h"
+#include "encryptCore.h"
+#include "encryptRestore.h"
+#include "encryptVerify.h"
+#include "feedScrub.h"
+#include "pagePrefilter.h"
+
+using namespace std;
+
+// 每批读写的文章数量
+static const size_t ARTICLE_BATCH_SIZE = 64;
+
+// 单篇文章的处理结果及其仍占用的内存预约
+struct ArticleOutput {
+    std::optional<std::string> html;
+    std::vector<std::pair<std::string, std::string>> siblings;  // 预压缩的 .gz/.br 兄弟文件
+    std::vector<std::string> assets;  // 加密块引用的资源标识，页面写出后提交
+    size_t reserved = 0;  // 结果写出前仍保留的预约字节数
+};
+
+// 写出已完成的文章及其预压缩文件，提交写出成功的页面引用的资源，并释放它们的输出结果所占的预约
+static void flushOutputs(const SiteJob &job, std::vector<std::pair<std::string, std::string>> &outputs,
+                         std::vector<std::vector<std::pair<std::string, std::string>>> &siblings,
+                         std::vector<std::vector<std::string>> &assetIds, AssetRegistry *assets,
+                         size_t &outputReserved, size_t &failed, MemoryGovernor &governor) {
+    std::vector<bool> written = writeFilesBatch(outputs, job.ioBackend);
+
+    // 只有写出成功的页面引用的资源会被加密（并删除原文件），失败的页面保持原样，仍引用原文件
+    if (assets) {
+        for (size_t i = 0; i < assetIds.size(); ++i) {
+            if (written[i]) assets->commit(assetIds[i]);
+        }
+    }
+
+    // 页面写出成功后再写出压缩文件（不带BOM），避免压缩文件与页面不一致；
+    // 本次没有生成的格式（未开启预压缩或压缩失败）若存在旧文件则删除，以免服务器返回改写前的内容
+    std::vector<std::pair<std::string, std::string>> compressed;
+    for (size_t i = 0; i < siblings.size(); ++i) {
+        if (!written[i]) continue;
+        for (const char *suffix : {".gz", ".br"}) {
+            std::string stale = outputs[i].first + suffix;
+            bool regenerated = std::any_of(siblings[i].begin(), siblings[i].end(),
+                                           [&](const auto &sibling) { return sibling.first == stale; });
+            std::error_code ec;
+            if (!regenerated && fs::remove(stale, ec)) {
+                logToFile("已删除过期的压缩文件: " + stale, LogLevel::WARN);
+            }
+        }
+        for (auto &sibling : siblings[i]) compressed.push_back(std::move(sibling));
+    }
+    if (!compressed.empty()) {
+        std::vector<bool> compressedWritten = writeFilesBatch(compressed, job.ioBackend, false);
+        for (size_t i = 0; i < compressed.size(); ++i) {
+            if (!compressedWritten[i]) {
+                cerr << "写入压缩文件失败: " << compressed[i].first << endl;
+                logToFile("写入压缩文件失败: " + compressed[i].first, LogLevel::ERROR);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const std::string &filePath = outputs[i].first;
+        if (!written[i]) {
+            ++failed;
+            cerr << "写入文件失败: " << filePath << endl;
+            logToFile("写入文件失败: " + filePath, LogLevel::ERROR);
+            if (job.onResult) job.onResult({filePath, false, "写入文件失败"});
+        } else {
+            cout << "已写入: " << filePath << endl;
+            logToFile("已写入: " + filePath, LogLevel::INFO);
+            if (job.onResult) job.onResult({filePath, true, ""});
+        }
+    }
+    outputs.clear();
+    siblings.clear();
+    assetIds.clear();
+    governor.release(outputReserved);
+    outputReserved = 0;
+}
+
+size_t processArticles(const SiteJob &job, const std::vector<ArticleItem> &articles, ThreadPool &pool,
+                       MemoryGovernor &governor) {
+    size_t failed = 0;
+    // 构建DOM之前按原始字节跳过已加密页面和不含任何规则目标的页面
+    const PagePrefilter allFilter(job.config.encryptedAll);
+    const PagePrefilter partialFilter(job.config.encryptedPartial);
+    size_t alreadyEncrypted = 0, noTarget = 0;
+    // 加密块中引用的本地资源：页面加密时登记，全部页面写出后再加密
+    std::unique_ptr<AssetRegistry> assets;
+    if (job.config.assets) {
+        assets = std::make_unique<AssetRegistry>(job.rootDir, *job.config.assets, job.config.siteSecret);
+    }
+    for (size_t base = 0; base < articles.size(); base += ARTICLE_BATCH_SIZE) {
+        size_t end = std::min(articles.size(), base + ARTICLE_BATCH_SIZE);
+
+        std::vector<std::string> paths;
+        for (size_t i = base; i < end; ++i) {
+            paths.push_back((job.rootDir / fs::path(articles[i].filePath)).string());
+        }
+
+        // 整批文件读入后同时驻留内存：读取前先按文件大小预约，
+        // 每篇文章开始处理时它的份额并入该文章的估算值，跳过的文章直接释放
+        std::vector<size_t> rawShares(end - base, 0);
+        size_t rawHeld = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(paths[i], ec);
+            rawShares[i] = ec ? 0 : (size_t)size;
+            rawHeld += rawShares[i];
+        }
+        while (!governor.tryAcquire(rawHeld)) {
+            if (!pool.runPendingTask()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto releaseRaw = [&](size_t k) {
+            governor.release(rawShares[k]);
+            rawHeld -= rawShares[k];
+            rawShares[k] = 0;
+        };
+        std::vector<std::string> contents = readFilesBatch(paths, job.ioBackend);
+
+        std::vector<std::future<ArticleOutput>> tasks(end - base);
+        std::vector<std::pair<std::string, std::string>> outputs;
+        std::vector<std::vector<std::pair<std::string, std::string>>> siblings;  // 与 outputs 一一对应
+        std::vector<std::vector<std::string>> assetIds;                         // 与 outputs 一一对应
+        size_t outputReserved = 0;
+        size_t collected = 0;  // 已按顺序取回结果的任务数
+
+        // 按提交顺序取回下一个任务的结果
+        auto collectNext = [&]() {
+            auto &task = tasks[collected++];
+            if (!task.valid()) return;
+            ArticleOutput output = pool.wait(task);
+            outputReserved += output.reserved;
+            if (output.html) {
+                outputs.emplace_back(paths[collected - 1], std::move(*output.html));
+                siblings.push_back(std::move(output.siblings));
+                assetIds.push_back(std::move(output.assets));
+            } else {
+                ++failed;
+                if (job.onResult) job.onResult({paths[collected - 1], false, "加密失败"});
+            }
+        };
+
+        // 每篇文章一个任务，文章内的节点加密任务也提交到同一个线程池
+        for (size_t i = base; i < end; ++i) {
+            if (contents[i - base].empty()) {
+                releaseRaw(i - base);
+                ++failed;
+                cerr << "无法读取HTML文件或文件为空: " << paths[i - base] << endl;
+                logToFile("无法读取HTML文件或文件为空: " + paths[i - base], LogLevel::ERROR);
+                std::cout << "打开文件失败: " << paths[i - base] << std::endl;
+                if (job.onResult) job.onResult({paths[i - base], false, "无法读取HTML文件或文件为空"});
+                continue;
+            }
+
+            PrefilterResult filter = (articles[i].all ? allFilter : partialFilter).check(contents[i - base]);
+            if (filter != PrefilterResult::PROCESS) {
+                releaseRaw(i - base);
+                const char *reason = filter == PrefilterResult::ALREADY_ENCRYPTED ? "已加密" : "无匹配节点";
+                ++(filter == PrefilterResult::ALREADY_ENCRYPTED ? alreadyEncrypted : noTarget);
+                logToFile(std::string("跳过(") + reason + "): " + paths[i - base], LogLevel::INFO);
+                if (job.onResult) job.onResult({paths[i - base], true, std::string("跳过: ") + reason});
+                continue;
+            }
+
+            // 内存预算不足时先等待较早提交的文章完成，仍不足则写出已完成的文章；
+            // 预算与其他任务共享时，剩余的预约可能属于其他任务，此时执行自己提交的排队任务或稍候重试
+            // 估算值已包含源文件本身，只需补足读取时预约的份额之外的部分；
+            // 其余文章的读取份额由当前任务持有，不应阻止超大文章单独处理
+            size_t estimate = MemoryGovernor::estimate(contents[i - base].size());
+            size_t share = std::min(rawShares[i - base], estimate);
+            while (!governor.tryAcquire(estimate - share, rawHeld)) {
+                if (collected < i - base) {
+                    collectNext();
+                } else if (!outputs.empty()) {
+                    flushOutputs(job, outputs, siblings, assetIds, assets.get(), outputReserved, failed, governor);
+                } else if (rawHeld > 0) {
+                    // 自己已没有进行中的文章：放弃尚未开始的文章的读取份额，
+                    // 否则共享预算的多个任务会各自持有读取份额而互相等待；这些文章开始时按完整估算值重新预约
+                    for (size_t k = i - base; k < rawShares.size(); ++k) releaseRaw(k);
+                    share = 0;
+                } else if (!pool.runPendingTask()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            // 份额并入估算值：多出估算值的部分（文件大小变化）直接释放
+            governor.release(rawShares[i - base] - share);
+            rawHeld -= rawShares[i - base];
+            rawShares[i - base] = 0;
+
+            tasks[i - base] = pool.submit([&job, &pool, &governor, &assets, estimate, &path = paths[i - base],
+                                           &article = articles[i], html = std::move(contents[i - base])]() {
+                ArticleOutput result;
+                AssetResolver resolver;
+                std::mutex assetsMutex;  // 节点加密任务可能并行调用解析器
+                if (assets) {
+                    resolver = [&assets, &article, &assetsMutex, &ids = result.assets](const std::string &url) {
+                        std::string id;
+                        std::optional<AssetRef> ref = assets->resolve(fs::path(article.filePath), url, &id);
+                        if (ref) {
+                            std::lock_guard<std::mutex> lock(assetsMutex);
+                            ids.push_back(std::move(id));
+                        }
+                        return ref;
+                    };
+                }
+                result.html = processArticle(job.config, article, html, &pool, resolver);
+                size_t outputSize = 0;
+                if (result.html) {
+                    // 序列化结果仍在内存中，直接生成压缩文件，无需之后再读取一遍
+                    if (job.precompress.enabled()) {
+                        result.siblings = compressedSiblings(path, *result.html, job.precompress);
+                    }
+                    outputSize = result.html->size();
+                    for (const auto &sibling : result.siblings) outputSize += sibling.second.size();
+                }
+                // DOM 已释放，只保留输出结果的大小直到写出
+                result.reserved = std::min(outputSize, estimate);
+                governor.release(estimate - result.reserved);
+                logToFile("文章内存: " + path + " 估算 " + formatMemorySize(estimate) + "，完成时RSS " +
+                          formatMemorySize(currentRssBytes()) + "，进程峰值RSS " + formatMemorySize(peakRssBytes()),
+                          LogLevel::INFO);
+                return result;
+            });
+        }
+
+        while (collected < tasks.size()) {
+            collectNext();
+        }
+
+        // 写出文件
+        flushOutputs(job, outputs, siblings, assetIds, assets.get(), outputReserved, failed, governor);
+    }
+    if (alreadyEncrypted || noTarget) {
+        cout << "预筛选跳过: 已加密 " << alreadyEncrypted << " 篇, 无匹配节点 " << noTarget << " 篇" << endl;
+        logToFile("预筛选跳过: 已加密 " + std::to_string(alreadyEncrypted) + " 篇, 无匹配节点 " +
+                  std::to_string(noTarget) + " 篇", LogLevel::INFO);
+    }
+    if (assets && assets->size() > 0) failed += assets->encryptAll(pool);
+    return failed;
+}
+
+bool verifyArticles(const SiteJob &job, const std::vector<ArticleItem> &articles, ThreadPool &pool,
+                    KeyCache &cache) {
+    // 与加密时相同的预筛选：加密时因无匹配节点而跳过的页面没有 __ENCRYPT_DATA__，不算校验失败
+    const PagePrefilter allFilter(job.config.encryptedAll);
+    const PagePrefilter partialFilter(job.config.encryptedPartial);
+    size_t pages = 0, blocks = 0, failed = 0, skipped = 0, noTarget = 0, bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t base = 0; base < articles.size(); base += ARTICLE_BATCH_SIZE) {
+        size_t end = std::min(articles.size(), base + ARTICLE_BATCH_SIZE);
+
+        std::vector<std::string> paths;
+        for (size_t i = base; i < end; ++i) {
+            paths.push_back((job.rootDir / fs::path(articles[i].filePath)).string());
+        }
+        std::vector<std::string> contents = readFilesBatch(paths, job.ioBackend);
+
+        std::vector<bool> unmatched(end - base, false);
+        std::vector<std::future<PageCheck>> tasks(end - base);
+        for (size_t i = base; i < end; ++i) {
+            if (contents[i - base].empty()) continue;
+            if ((articles[i].all ? allFilter : partialFilter).check(contents[i - base]) == PrefilterResult::NO_TARGET) {
+                unmatched[i - base] = true;
+                continue;
+            }
+            tasks[i - base] = pool.submit([&job, &cache, &article = articles[i], html = std::move(contents[i - base])]() {
+                return verifyHtml(html, articleRules(job.config, article), articleDefaultPassword(job.config, article), &cache);
+            });
+        }
+
+        for (size_t i = base; i < end; ++i) {
+            const std::string &filePath = paths[i - base];
+            ++pages;
+            if (unmatched[i - base]) {
+                ++noTarget;
+                logToFile("校验跳过(无匹配节点): " + filePath, LogLevel::INFO);
+                if (job.onResult) job.onResult({filePath, true, "跳过: 无匹配节点"});
+                continue;
+            }
+            if (!tasks[i - base].valid()) {
+                ++failed;
+                cerr << "校验失败: 无法读取HTML文件或文件为空: " << filePath << endl;
+                logToFile("校验失败: 无法读取HTML文件或文件为空: " + filePath, LogLevel::ERROR);
+                if (job.onResult) job.onResult({filePath, false, "无法读取HTML文件或文件为空"});
+                continue;
+            }
+            PageCheck page = pool.wait(tasks[i - base]);
+            FileResult fileResult{filePath, true, ""};
+            if (!page.hasData) {
+                ++failed;
+                cerr << "校验失败: " << filePath << ": 未找到 __ENCRYPT_DATA__" << endl;
+                logToFile("校验失败: " + filePath + ": 未找到 __ENCRYPT_DATA__", LogLevel::ERROR);
+                if (job.onResult) job.onResult({filePath, false, "未找到 __ENCRYPT_DATA__"});
+                continue;
+            }
+            for (const auto &block : page.blocks) {
+                ++blocks;
+                bytes += block.bytes;
+                if (block.ok) continue;
+                std::string where = filePath + " 规则=" + block.name + "[" + std::to_string(block.index) + "]: " + block.message;
+                if (block.skipped) {
+                    ++skipped;
+                    logToFile("校验跳过: " + where, LogLevel::WARN);
+                } else {
+                    ++failed;
+                    cerr << "校验失败: " << where << endl;
+                    logToFile("校验失败: " + where, LogLevel::ERROR);
+                    if (fileResult.ok) {
+                        fileResult.ok = false;
+                        fileResult.message = "规则=" + block.name + "[" + std::to_string(block.index) + "]: " + block.message;
+                    }
+                }
+            }
+            if (job.onResult) job.onResult(fileResult);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds <= 0) seconds = 1e-9;
+    cout << "校验完成: 页面 " << pages << ", 加密块 " << blocks
+         << ", 失败 " << failed << ", 跳过 " << skipped << ", 无匹配节点页面 " << noTarget
+         << ", 耗时 " << seconds << " s"
+         << " (" << pages / seconds << " 页/s, " << bytes / seconds / (1024 * 1024) << " MB/s"
+         << ", 密钥缓存命中 " << cache.hits() << "/" << cache.lookups() << ")" << endl;
+    logToFile("校验完成: 页面 " + std::to_string(pages) + ", 加密块 " + std::to_string(blocks) +
+              ", 失败 " + std::to_string(failed) + ", 跳过 " + std::to_string(skipped) +
+              ", 无匹配节点页面 " + std::to_string(noTarget), LogLevel::INFO);
+    return failed == 0;
+}
+
+// 一条规则在整个站点上的计划合计
+struct RuleTotal {
+    size_t pages = 0;           // 应用了该规则的页面数
+    size_t matchedPages = 0;    // 至少匹配到一个节点的页面数
+    size_t matches = 0;
+    size_t plaintextBytes = 0;
+    size_t payloadBytes = 0;
+    size_t derivations = 0;
+};
+
+nlohmann::json planArticles(const SiteJob &job, const std::vector<ArticleItem> &articles, ThreadPool &pool) {
+    // 与加密时相同的预筛选：会被跳过的页面不解析
+    const PagePrefilter allFilter(job.config.encryptedAll);
+    const PagePrefilter partialFilter(job.config.encryptedPartial);
+    std::vector<RuleTotal> allTotals(job.config.encryptedAll.size());
+    std::vector<RuleTotal> partialTotals(job.config.encryptedPartial.size());
+    size_t pages = 0, planned = 0, failed = 0, alreadyEncrypted = 0, noTarget = 0;
+    size_t inputBytes = 0, outputBytes = 0, plaintextBytes = 0, payloadBytes = 0, matches = 0;
+    size_t derivations = 0;
+    double iterations = 0;
+    nlohmann::json pageReports = nlohmann::json::array();
+    // 输出大小计入资源引用的改写与站点级密钥脚本；资源只检查是否存在，不登记、不读取
+    std::unique_ptr<AssetRegistry> assets;
+    if (job.config.assets) {
+        assets = std::make_unique<AssetRegistry>(job.rootDir, *job.config.assets, job.config.siteSecret);
+    }
+    const SiteKey siteKey = configSiteKey(job.config);
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t base = 0; base < articles.size(); base += ARTICLE_BATCH_SIZE) {
+        size_t end = std::min(articles.size(), base + ARTICLE_BATCH_SIZE);
+
+        std::vector<std::string> paths;
+        for (size_t i = base; i < end; ++i) {
+            paths.push_back((job.rootDir / fs::path(articles[i].filePath)).string());
+        }
+        std::vector<std::string> contents = readFilesBatch(paths, job.ioBackend);
+
+        std::vector<PrefilterResult> filters(end - base, PrefilterResult::PROCESS);
+        std::vector<std::future<HtmlPlan>> tasks(end - base);
+        for (size_t i = base; i < end; ++i) {
+            if (contents[i - base].empty()) continue;
+            filters[i - base] = (articles[i].all ? allFilter : partialFilter).check(contents[i - base]);
+            if (filters[i - base] != PrefilterResult::PROCESS) continue;
+            tasks[i - base] = pool.submit([&job, &assets, &siteKey, &article = articles[i],
+                                           html = std::move(contents[i - base])]() {
+                AssetResolver resolver;
+                if (assets) {
+                    resolver = [&assets, &article](const std::string &url) {
+                        return assets->preview(fs::path(article.filePath), url);
+                    };
+                }
+                return planHtml(html, articleRules(job.config, article), articleDefaultPassword(job.config, article),
+                                articleExtraPasswords(job.config, article), resolver, siteKey);
+            });
+        }
+
+        for (size_t i = base; i < end; ++i) {
+            const ArticleItem &article = articles[i];
+            const std::string &filePath = paths[i - base];
+            nlohmann::json report = {{"path", article.filePath}};
+            ++pages;
+            if (filters[i - base] != PrefilterResult::PROCESS) {
+                bool encrypted = filters[i - base] == PrefilterResult::ALREADY_ENCRYPTED;
+                ++(encrypted ? alreadyEncrypted : noTarget);
+                report["skipped"] = encrypted ? "已加密" : "无匹配节点";
+                pageReports.push_back(std::move(report));
+                if (job.onResult) job.onResult({filePath, true, std::string("跳过: ") + (encrypted ? "已加密" : "无匹配节点")});
+                continue;
+            }
+            std::string error = !tasks[i - base].valid() ? "无法读取HTML文件或文件为空" : "";
+            HtmlPlan plan;
+            if (error.empty()) {
+                plan = pool.wait(tasks[i - base]);
+                if (!plan.ok) error = "HTML文档创建失败或缺少<head>节点";
+            }
+            if (!error.empty()) {
+                ++failed;
+                cerr << "计划失败: " << filePath << ": " << error << endl;
+                logToFile("计划失败: " + filePath + ": " + error, LogLevel::ERROR);
+                report["error"] = error;
+                pageReports.push_back(std::move(report));
+                if (job.onResult) job.onResult({filePath, false, error});
+                continue;
+            }
+
+            ++planned;
+            std::vector<RuleTotal> &totals = article.all ? allTotals : partialTotals;
+            size_t pageDerivations = 0;
+            nlohmann::json ruleReports = nlohmann::json::array();
+            for (size_t r = 0; r < plan.rules.size(); ++r) {
+                const RulePlan &rule = plan.rules[r];
+                RuleTotal &total = totals[r];
+                ++total.pages;
+                if (rule.matches > 0) ++total.matchedPages;
+                total.matches += rule.matches;
+                total.plaintextBytes += rule.plaintextBytes;
+                total.payloadBytes += rule.payloadBytes;
+                total.derivations += rule.derivations;
+                pageDerivations += rule.derivations;
+                matches += rule.matches;
+                plaintextBytes += rule.plaintextBytes;
+                payloadBytes += rule.payloadBytes;
+                ruleReports.push_back({{"name", rule.name},
+                                       {"matches", rule.matches},
+                                       {"plaintextBytes", rule.plaintextBytes},
+                                       {"payloadBytes", rule.payloadBytes}});
+            }
+            unsigned int kdfIterations = articleKdfIterations(job.config, article);
+            derivations += pageDerivations;
+            iterations += (double)pageDerivations * kdfIterations;
+            inputBytes += plan.inputBytes;
+            outputBytes += plan.outputBytes;
+            report["rules"] = std::move(ruleReports);
+            report["inputBytes"] = plan.inputBytes;
+            report["outputBytes"] = plan.outputBytes;
+            report["kdfDerivations"] = pageDerivations;
+            report["kdfIterations"] = kdfIterations;
+            pageReports.push_back(std::move(report));
+            if (job.onResult) job.onResult({filePath, true, ""});
+        }
+    }
+
+    // 规则合计，以及在所有应用了它的页面上都没有匹配到节点的规则
+    nlohmann::json ruleReports = nlohmann::json::array();
+    nlohmann::json unmatched = nlohmann::json::array();
+    auto addRules = [&](const char *set, const std::vector<EncryptedItem> &rules, const std::vector<RuleTotal> &totals) {
+        for (size_t r = 0; r < rules.size(); ++r) {
+            const RuleTotal &total = totals[r];
+            nlohmann::json rule = {{"set", set},
+                                   {"name", rules[r].name},
+                                   {"selector", rules[r].selector},
+                                   {"pages", total.pages},
+                                   {"matchedPages", total.matchedPages},
+                                   {"matches", total.matches},
+                                   {"plaintextBytes", total.plaintextBytes},
+                                   {"payloadBytes", total.payloadBytes},
+                                   {"kdfDerivations", total.derivations}};
+            if (total.matches == 0) unmatched.push_back({{"set", set}, {"name", rules[r].name}, {"pages", total.pages}});
+            ruleReports.push_back(std::move(rule));
+        }
+    };
+    addRules("encrypted-all", job.config.encryptedAll, allTotals);
+    addRules("encrypted-partial", job.config.encryptedPartial, partialTotals);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    nlohmann::json summary = {{"pages", pages},
+                              {"planned", planned},
+                              {"failed", failed},
+                              {"skippedAlreadyEncrypted", alreadyEncrypted},
+                              {"skippedNoTarget", noTarget},
+                              {"matches", matches},
+                              {"plaintextBytes", plaintextBytes},
+                              {"payloadBytes", payloadBytes},
+                              {"inputBytes", inputBytes},
+                              {"outputBytes", outputBytes},
+                              {"growthBytes", (long long)outputBytes - (long long)inputBytes},
+                              {"kdfDerivations", derivations},
+                              {"kdfIterations", iterations},
+                              {"seconds", seconds}};
+    cout << "计划完成: 页面 " << pages << ", 匹配节点 " << matches << ", 明文 " << formatMemorySize(plaintextBytes)
+         << ", 页面增长 " << formatMemorySize(outputBytes > inputBytes ? outputBytes - inputBytes : 0)
+         << ", PBKDF2 " << derivations << " 次, 未匹配规则 " << unmatched.size() << ", 失败 " << failed << endl;
+    logToFile("计划完成: 页面 " + std::to_string(pages) + ", 匹配节点 " + std::to_string(matches) + ", 失败 " +
+              std::to_string(failed), LogLevel::INFO);
+    return {{"summary", std::move(summary)},
+            {"rules", std::move(ruleReports)},
+            {"unmatchedRules", std::move(unmatched)},
+            {"articles", std::move(pageReports)}};
+}
+
+// 单个页面的恢复结果及其预压缩文件
+struct RestoreOutput {
+    bool encrypted = true;  // 页面是否含有加密数据
+    PageRestore page;
+    std::vector<std::pair<std::string, std::string>> siblings;
+};
+
+size_t restoreArticles(const SiteJob &job, const std::vector<ArticleItem> &articles, ThreadPool &pool,
+                       KeyCache &cache) {
+    size_t pages = 0, restored = 0, failed = 0, skipped = 0, blocks = 0;
+    // 恢复按批处理，不预约内存，flushOutputs 只需要一个不限制的预算
+    MemoryGovernor unlimited(0);
+    size_t outputReserved = 0;
+    // 恢复后的页面重新引用原资源：加密时删除了原文件的资源在全部页面写出后解密回原位置
+    AssetRegistry assets(job.rootDir, job.config.assets.value_or(AssetConfig()), job.config.siteSecret);
+    const std::string assetSuffix = job.config.assets ? job.config.assets->suffix : AssetConfig().suffix;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t base = 0; base < articles.size(); base += ARTICLE_BATCH_SIZE) {
+        size_t end = std::min(articles.size(), base + ARTICLE_BATCH_SIZE);
+
+        std::vector<std::string> paths;
+        for (size_t i = base; i < end; ++i) {
+            paths.push_back((job.rootDir / fs::path(articles[i].filePath)).string());
+        }
+        std::vector<std::string> contents = readFilesBatch(paths, job.ioBackend);
+
+        std::vector<std::future<RestoreOutput>> tasks(end - base);
+        for (size_t i = base; i < end; ++i) {
+            if (contents[i - base].empty()) continue;
+            tasks[i - base] = pool.submit([&job, &cache, &assetSuffix, &path = paths[i - base], &article = articles[i],
+                                           html = std::move(contents[i - base])]() {
+                RestoreOutput output;
+                // 不含加密数据的页面（未加密或已恢复）不必解析
+                if (!hasEncryptMarker(html)) {
+                    output.encrypted = false;
+                    return output;
+                }
+                output.page = restoreHtml(html, articleRules(job.config, article),
+                                          articleDefaultPassword(job.config, article), &cache, assetSuffix);
+                if (output.page.html && job.precompress.enabled()) {
+                    output.siblings = compressedSiblings(path, *output.page.html, job.precompress);
+                }
+                return output;
+            });
+        }
+
+        std::vector<std::pair<std::string, std::string>> outputs;
+        std::vector<std::vector<std::pair<std::string, std::string>>> siblings;  // 与 outputs 一一对应
+        for (size_t i = base; i < end; ++i) {
+            const std::string &filePath = paths[i - base];
+            ++pages;
+            if (!tasks[i - base].valid()) {
+                ++failed;
+                cerr << "无法读取HTML文件或文件为空: " << filePath << endl;
+                logToFile("无法读取HTML文件或文件为空: " + filePath, LogLevel::ERROR);
+                if (job.onResult) job.onResult({filePath, false, "无法读取HTML文件或文件为空"});
+                continue;
+            }
+            RestoreOutput output = pool.wait(tasks[i - base]);
+            if (!output.encrypted) {
+                ++skipped;
+                logToFile("跳过(未加密): " + filePath, LogLevel::INFO);
+                if (job.onResult) job.onResult({filePath, true, "跳过: 未加密"});
+                continue;
+            }
+            if (!output.page.html) {
+                ++failed;
+                cerr << "恢复失败: " << filePath << ": " << output.page.message << endl;
+                logToFile("恢复失败: " + filePath + ": " + output.page.message, LogLevel::ERROR);
+                if (job.onResult) job.onResult({filePath, false, output.page.message});
+                continue;
+            }
+            ++restored;
+            blocks += output.page.blocks;
+            for (const auto &ref : output.page.assets) {
+                if (!assets.addRestore(fs::path(articles[i].filePath), ref)) {
+                    logToFile("无法定位加密资源，跳过: " + ref.url + " (" + filePath + ")", LogLevel::WARN);
+                }
+            }
+            outputs.emplace_back(filePath, std::move(*output.page.html));
+            siblings.push_back(std::move(output.siblings));
+        }
+
+        // 写出文件（写出失败计入 failed）
+        // 恢复的资源解密到原位置且保留 .enc 文件，写出失败的页面仍可使用，因此不需要按页面提交
+        size_t writeFailed = 0;
+        std::vector<std::vector<std::string>> noAssets;
+        flushOutputs(job, outputs, siblings, noAssets, nullptr, outputReserved, writeFailed, unlimited);
+        restored -= writeFailed;
+        failed += writeFailed;
+    }
+    if (assets.restoreCount() > 0) failed += assets.decryptAll(pool);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds <= 0) seconds = 1e-9;
+    cout << "恢复完成: 页面 " << pages << ", 已恢复 " << restored << " (加密块 " << blocks << ")"
+         << ", 失败 " << failed << ", 未加密跳过 " << skipped
+         << ", 耗时 " << seconds << " s (" << pages / seconds << " 页/s"
+         << ", 密钥缓存命中 " << cache.hits() << "/" << cache.lookups() << ")" << endl;
+    logToFile("恢复完成: 页面 " + std::to_string(pages) + ", 已恢复 " + std::to_string(restored) +
+              ", 失败 " + std::to_string(failed) + ", 未加密跳过 " + std::to_string(skipped), LogLevel::INFO);
+    return failed;
+}
+
+size_t scrubSiteFiles(const SiteJob &job, ThreadPool &pool) {
+    if (!job.config.scrub) return 0;
+    const ScrubConfig &scrub = *job.config.scrub;
+    const std::vector<ArticleItem> &articles = job.config.articles;
+    // 站点子路径：链接只在去掉这一前缀后与文章路径比较，不任意去掉路径段
+    std::string basePath;
+    if (scrub.basePath) {
+        basePath = *scrub.basePath;
+    } else {
+        for (const auto &file : scrub.files) {
+            const fs::path path = job.rootDir / fs::path(file.path);
+            if (path.extension() != ".xml") continue;
+            std::ifstream in(path, std::ios::binary);
+            if (in.is_open()) basePath = scrubFeedBasePath(in);
+            if (!basePath.empty()) {
+                logToFile("从订阅源 " + path.string() + " 推断站点子路径: /" + basePath, LogLevel::INFO);
+                break;
+            }
+        }
+    }
+    const ScrubMatcher matcher(articles, basePath);
+
+    // encrypt 操作：每篇文章一个加密器（与页面相同的密码与迭代次数），在所有文件之间共享
+    std::mutex encryptorsMutex;
+    std::map<size_t, std::shared_ptr<const AesEncryptor>> encryptors;
+    auto encryptField = [&](size_t index, const std::string &text) {
+        if (text.compare(0, SCRUB_ENCRYPTED_PREFIX.size(), SCRUB_ENCRYPTED_PREFIX) == 0) return text;
+        std::shared_ptr<const AesEncryptor> encryptor;
+        {
+            std::lock_guard<std::mutex> lock(encryptorsMutex);
+            auto it = encryptors.find(index);
+            if (it != encryptors.end()) encryptor = it->second;
+        }
+        if (!encryptor) {
+            const ArticleItem &article = articles[index];
+            std::vector<std::string> passwords{articleDefaultPassword(job.config, article)};
+            for (const auto &password : articleExtraPasswords(job.config, article)) {
+                if (!password.empty() && std::find(passwords.begin(), passwords.end(), password) == passwords.end()) {
+                    passwords.push_back(password);
+                }
+            }
+            encryptor = std::make_shared<const AesEncryptor>(passwords, articleDeterministicKey(job.config, article),
+                                                             articleKdfIterations(job.config, article),
+                                                             configSiteKey(job.config).salt);
+            std::lock_guard<std::mutex> lock(encryptorsMutex);
+            encryptor = encryptors.emplace(index, encryptor).first->second;
+        }
+        std::string encrypted = encryptor->encryptBase64(text.data(), text.size());
+        // 加密失败时退回占位文本，不写回明文
+        return encrypted.empty() ? scrub.placeholder : SCRUB_ENCRYPTED_PREFIX + encrypted;
+    };
+
+    // 每个文件一个任务：流式读取原文件，写入临时文件后替换
+    std::vector<std::future<std::string>> tasks;
+    for (const auto &file : scrub.files) {
+        tasks.push_back(pool.submit([&job, &scrub, &matcher, &encryptField, &file]() -> std::string {
+            const fs::path path = job.rootDir / fs::path(file.path);
+            const std::string action = file.action.empty() ? scrub.action : file.action;
+            const std::string extension = path.extension().string();
+            if (extension != ".xml" && extension != ".json") return "不支持的文件类型（只支持 .xml 与 .json）";
+
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open()) return "无法打开文件";
+            const fs::path tempPath = path.string() + ".scrub.tmp";
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return "无法创建临时文件";
+
+            ScrubRules rules;
+            rules.remove = action == "remove";
+            rules.fields = scrub.fields;
+            rules.linkKeys = scrub.linkKeys;
+            if (action == "encrypt") {
+                rules.replace = encryptField;
+            } else {
+                rules.replace = [&scrub](size_t, const std::string &) { return scrub.placeholder; };
+            }
+            ScrubStats stats;
+            std::string error;
+            bool ok = extension == ".xml" ? scrubXmlStream(in, out, matcher, rules, stats, error)
+                                          : scrubJsonStream(in, out, matcher, rules, stats, error);
+            in.close();
+            out.close();
+            std::error_code ec;
+            if (ok && out.fail()) {
+                ok = false;
+                error = "写出失败";
+            }
+            if (ok) fs::rename(tempPath, path, ec);
+            if (!ok || ec) {
+                fs::remove(tempPath, ec);
+                return ok ? "替换原文件失败" : error;
+            }
+
+            // 预压缩的兄弟文件仍是旧内容，删除以免泄露明文
+            for (const char *suffix : {".gz", ".br"}) {
+                fs::path sibling = path.string() + suffix;
+                if (fs::remove(sibling, ec)) {
+                    logToFile("已删除过期的压缩文件: " + sibling.string(), LogLevel::WARN);
+                }
+            }
+            std::string summary = path.string() + " (" + action + ", 条目 " + std::to_string(stats.records) +
+                                  ", 加密文章 " + std::to_string(stats.matched) + ", 删除 " +
+                                  std::to_string(stats.removed) + ", 改写字段 " + std::to_string(stats.fields) + ")";
+            cout << "已清理: " << summary << endl;
+            logToFile("已清理: " + summary, LogLevel::INFO);
+            return "";
+        }));
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        std::string error = pool.wait(tasks[i]);
+        if (error.empty()) continue;
+        ++failed;
+        std::string filePath = (job.rootDir / fs::path(scrub.files[i].path)).string();
+        cerr << "清理失败: " << filePath << ": " << error << endl;
+        logToFile("清理失败: " + filePath + ": " + error, LogLevel::ERROR);
+    }
+    return failed;
+}
+
+bool removeEncryptConfigFile(const fs::path &jsonFilePath) {
+    if (!fs::exists(jsonFilePath)) {
+        cerr << "配置文件不存在: " << jsonFilePath.string() << endl;
+        logToFile("配置文件不存在: " + jsonFilePath.string(), LogLevel::WARN);
+        return false;
+    }
+    try {
+        fs::remove(jsonFilePath);
+        cout << "已删除加密配置文件: " << jsonFilePath.string() << endl;
+        logToFile("已删除加密配置文件: " + jsonFilePath.string(), LogLevel::INFO);
+        return true;
+    } catch (const std::exception &e) {
+        cerr << "删除配置文件失败: " << e.what() << endl;
+        logToFile(std::string("删除配置文件失败: ") + e.what(), LogLevel::ERROR);
+        return false;
+    }
+}
@@ -0,0 +1,99 @@
+﻿#pragma once
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "aceEncrypt.h"
+#include "batchIO.h"
+#include "encryptConfig.h"
+#include "memoryGovernor.h"
+#include "precompress.h"
+#include "threadPool.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * 单个文件的处理结果，用于逐个回传（守护进程）
+ */
+struct FileResult {
+    std::string path;     ///< 文件完整路径
+    bool ok = false;      ///< 是否加密并写出成功 / 校验通过
+    std::string message;  ///< 失败原因
+};
+
+/**
+ * SiteJob：一次加密或校验任务的上下文
+ *
+ * 任务所需的配置、路径和IO后端都在这里，不依赖全局变量，
+ * 多个任务可以同时在同一个线程池上运行。
+ */
+struct SiteJob {
+    EncryptConfig config;
+    fs::path jsonFilePath;                  ///< 配置文件路径
+    fs::path rootDir;                       ///< 文章路径相对的根目录
+    IoBackend ioBackend = IoBackend::AUTO;  ///< 批量文件读写后端
+    PrecompressOptions precompress;         ///< 写出页面时同时生成的 .gz/.br 兄弟文件
+    std::function<void(const FileResult&)> onResult;  ///< 可选：每个文件完成后回调（在调用线程中执行）
+};
+
+/**
+ * 批量处理文章：批量读取 -> 并行加密（及预压缩） -> 批量写出
+ *
+ * 配置了 assets 时，加密块中引用的本地资源在页面加密时登记，全部页面写出后并行分块加密（见 assetEncrypt.h）。
+ *
+ * @param job 任务上下文
+ * @param articles 要处理的文章
+ * @param pool 线程池
+ * @param governor 内存预算（可以在多个任务之间共享）
+ * @return 失败的文章数与资源数之和
+ */
+size_t processArticles(const SiteJob& job, const std::vector<ArticleItem>& articles, ThreadPool& pool,
+                       MemoryGovernor& governor);
+
+/**
+ * 校验模式：并行读取已加密页面，用配置中的密码解密每个加密块并检查结果
+ * @param cache 派生密钥缓存（可以在多个任务之间共享）
+ * @return 全部通过返回 true
+ */
+bool verifyArticles(const SiteJob& job, const std::vector<ArticleItem>& articles, ThreadPool& pool,
+                    KeyCache& cache);
+
+/**
+ * 计划模式（--plan）：并行解析页面，只做规则匹配与明文测量，不加密、不写出任何文件
+ *
+ * 报告包含 summary（合计：匹配节点数、明文与密文字节数、页面增长、PBKDF2 次数与总迭代次数）、
+ * rules（每条规则在全站的合计）、unmatchedRules（在全站没有匹配到任何节点的规则）
+ * 与 articles（每个页面每条规则的匹配数与字节数）。与加密时一样，预筛选会跳过的页面不解析。
+ *
+ * @return JSON 报告
+ */
+nlohmann::json planArticles(const SiteJob& job, const std::vector<ArticleItem>& articles, ThreadPool& pool);
+
+/**
+ * 恢复模式：并行解密已加密页面中的全部块，把原节点放回并移除注入的脚本后改写文件
+ *
+ * 不含加密数据的页面跳过；任一块无法解密或定位的页面保持不变并计为失败。
+ * 配置了预压缩时同时重新生成 .gz/.br 兄弟文件。
+ *
+ * @param cache 派生密钥缓存（可以在多个任务之间共享）
+ * @return 失败的文章数
+ */
+size_t restoreArticles(const SiteJob& job, const std::vector<ArticleItem>& articles, ThreadPool& pool,
+                       KeyCache& cache);
+
+/**
+ * 按配置中的 scrub 清理订阅源、站点地图与搜索索引中属于加密文章的条目
+ *
+ * 每个文件一个任务并行处理，文件内流式读写（见 feedScrub.h），结果写入临时文件后替换原文件；
+ * 同名的 .gz/.br 兄弟文件仍是旧内容，一并删除。匹配使用配置中的全部文章（不受分片影响）。
+ *
+ * @return 失败的文件数
+ */
+size_t scrubSiteFiles(const SiteJob& job, ThreadPool& pool);
+
+/**
+ * 删除加密配置文件
+ */
+bool removeEncryptConfigFile(const fs::path& jsonFilePath);
@@ -0,0 +1,143 @@
+﻿#include "threadPool.h"
+
+#include <atomic>
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    // 没有工作线程时，剩余任务在析构线程中执行，保证所有 future 都能就绪
+    while (runPendingTask()) {}
+}
+
+size_t ThreadPool::defaultConcurrency(size_t jobs) {
+    if (jobs > 0) return jobs;
+    size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// 任务与线程的标识从1开始递增（0 表示"任意组"）；线程在第一次提交或等待时取得标识
+static std::atomic<uint64_t> nextId{1};
+static thread_local uint64_t currentGroup = 0;
+
+static uint64_t currentGroupId() {
+    if (currentGroup == 0) currentGroup = nextId.fetch_add(1, std::memory_order_relaxed);
+    return currentGroup;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    auto entry = std::make_shared<Task>();
+    entry->run = std::move(task);
+    entry->id = nextId.fetch_add(1, std::memory_order_relaxed);
+    entry->group = currentGroupId();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(entry);
+        groups_[entry->group].push_back(std::move(entry));
+        ++pending_;
+        // 提交者可能正阻塞在 wait 中（例如子任务又提交了同组任务）
+        if (waiters_ > 0) waitCv_.notify_all();
+    }
+    cv_.notify_one();
+}
+
+ThreadPool::TaskPtr ThreadPool::takeTask(uint64_t group) {
+    TaskPtr task;
+    if (group == 0) {
+        while (!tasks_.empty() && !task) {
+            if (!tasks_.front()->taken) task = tasks_.front();
+            tasks_.pop_front();
+        }
+        if (!task) return nullptr;
+        // 同组更早提交的任务都已取出，该任务位于组队列的开头
+        auto it = groups_.find(task->group);
+        while (!it->second.empty() && (it->second.front() == task || it->second.front()->taken)) {
+            it->second.pop_front();
+        }
+        if (it->second.empty()) groups_.erase(it);
+    } else {
+        auto it = groups_.find(group);
+        if (it == groups_.end()) return nullptr;
+        while (!it->second.empty() && !task) {
+            if (!it->second.back()->taken) task = it->second.back();
+            it->second.pop_back();
+        }
+        if (it->second.empty()) groups_.erase(it);
+        if (!task) return nullptr;
+        // 全局队列中的条目由工作线程取到时移除
+        while (!tasks_.empty() && tasks_.front()->taken) tasks_.pop_front();
+    }
+    task->taken = true;
+    --pending_;
+    return task;
+}
+
+ThreadPool::TaskPtr ThreadPool::takeOwnTask() {
+    TaskPtr task = takeTask(currentGroupId());
+    // 没有工作线程时其他任务只能由当前线程执行，自己的任务执行完后不限于自己提交的任务
+    if (!task && workers_.empty()) task = takeTask(0);
+    return task;
+}
+
+void ThreadPool::runTask(Task& task) {
+    uint64_t saved = currentGroup;
+    currentGroup = task.id;
+    std::function<void()> run = std::move(task.run);
+    run();
+    currentGroup = saved;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (waiters_ > 0) waitCv_.notify_all();
+}
+
+bool ThreadPool::runPendingTask() {
+    TaskPtr task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task = takeOwnTask();
+    }
+    if (!task) return false;
+    runTask(*task);
+    return true;
+}
+
+void ThreadPool::waitUntil(const std::function<bool()>& ready) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!ready()) {
+        if (TaskPtr task = takeOwnTask()) {
+            // 等待中的线程取自己最新提交的任务，通常是它刚提交的子任务
+            lock.unlock();
+            runTask(*task);
+            lock.lock();
+            continue;
+        }
+        // 结果由其他线程完成：任务结束或有新的同组任务提交时被唤醒
+        ++waiters_;
+        waitCv_.wait(lock);
+        --waiters_;
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        TaskPtr task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (pending_ == 0) return;
+            task = takeTask(0);
+        }
+        runTask(*task);
+    }
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ThreadPool：简单的任务线程池
+ *
+ * 支持在任务内部再次提交子任务（文章任务中提交节点加密任务）。
+ * 每个任务属于提交它的任务（在任务之外提交时属于提交线程），通过 wait 等待结果的线程
+ * 在等待期间只执行属于自己的排队任务，因此嵌套提交不会因为工作线程全部阻塞而死锁，
+ * 文章任务也不会在等待节点任务时嵌套执行其他文章；没有属于自己的任务时阻塞在条件变量上。
+ * 工作线程数为 0 时，所有任务都在调用 wait 的线程中执行。
+ */
+class ThreadPool {
+public:
+    /**
+     * 构造函数
+     * @param threads 工作线程数量（不含调用 wait 的线程）
+     */
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * 析构函数：执行完队列中剩余的任务后结束所有工作线程
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * 提交任务
+     * @param f 无参可调用对象
+     * @return 任务结果的 future（任务抛出的异常会在 get 时重新抛出）
+     */
+    template <typename F>
+    auto submit(F&& f) -> std::future<decltype(f())> {
+        using R = decltype(f());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> future = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    /**
+     * 等待任务完成并返回结果，等待期间在当前线程执行属于当前任务（或线程）的排队任务
+     */
+    template <typename T>
+    T wait(std::future<T>& future) {
+        waitUntil([&future] { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+        return future.get();
+    }
+
+    /**
+     * 在当前线程执行一个属于当前任务（或线程）的排队任务（优先执行最近提交的任务）
+     * @return 没有这样的任务时返回 false
+     */
+    bool runPendingTask();
+
+    /**
+     * 工作线程数量
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * 根据 --jobs 参数计算并发度，0 表示使用硬件线程数
+     */
+    static size_t defaultConcurrency(size_t jobs);
+
+private:
+    struct Task {
+        std::function<void()> run;
+        uint64_t id = 0;
+        uint64_t group = 0;   ///< 提交者：提交时正在执行的任务，任务之外为提交线程
+        bool taken = false;
+    };
+    using TaskPtr = std::shared_ptr<Task>;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+    // 阻塞直到 ready() 为 true，期间执行属于当前任务（或线程）的排队任务
+    void waitUntil(const std::function<bool()>& ready);
+    // 在持有锁时取出一个任务：group 为 0 时取最早提交的任意任务，否则取该组最近提交的任务
+    TaskPtr takeTask(uint64_t group);
+    // 在持有锁时取出属于当前任务（或线程）的任务
+    TaskPtr takeOwnTask();
+    // 执行任务并在结束后唤醒等待者
+    void runTask(Task& task);
+
+    std::vector<std::thread> workers_;
+    std::deque<TaskPtr> tasks_;                               ///< 全部任务，按提交顺序（已取出的延迟移除）
+    std::unordered_map<uint64_t, std::deque<TaskPtr>> groups_;  ///< 按提交者分组的排队任务
+    size_t pending_ = 0;                                      ///< 尚未取出的任务数
+    size_t waiters_ = 0;                                      ///< 阻塞在 waitCv_ 上的线程数
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable waitCv_;
+    bool stop_ = false;
+};
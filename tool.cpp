@@ -5,11 +5,18 @@
 #include <ctime>
 #include <sstream>
 #include <iostream>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
 #ifdef _WIN32
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <psapi.h>
 #undef ERROR
+#else
+#include <sys/resource.h>
 #endif
 
 using namespace std;
@@ -24,12 +31,29 @@ static const char* levelToStr(LogLevel level) {
     }
 }
 
+static std::mutex logMutex;
+static std::string logFilePath = "log.txt";
+
+void setLogFile(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    logFilePath = filePath;
+}
+
 void logToFile(const std::string& msg, LogLevel level) {
-    std::ofstream logFile("log.txt", std::ios::app);
+    // 多线程/库调用时串行化写入，避免日志行交错
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (logFilePath.empty()) return;
+    std::ofstream logFile(logFilePath, std::ios::app);
     if (!logFile.is_open()) return;
     auto now = std::chrono::system_clock::now();
     std::time_t t = std::chrono::system_clock::to_time_t(now);
-    logFile << "[" << std::put_time(std::localtime(&t), "%Y-%m-%d %H:%M:%S") << "]";
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    logFile << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "]";
     logFile << "[" << levelToStr(level) << "] ";
     logFile << msg << std::endl;
 }
@@ -45,6 +69,38 @@ std::string base64Encode(const std::string& input) {
     return encoded;
 }
 
+char* base64EncodeTo(const void* data, size_t size, char* out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const unsigned char* in = (const unsigned char*)data;
+    size_t full = size / 3 * 3;
+    for (size_t i = 0; i < full; i += 3) {
+        uint32_t n = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+        *out++ = alphabet[n >> 18];
+        *out++ = alphabet[(n >> 12) & 63];
+        *out++ = alphabet[(n >> 6) & 63];
+        *out++ = alphabet[n & 63];
+    }
+    if (size > full) {
+        uint32_t n = (uint32_t)in[full] << 16 | (size - full == 2 ? (uint32_t)in[full + 1] << 8 : 0);
+        *out++ = alphabet[n >> 18];
+        *out++ = alphabet[(n >> 12) & 63];
+        *out++ = size - full == 2 ? alphabet[(n >> 6) & 63] : '=';
+        *out++ = '=';
+    }
+    return out;
+}
+
+std::string base64Decode(const std::string& input) {
+    std::string decoded;
+    CryptoPP::StringSource ss(
+        input, true,
+        new CryptoPP::Base64Decoder(
+            new CryptoPP::StringSink(decoded)
+        )
+    );
+    return decoded;
+}
+
 // 读取整个文件内容到字符串（支持Windows下UTF-8路径）
 std::string readFileToString(const std::string& filePath, const std::string& encoding) {
     std::string content;
@@ -84,7 +140,7 @@ std::string readFileToString(const std::string& filePath, const std::string& enc
 }
 
 // 将字符串内容写入文件（支持Windows下UTF-8路径）
-bool writeStringToFile(const std::string& filePath, const std::string& content) {
+bool writeStringToFile(const std::string& filePath, const std::string& content, bool withBom) {
 #ifdef _WIN32
     int wlen = MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, NULL, 0);
     if (wlen <= 0) {
@@ -102,8 +158,10 @@ bool writeStringToFile(const std::string& filePath, const std::string& content)
         return false;
     }
     // 写入UTF-8 BOM
-    const unsigned char bom[] = {0xEF, 0xBB, 0xBF};
-    file.write(reinterpret_cast<const char*>(bom), 3);
+    if (withBom) {
+        const unsigned char bom[] = {0xEF, 0xBB, 0xBF};
+        file.write(reinterpret_cast<const char*>(bom), 3);
+    }
     file << content;
     return file.good();
 }
@@ -201,4 +259,55 @@ std::string decodeUrl(const std::string& str) {
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+#if defined(__linux__)
+// 读取 /proc/self/status 中的字段（单位kB），如 "VmRSS:"、"VmHWM:"
+static size_t readProcStatusKb(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t len = strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, len, field) == 0) {
+            return std::strtoull(line.c_str() + len, nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+size_t currentRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    return readProcStatusKb("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+size_t peakRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+#if defined(__linux__)
+    size_t hwm = readProcStatusKb("VmHWM:");
+    if (hwm > 0) return hwm;
+#endif
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;  // macOS 单位为字节
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // 其他平台单位为kB
+#endif
+#endif
+}
@@ -22,9 +22,40 @@ enum class LogLevel {
  */
 void logToFile(const std::string& msg, LogLevel level = LogLevel::INFO);
 
+/**
+ * 设置日志文件路径（默认为当前目录下的 log.txt）
+ *
+ * @param filePath 日志文件路径，为空时关闭日志
+ */
+void setLogFile(const std::string& filePath);
+
 
 std::string base64Encode(const std::string& input);
 
+/**
+ * Base64编码后的精确字节数（带填充）
+ */
+inline size_t base64EncodedSize(size_t size) { return (size + 2) / 3 * 4; }
+
+/**
+ * Base64编码到调用方提供的缓冲区（与 base64Encode 结果相同，不分配内存）
+ *
+ * 分段编码时，除最后一段外每段的长度都必须是3的倍数，否则中间会出现填充。
+ *
+ * @param data 输入数据
+ * @param size 输入字节数
+ * @param out 输出缓冲区，至少 base64EncodedSize(size) 字节
+ * @return 输出末尾之后的位置
+ */
+char* base64EncodeTo(const void* data, size_t size, char* out);
+
+/**
+ * Base64解码
+ * @param input Base64字符串
+ * @return 解码后的二进制数据，非法字符会被忽略
+ */
+std::string base64Decode(const std::string& input);
+
 
 /**
  * 读取整个文件内容到字符串
@@ -40,9 +71,10 @@ std::string readFileToString(const std::string& filePath, const std::string& enc
  * 
  * @param filePath 文件路径
  * @param content 要写入的内容
+ * @param withBom 是否在开头写入UTF-8 BOM（压缩文件等二进制内容传 false）
  * @return 操作是否成功
  */
-bool writeStringToFile(const std::string& filePath, const std::string& content);
+bool writeStringToFile(const std::string& filePath, const std::string& content, bool withBom = true);
 
 /**
  * 将字符串进行UTF-8编码的修剪，去除首尾空白字符
@@ -58,3 +90,15 @@ std::string trim(const std::string& str);
  * @return 解码后的URL字符串
  */
 std::string decodeUrl(const std::string& str);
+
+/**
+ * 当前进程的常驻内存（RSS）
+ * @return 字节数，平台不支持时返回 0
+ */
+size_t currentRssBytes();
+
+/**
+ * 当前进程运行以来的峰值常驻内存（峰值RSS）
+ * @return 字节数，平台不支持时返回 0
+ */
+size_t peakRssBytes();